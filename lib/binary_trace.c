@@ -0,0 +1,368 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "trace.h"
+#include "compress.h"
+#include "binary_trace.h"
+
+#define FLAG_WRITE			(1 << 0)
+#define FLAG_NEW_PAGE		(1 << 1)
+#define SIZE_CLASS_SHIFT	2
+#define SIZE_CLASS_MASK		(7 << SIZE_CLASS_SHIFT)
+#define MAX_ENTRY_BYTES		21		/* Flags & two 10 byte varints */
+
+/*================================= ENCODING ===================================*/
+static inline char* write_varint (char* out, ullong_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		*out++ = (char) (value | 0x80);
+
+	*out++ = (char) value;
+
+	return out;
+}
+
+/* NULL on a varint running past the end of the block */
+static inline const char* read_varint (const char* in, const char* end, ullong_t* value)
+{
+	*value = 0;
+
+	for (int shift = 0; in < end && shift < 64; shift += 7)
+	{
+		uchar_t byte = (uchar_t) *in++;
+
+		*value |= (ullong_t) (byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+			return in;
+	}
+
+	return NULL;
+}
+
+/* 0 => Unknown, k => 2^(k - 1) bytes, up to 64 */
+static uchar_t size_class (uint_t size)
+{
+	uchar_t class = 0;
+
+	if (size == 0)
+		return 0;
+
+	while (class < 6 && (1U << class) < size)
+		class++;
+
+	return class + 1;
+}
+
+/*================================== WRITING ===================================*/
+binary_trace_writer_t* create_binary_trace_writer (const char* file_path, uint_t block_entries)
+{
+	FILE *fp = fopen(file_path, "wb");
+
+	if (fp == NULL)
+	{
+		printf("%s - Failed To Create Trace File: %s\n", ERROR_PRINT_TAG, file_path);
+		return NULL;
+	}
+
+	binary_trace_writer_t* writer = calloc(1, sizeof(binary_trace_writer_t));
+	writer->fp 						= fp;
+	writer->encoded 				= malloc(block_entries * MAX_ENTRY_BYTES);
+	writer->stored 					= malloc(block_entries * MAX_ENTRY_BYTES);
+	writer->block_capacity 			= 64;
+	writer->block_offsets 			= malloc(writer->block_capacity * sizeof(ullong_t));
+
+	memcpy(writer->header.magic, TRACE_MAGIC, sizeof(writer->header.magic));
+	writer->header.version 			= TRACE_FORMAT_VERSION;
+	writer->header.header_size 		= sizeof(binary_trace_header_t);
+	writer->header.page_shift 		= TRACE_PAGE_SHIFT;
+	writer->header.block_entries 	= block_entries;
+
+	/* Rewritten with the totals once the trace is closed */
+	fwrite(&writer->header, sizeof(binary_trace_header_t), 1, fp);
+
+	return writer;
+}
+
+static int flush_block (binary_trace_writer_t* writer)
+{
+	binary_trace_header_t* header = &writer->header;
+	binary_trace_block_t block = { 0 };
+
+	block.entry_count 		= writer->block_entry_count;
+	block.encoded_length 	= writer->encoded_length;
+	block.first_page 		= writer->first_page;
+	block.stored_length 	= lz_compress(writer->encoded, writer->encoded_length, writer->stored, writer->encoded_length - 1);
+
+	/* Didn't shrink, the block is stored as it is */
+	char* data = writer->stored;
+
+	if (block.stored_length == 0)
+	{
+		block.stored_length = block.encoded_length;
+		data = writer->encoded;
+	}
+
+	if (header->block_count == writer->block_capacity)
+	{
+		writer->block_capacity *= 2;
+		writer->block_offsets = realloc(writer->block_offsets, writer->block_capacity * sizeof(ullong_t));
+	}
+
+	writer->block_offsets[header->block_count++] = ftello(writer->fp);
+
+	fwrite(&block, sizeof(binary_trace_block_t), 1, writer->fp);
+	fwrite(data, 1, block.stored_length, writer->fp);
+
+	header->encoded_bytes 		+= block.encoded_length;
+	header->stored_bytes 		+= sizeof(binary_trace_block_t) + block.stored_length;
+	writer->block_entry_count 	= 0;
+	writer->encoded_length 		= 0;
+
+	return ferror(writer->fp) ? -1 : 0;
+}
+
+int binary_trace_append (binary_trace_writer_t* writer, vaddr_t address, uchar_t is_write, uint_t size)
+{
+	binary_trace_header_t* header = &writer->header;
+	ullong_t page = address >> header->page_shift;
+	ullong_t offset = address & ((1ULL << header->page_shift) - 1);
+
+	/* Every block starts from its own first page, so it decodes without the ones before it */
+	if (writer->block_entry_count == 0)
+	{
+		writer->first_page = page;
+		writer->last_page = page;
+	}
+
+	char* out = &writer->encoded[writer->encoded_length];
+	uchar_t flags = (is_write ? FLAG_WRITE : 0) | (size_class(size) << SIZE_CLASS_SHIFT);
+
+	if (page != writer->last_page)
+		flags |= FLAG_NEW_PAGE;
+
+	*out++ = (char) flags;
+
+	/* Zigzag: Small steps either way stay small */
+	if (page != writer->last_page)
+	{
+		long long delta = (long long) (page - writer->last_page);
+
+		out = write_varint(out, ((ullong_t) delta << 1) ^ (ullong_t) (delta >> 63));
+	}
+
+	out = write_varint(out, offset);
+
+	writer->encoded_length 	= out - writer->encoded;
+	writer->last_page 		= page;
+	writer->block_entry_count++;
+	header->entry_count++;
+	header->write_count += is_write ? 1 : 0;
+
+	if (address > header->max_address)
+		header->max_address = address;
+
+	if (writer->block_entry_count == header->block_entries)
+		return flush_block(writer);
+
+	return 0;
+}
+
+/* Last block, the index & the final header, 0 once it's all on disk */
+int close_binary_trace_writer (binary_trace_writer_t* writer)
+{
+	binary_trace_header_t* header = &writer->header;
+	int result = 0;
+
+	if (writer->block_entry_count > 0)
+		result = flush_block(writer);
+
+	header->index_offset = ftello(writer->fp);
+	fwrite(writer->block_offsets, sizeof(ullong_t), header->block_count, writer->fp);
+
+	fseeko(writer->fp, 0, SEEK_SET);
+	fwrite(header, sizeof(binary_trace_header_t), 1, writer->fp);
+
+	if (ferror(writer->fp))
+		result = -1;
+
+	if (fclose(writer->fp) != 0)
+		result = -1;
+
+	free(writer->encoded);
+	free(writer->stored);
+	free(writer->block_offsets);
+	free(writer);
+
+	return result;
+}
+
+/*================================== READING ===================================*/
+int is_binary_trace_file (const char* file_path)
+{
+	char magic[8];
+	FILE *fp = fopen(file_path, "rb");
+
+	if (fp == NULL)
+		return 0;
+
+	int matches = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+
+	fclose(fp);
+
+	return matches;
+}
+
+binary_trace_t* open_binary_trace (const char* file_path)
+{
+	FILE *fp = fopen(file_path, "rb");
+
+	if (fp == NULL)
+	{
+		printf("%s - Failed To Open Trace File...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	binary_trace_t* trace = calloc(1, sizeof(binary_trace_t));
+	binary_trace_header_t* header = &trace->header;
+
+	trace->fp = fp;
+	trace->path = strdup(file_path);
+
+	if (fread(header, sizeof(binary_trace_header_t), 1, fp) != 1
+		|| memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != (uint_t) TRACE_FORMAT_VERSION || header->header_size != sizeof(binary_trace_header_t))
+	{
+		printf("%s - Not A Version %d Binary Trace: %s\n", ERROR_PRINT_TAG, TRACE_FORMAT_VERSION, file_path);
+		free_binary_trace(trace);
+		return NULL;
+	}
+
+	if (header->block_entries == 0 || header->page_shift >= 64
+		|| header->block_count != (header->entry_count + header->block_entries - 1) / header->block_entries)
+	{
+		printf("%s - Malformed Binary Trace Header: %s\n", ERROR_PRINT_TAG, file_path);
+		free_binary_trace(trace);
+		return NULL;
+	}
+
+	trace->block_offsets = malloc((header->block_count + 1) * sizeof(ullong_t));
+
+	if (fseeko(fp, header->index_offset, SEEK_SET) != 0
+		|| fread(trace->block_offsets, sizeof(ullong_t), header->block_count, fp) != header->block_count)
+	{
+		printf("%s - Binary Trace Index Is Truncated: %s\n", ERROR_PRINT_TAG, file_path);
+		free_binary_trace(trace);
+		return NULL;
+	}
+
+	return trace;
+}
+
+void free_binary_trace (binary_trace_t* trace)
+{
+	if (!trace)
+		return;
+
+	fclose(trace->fp);
+	free(trace->path);
+	free(trace->block_offsets);
+	free(trace->stored);
+	free(trace->encoded);
+	free(trace);
+}
+
+/* Hot loop: A flag byte & one or two varints per access, no text to parse */
+static int decode_block (binary_trace_block_t* block, const char* in, ullong_t page_shift, trace_entry_t* entries)
+{
+	const char* end = in + block->encoded_length;
+	ullong_t page = block->first_page;
+
+	for (uint_t i = 0; i < block->entry_count; ++i)
+	{
+		ullong_t value;
+
+		if (in >= end)
+			return -1;
+
+		uchar_t flags = (uchar_t) *in++;
+
+		if ((flags & FLAG_NEW_PAGE) != 0)
+		{
+			if (!(in = read_varint(in, end, &value)))
+				return -1;
+
+			page += (value & 1) ? ~(value >> 1) : (value >> 1);
+		}
+
+		if (!(in = read_varint(in, end, &value)))
+			return -1;
+
+		entries[i].address 	= (page << page_shift) | value;
+		entries[i].is_write = flags & FLAG_WRITE;
+	}
+
+	return 0;
+}
+
+/* Decodes one block into entries [header.block_entries of room], 0 if it's malformed */
+unsigned long binary_trace_read_block (binary_trace_t* trace, ullong_t block_index, trace_entry_t* entries)
+{
+	binary_trace_header_t* header = &trace->header;
+	binary_trace_block_t block;
+
+	if (block_index >= header->block_count || fseeko(trace->fp, trace->block_offsets[block_index], SEEK_SET) != 0
+		|| fread(&block, sizeof(binary_trace_block_t), 1, trace->fp) != 1
+		|| block.entry_count == 0 || block.entry_count > header->block_entries
+		|| block.encoded_length > header->block_entries * MAX_ENTRY_BYTES || block.stored_length > block.encoded_length)
+	{
+		printf("%s - Malformed Binary Trace Block %'llu...\n", ERROR_PRINT_TAG, block_index);
+		return 0;
+	}
+
+	/* Both buffers only ever grow to the largest block */
+	if (block.encoded_length > trace->buffer_size)
+	{
+		trace->buffer_size 	= block.encoded_length;
+		trace->stored 		= realloc(trace->stored, trace->buffer_size);
+		trace->encoded 		= realloc(trace->encoded, trace->buffer_size);
+	}
+
+	const char* in = trace->encoded;
+
+	if (fread(trace->stored, 1, block.stored_length, trace->fp) != block.stored_length)
+	{
+		printf("%s - Binary Trace Block %'llu Is Truncated...\n", ERROR_PRINT_TAG, block_index);
+		return 0;
+	}
+
+	if (block.stored_length == block.encoded_length)
+		in = trace->stored;
+	else if (lz_decompress(trace->stored, block.stored_length, trace->encoded, block.encoded_length) < 0)
+	{
+		printf("%s - Binary Trace Block %'llu Fails To Decompress...\n", ERROR_PRINT_TAG, block_index);
+		return 0;
+	}
+
+	if (decode_block(&block, in, header->page_shift, entries) < 0)
+	{
+		printf("%s - Binary Trace Block %'llu Is Malformed...\n", ERROR_PRINT_TAG, block_index);
+		return 0;
+	}
+
+	return block.entry_count;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_binary_trace_header (binary_trace_header_t* header)
+{
+	double stored = header->stored_bytes ? (double) header->stored_bytes : 1.0;
+
+	printf("Accesses:\t\t%'llu (%'llu writes)\n", header->entry_count, header->write_count);
+	printf("Blocks:\t\t\t%'llu (%'u accesses each)\n", header->block_count, header->block_entries);
+	printf("Highest Address:\t0x%llX\n", header->max_address);
+	printf("Encoded Size:\t\t%'llu (bytes, %.2f per access)\n", header->encoded_bytes, header->entry_count ? (double) header->encoded_bytes / header->entry_count : 0.0);
+	printf("Stored Size:\t\t%'llu (bytes, %.2f per access, %.2fx smaller)\n", header->stored_bytes, header->entry_count ? stored / header->entry_count : 0.0, header->encoded_bytes / stored);
+}
@@ -0,0 +1,88 @@
+#ifndef BINARYTRACEH
+#define BINARYTRACEH
+
+#include <stdio.h>
+#include "utils.h"
+#include "trace.h"
+
+/*
+    Compact binary trace, written once & replayed in blocks:
+
+    [Header][Block][Block] ... [Block index]
+
+    Every block holds TRACE_BLOCK_ENTRIES accesses [the last one what's
+    left] & decodes on its own, so any block can be read through the index
+    without the ones before it. An access is a flag byte [write bit, size
+    class & whether the page changed], the zigzag varint distance to the
+    previous page if it did & the varint offset into the page. Pages are
+    TRACE_PAGE_SHIFT bits whatever the simulated page size. Encoded blocks
+    are LZ compressed when that makes them smaller. Integers in headers are
+    stored in host byte order.
+*/
+typedef struct binary_trace_header
+{
+    char        magic[8];               /* TRACE_MAGIC */
+    uint_t      version;                /* TRACE_FORMAT_VERSION */
+    uint_t      header_size;            /* sizeof(binary_trace_header_t) */
+    uint_t      page_shift;
+    uint_t      block_entries;          /* Accesses per block, all but the last are full */
+    ullong_t    entry_count;
+    ullong_t    write_count;
+    ullong_t    block_count;
+    ullong_t    index_offset;           /* File offset of block_count block offsets */
+    ullong_t    max_address;            /* Highest address, checked against the virtual address width once */
+    ullong_t    encoded_bytes;          /* Blocks before & after compression */
+    ullong_t    stored_bytes;
+} binary_trace_header_t;
+
+typedef struct binary_trace_block
+{
+    uint_t      entry_count;
+    uint_t      encoded_length;
+    uint_t      stored_length;          /* == encoded_length => Stored uncompressed */
+    uint_t      reserved;
+    ullong_t    first_page;             /* Page the first access' distance is taken from */
+} binary_trace_block_t;
+
+/* A binary trace open for reading, one block in memory at a time */
+typedef struct binary_trace
+{
+    FILE*       fp;
+    char*       path;                   /* Every process replaying the file opens its own reader */
+    binary_trace_header_t header;
+    ullong_t*   block_offsets;
+    char*       stored;                 /* Block as read from the file */
+    char*       encoded;                /* Block after decompression */
+    ullong_t    buffer_size;
+} binary_trace_t;
+
+/* A binary trace being written, accesses are buffered until their block is full */
+typedef struct binary_trace_writer
+{
+    FILE*       fp;
+    binary_trace_header_t header;
+    ullong_t*   block_offsets;
+    ullong_t    block_capacity;
+    char*       encoded;
+    char*       stored;
+    ullong_t    encoded_length;
+    uint_t      block_entry_count;
+    ullong_t    first_page;
+    ullong_t    last_page;
+} binary_trace_writer_t;
+
+// Writing
+binary_trace_writer_t* create_binary_trace_writer (const char* file_path, uint_t block_entries);
+int binary_trace_append (binary_trace_writer_t* writer, vaddr_t address, uchar_t is_write, uint_t size);
+int close_binary_trace_writer (binary_trace_writer_t* writer);
+
+// Reading
+int is_binary_trace_file (const char* file_path);
+binary_trace_t* open_binary_trace (const char* file_path);
+void free_binary_trace (binary_trace_t* trace);
+unsigned long binary_trace_read_block (binary_trace_t* trace, ullong_t block, trace_entry_t* entries);
+
+// Debugging
+void print_binary_trace_header (binary_trace_header_t* header);
+
+#endif
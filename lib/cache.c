@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "cache.h"
+
+#define CACHE_INVALID_TAG	(~0ULL)
+
+static const char* INCLUSION_NAMES[] = { "inclusive", "exclusive", "nine" };
+static const char* WRITE_POLICY_NAMES[] = { "write-back", "write-through" };
+
+/*=============================== INITIALIZATION ===============================*/
+void init_cache_config (cache_config_t* config)
+{
+	memset(config, 0, sizeof(cache_config_t));
+
+	config->line_size 		= CACHE_LINE_SIZE;
+	config->inclusion 		= CACHE_INCLUSIVE;
+	config->write_policy 	= CACHE_WRITE_BACK;
+	config->memory_latency 	= MEMORY_LATENCY;
+}
+
+/* Levels left out above the last one given take their defaults, all of them if none was */
+static void default_levels (cache_config_t* config)
+{
+	if (config->level_count == 0)
+		config->level_count = CACHE_MAX_LEVELS;
+
+	for (int i = 0; i < config->level_count; ++i)
+	{
+		if (config->levels[i].size != 0)
+			continue;
+
+		config->levels[i].size 		= CACHE_DEFAULT_SIZES[i];
+		config->levels[i].ways 		= CACHE_DEFAULT_WAYS[i];
+		config->levels[i].latency 	= CACHE_DEFAULT_LATENCIES[i];
+	}
+}
+
+/* <size>[:ways[:cycles]], the level's defaults fill in the rest */
+static int parse_level (char* value, int index, cache_level_config_t* level)
+{
+	char* ways = strchr(value, ':');
+	char* latency = NULL;
+
+	if (ways)
+	{
+		*ways++ = '\0';
+		latency = strchr(ways, ':');
+
+		if (latency)
+			*latency++ = '\0';
+	}
+
+	level->size 	= parse_size(value);
+	level->ways 	= ways ? atoi(ways) : CACHE_DEFAULT_WAYS[index];
+	level->latency 	= latency ? atoi(latency) : CACHE_DEFAULT_LATENCIES[index];
+
+	return (level->size == 0 || level->ways <= 0 || level->latency < 0) ? -1 : 0;
+}
+
+static int parse_name (const char* value, const char** names, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (strcmp(value, names[i]) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/* l1=<size>[:ways[:cycles]],l2=..,l3=..,line=<bytes>,inclusion=<name>,write=back|through,memory=<cycles>,uncached=<first>-<end> */
+int parse_cache_config (const char* spec, cache_config_t* config)
+{
+	char* buffer = strdup(spec);
+	char* save;
+
+	for (char* option = strtok_r(buffer, ",", &save); option; option = strtok_r(NULL, ",", &save))
+	{
+		char* value = strchr(option, '=');
+		int result = 0;
+
+		if (!value)
+		{
+			printf("%s - Cache Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if ((option[0] == 'l' || option[0] == 'L') && option[1] >= '1' && option[1] <= '0' + CACHE_MAX_LEVELS && option[2] == '\0')
+		{
+			int index = option[1] - '1';
+
+			result = parse_level(value, index, &config->levels[index]);
+
+			if (index + 1 > config->level_count)
+				config->level_count = index + 1;
+		}
+		else if (strcmp(option, "line") == 0)
+			config->line_size = parse_size(value);
+		else if (strcmp(option, "inclusion") == 0)
+			result = config->inclusion = parse_name(value, INCLUSION_NAMES, 3);
+		else if (strcmp(option, "write") == 0)
+			result = config->write_policy = (strcmp(value, "back") == 0) ? CACHE_WRITE_BACK : (strcmp(value, "through") == 0) ? CACHE_WRITE_THROUGH : -1;
+		else if (strcmp(option, "memory") == 0)
+			config->memory_latency = atoi(value);
+		else if (strcmp(option, "uncached") == 0)
+		{
+			char* end;
+
+			config->uncached_first = strtoull(value, &end, 16);
+			config->uncached_end = (*end == '-') ? strtoull(end + 1, NULL, 16) : 0;
+			result = (config->uncached_end > config->uncached_first) ? 0 : -1;
+		}
+		else
+		{
+			printf("%s - Unknown Cache Option: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		if (result < 0)
+		{
+			printf("%s - Invalid Cache Option: %s=%s\n", ERROR_PRINT_TAG, option, value);
+			free(buffer);
+			return -1;
+		}
+	}
+
+	free(buffer);
+
+	default_levels(config);
+
+	if (config->line_size == 0 || (config->line_size & (config->line_size - 1)) != 0)
+	{
+		printf("%s - Cache Lines Must Be A Power Of 2 Bytes...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	for (int i = 0; i < config->level_count; ++i)
+	{
+		cache_level_config_t* level = &config->levels[i];
+
+		if (level->size == 0 || level->size % (config->line_size * level->ways) != 0)
+		{
+			printf("%s - Cache Level L%d Must Hold Whole Sets Of %d Lines...\n", ERROR_PRINT_TAG, i + 1, level->ways);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+cache_t* create_cache (cache_config_t* config)
+{
+	printf("%s - Initializing Data Caches...\n", INIT_PRINT_TAG);
+
+	cache_t* cache = calloc(1, sizeof(cache_t));
+	cache->config = *config;
+
+	while ((1ULL << cache->line_shift) < config->line_size)
+		cache->line_shift++;
+
+	for (int i = 0; i < config->level_count; ++i)
+	{
+		cache_level_t* level = &cache->levels[i];
+		ullong_t lines = config->levels[i].size / config->line_size;
+
+		level->config 		= config->levels[i];
+		level->set_count 	= lines / level->config.ways;
+		level->tags 		= malloc(lines * sizeof(ullong_t));
+		level->stamps 		= calloc(lines, sizeof(ullong_t));
+		level->dirty 		= calloc(lines, sizeof(uchar_t));
+
+		for (ullong_t line = 0; line < lines; ++line)
+			level->tags[line] = CACHE_INVALID_TAG;
+	}
+
+	return cache;
+}
+
+void free_cache (cache_t* cache)
+{
+	if (!cache)
+		return;
+
+	for (int i = 0; i < cache->config.level_count; ++i)
+	{
+		free(cache->levels[i].tags);
+		free(cache->levels[i].stamps);
+		free(cache->levels[i].dirty);
+	}
+
+	free(cache);
+}
+
+/*================================= OPERATIONAL ================================*/
+static inline long long find_line (cache_level_t* level, ullong_t line)
+{
+	ullong_t first = (line % level->set_count) * level->config.ways;
+
+	for (ullong_t slot = first; slot < first + level->config.ways; ++slot)
+	{
+		if (level->tags[slot] == line)
+			return slot;
+	}
+
+	return -1;
+}
+
+/* Empty way first, the least recently used one otherwise */
+static ullong_t select_victim (cache_level_t* level, ullong_t line)
+{
+	ullong_t first = (line % level->set_count) * level->config.ways;
+	ullong_t victim = first;
+
+	for (ullong_t slot = first; slot < first + level->config.ways; ++slot)
+	{
+		if (level->tags[slot] == CACHE_INVALID_TAG)
+			return slot;
+
+		if (level->stamps[slot] < level->stamps[victim])
+			victim = slot;
+	}
+
+	return victim;
+}
+
+static void insert_line (cache_t* cache, int index, ullong_t line, uchar_t dirty);
+
+/* A dirty line leaving a level is written to the next one that holds it, or to memory */
+static void write_down (cache_t* cache, int index, ullong_t line)
+{
+	for (int below = index + 1; below < cache->config.level_count; ++below)
+	{
+		long long slot = find_line(&cache->levels[below], line);
+
+		if (slot >= 0)
+		{
+			cache->levels[below].dirty[slot] = 1;
+			return;
+		}
+	}
+
+	cache->memory_writes++;
+}
+
+static void evict_slot (cache_t* cache, int index, ullong_t slot)
+{
+	cache_level_t* level = &cache->levels[index];
+	ullong_t line = level->tags[slot];
+	uchar_t dirty = level->dirty[slot];
+
+	if (line == CACHE_INVALID_TAG)
+		return;
+
+	level->evictions++;
+	level->tags[slot] = CACHE_INVALID_TAG;
+	level->dirty[slot] = 0;
+
+	/* Inclusive: Copies above can't outlive this one, their dirty data goes along */
+	if (cache->config.inclusion == CACHE_INCLUSIVE)
+	{
+		for (int above = 0; above < index; ++above)
+		{
+			long long copy = find_line(&cache->levels[above], line);
+
+			if (copy < 0)
+				continue;
+
+			dirty |= cache->levels[above].dirty[copy];
+			cache->levels[above].tags[copy] = CACHE_INVALID_TAG;
+			cache->levels[above].dirty[copy] = 0;
+			cache->levels[above].back_invalidations++;
+		}
+	}
+
+	/* Exclusive: The victim moves a level down, clean or not */
+	if (cache->config.inclusion == CACHE_EXCLUSIVE && index + 1 < cache->config.level_count)
+	{
+		if (dirty)
+			level->writebacks++;
+
+		insert_line(cache, index + 1, line, dirty);
+		return;
+	}
+
+	if (dirty)
+	{
+		level->writebacks++;
+		write_down(cache, index, line);
+	}
+}
+
+static void insert_line (cache_t* cache, int index, ullong_t line, uchar_t dirty)
+{
+	cache_level_t* level = &cache->levels[index];
+	ullong_t slot = select_victim(level, line);
+
+	evict_slot(cache, index, slot);
+
+	level->tags[slot] 	= line;
+	level->stamps[slot] = ++cache->tick;
+	level->dirty[slot] 	= dirty;
+}
+
+/* One access to a cacheable physical address */
+void cache_access (cache_t* cache, paddr_t address, int is_write, int kind)
+{
+	cache_config_t* config = &cache->config;
+	ullong_t line = address >> cache->line_shift;
+	int write_back = (config->write_policy == CACHE_WRITE_BACK);
+	int hit_level = -1;
+	long long slot = -1;
+
+	cache->accesses[kind]++;
+
+	for (int index = 0; index < config->level_count; ++index)
+	{
+		cache_level_t* level = &cache->levels[index];
+
+		cache->cycles[kind] += level->config.latency;
+		slot = find_line(level, line);
+
+		if (slot >= 0)
+		{
+			level->hits[kind]++;
+			level->stamps[slot] = ++cache->tick;
+			hit_level = index;
+			break;
+		}
+
+		level->misses[kind]++;
+	}
+
+	/* Write-through stores update whatever copies there are & always reach memory */
+	if (is_write && !write_back)
+	{
+		cache->memory_writes++;
+
+		if (hit_level < 0)
+			cache->cycles[kind] += config->memory_latency;
+
+		return;
+	}
+
+	if (hit_level == 0)
+	{
+		cache->levels[0].dirty[slot] |= is_write;
+		return;
+	}
+
+	uchar_t dirty = is_write;
+
+	if (hit_level < 0)
+	{
+		cache->memory_reads[kind]++;
+		cache->cycles[kind] += config->memory_latency;
+	}
+	else if (config->inclusion == CACHE_EXCLUSIVE)
+	{
+		/* The line moves up, its dirty state with it */
+		cache_level_t* level = &cache->levels[hit_level];
+
+		dirty |= level->dirty[slot];
+		level->tags[slot] = CACHE_INVALID_TAG;
+		level->dirty[slot] = 0;
+	}
+
+	if (config->inclusion == CACHE_EXCLUSIVE)
+	{
+		insert_line(cache, 0, line, dirty);
+		return;
+	}
+
+	/* Fill from the bottom up, so an inclusive eviction below can't drop the line just placed above */
+	int lowest = (hit_level < 0) ? config->level_count - 1 : hit_level - 1;
+
+	for (int index = lowest; index > 0; --index)
+		insert_line(cache, index, line, 0);
+
+	insert_line(cache, 0, line, dirty);
+}
+
+/* C_CACHEDISABLED page: Straight to memory, nothing is filled */
+void cache_access_uncached (cache_t* cache, int is_write)
+{
+	cache->accesses[CACHE_DATA]++;
+	cache->cycles[CACHE_DATA] += cache->config.memory_latency;
+
+	if (is_write)
+		cache->uncached_writes++;
+	else
+		cache->uncached_reads++;
+}
+
+int cache_is_uncached_page (cache_t* cache, ullong_t virtual_page_number)
+{
+	cache_config_t* config = &cache->config;
+
+	return config->uncached_end > config->uncached_first
+		&& virtual_page_number >= (config->uncached_first >> geometry.page_shift)
+		&& virtual_page_number <= ((config->uncached_end - 1) >> geometry.page_shift);
+}
+
+/*================================== DEBUGGING =================================*/
+static double miss_rate (ullong_t hits, ullong_t misses)
+{
+	return (hits + misses) ? 100.0 * misses / (hits + misses) : 0.0;
+}
+
+void print_cache_stats (cache_t* cache)
+{
+	cache_config_t* config = &cache->config;
+
+	printf("%s", TABLE_CACHE_HEADER);
+	printf("Line Size:\t\t%'llu (bytes, %s, %s)\n", config->line_size, INCLUSION_NAMES[config->inclusion], WRITE_POLICY_NAMES[config->write_policy]);
+
+	for (int i = 0; i < config->level_count; ++i)
+	{
+		cache_level_t* level = &cache->levels[i];
+
+		printf("[L%d]\t\t\t%'llu (bytes, %d-way, %d cycles)\n", i + 1, level->config.size, level->config.ways, level->config.latency);
+		printf("  Data Misses:\t\t%'llu (%.2f%% of %'llu lookups)\n", level->misses[CACHE_DATA], miss_rate(level->hits[CACHE_DATA], level->misses[CACHE_DATA]), level->hits[CACHE_DATA] + level->misses[CACHE_DATA]);
+		printf("  Walk Misses:\t\t%'llu (%.2f%% of %'llu lookups)\n", level->misses[CACHE_TABLE], miss_rate(level->hits[CACHE_TABLE], level->misses[CACHE_TABLE]), level->hits[CACHE_TABLE] + level->misses[CACHE_TABLE]);
+		printf("  Evictions:\t\t%'llu (%'llu written back, %'llu back-invalidated)\n", level->evictions, level->writebacks, level->back_invalidations);
+	}
+
+	printf("Memory Reads:\t\t%'llu (lines, %'llu for walks)\n", cache->memory_reads[CACHE_DATA] + cache->memory_reads[CACHE_TABLE], cache->memory_reads[CACHE_TABLE]);
+	printf("Memory Writes:\t\t%'llu\n", cache->memory_writes);
+	printf("Uncached Accesses:\t%'llu (%'llu writes)\n", cache->uncached_reads + cache->uncached_writes, cache->uncached_writes);
+	printf("Avg. Data Access:\t%.2f (cycles over %'llu accesses)\n", cache->accesses[CACHE_DATA] ? (double) cache->cycles[CACHE_DATA] / cache->accesses[CACHE_DATA] : 0.0, cache->accesses[CACHE_DATA]);
+	printf("Avg. Walk Reference:\t%.2f (cycles over %'llu references)\n", cache->accesses[CACHE_TABLE] ? (double) cache->cycles[CACHE_TABLE] / cache->accesses[CACHE_TABLE] : 0.0, cache->accesses[CACHE_TABLE]);
+	print_header_end('=', strlen(TABLE_CACHE_HEADER));
+}
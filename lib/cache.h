@@ -0,0 +1,95 @@
+#ifndef CACHEH
+#define CACHEH
+
+#include "utils.h"
+
+#define CACHE_MAX_LEVELS    3
+
+/* Inclusion policies */
+#define CACHE_INCLUSIVE     0       /* Every line of a level is in the levels below, evictions there back-invalidate */
+#define CACHE_EXCLUSIVE     1       /* A line lives in one level, victims move a level down */
+#define CACHE_NINE          2       /* Fills go to every level, evictions don't back-invalidate */
+
+/* Write policies */
+#define CACHE_WRITE_BACK    0       /* Write-allocate, dirty lines are written down once evicted */
+#define CACHE_WRITE_THROUGH 1       /* No write-allocate, every write goes to memory */
+
+/* Access kinds, reported apart */
+#define CACHE_DATA          0
+#define CACHE_TABLE         1       /* Page table entry read by a hardware walk */
+
+typedef struct cache_level_config
+{
+    ullong_t        size;               /* Bytes */
+    int             ways;
+    int             latency;            /* Cycles per lookup */
+} cache_level_config_t;
+
+typedef struct cache_config
+{
+    int             level_count;
+    cache_level_config_t levels[CACHE_MAX_LEVELS];
+    ullong_t        line_size;          /* Bytes, the same at every level */
+    int             inclusion;          /* CACHE_INCLUSIVE, CACHE_EXCLUSIVE, CACHE_NINE */
+    int             write_policy;       /* CACHE_WRITE_BACK, CACHE_WRITE_THROUGH */
+    int             memory_latency;     /* Cycles for a miss in every level or an uncached access */
+    vaddr_t         uncached_first;     /* Pages of [first, end) are mapped C_CACHEDISABLED */
+    vaddr_t         uncached_end;
+} cache_config_t;
+
+/*
+    One level, its lines kept as parallel arrays indexed [set * ways + way]
+    like the TLB's. Tags are whole line addresses, replacement is LRU.
+*/
+typedef struct cache_level
+{
+    cache_level_config_t config;
+    ullong_t        set_count;
+    ullong_t*       tags;               /* CACHE_INVALID_TAG if empty */
+    ullong_t*       stamps;             /* Last use */
+    uchar_t*        dirty;
+
+    ullong_t        hits[2];            /* [CACHE_DATA | CACHE_TABLE] */
+    ullong_t        misses[2];
+    ullong_t        evictions;
+    ullong_t        writebacks;         /* Dirty lines written to the level below or memory */
+    ullong_t        back_invalidations; /* Lines dropped because a level below evicted them [Inclusive] */
+} cache_level_t;
+
+/*
+    Physically indexed data cache hierarchy. Accesses are fed with the
+    physical address after translation [and a walk's page table entries
+    as they're read] and take the latency of every level they look in,
+    plus memory's if they miss everywhere. Pages marked C_CACHEDISABLED
+    bypass every level. Only tags are modeled, the data stays where it is.
+*/
+typedef struct cache
+{
+    cache_config_t  config;
+    cache_level_t   levels[CACHE_MAX_LEVELS];
+    int             line_shift;
+    ullong_t        tick;
+
+    ullong_t        accesses[2];        /* [CACHE_DATA | CACHE_TABLE] */
+    ullong_t        cycles[2];
+    ullong_t        memory_reads[2];    /* Lines filled from memory */
+    ullong_t        memory_writes;      /* Lines or write-through stores that reached memory */
+    ullong_t        uncached_reads;     /* Accesses to C_CACHEDISABLED pages */
+    ullong_t        uncached_writes;
+} cache_t;
+
+// Initialization
+void init_cache_config (cache_config_t* config);
+int parse_cache_config (const char* spec, cache_config_t* config);
+cache_t* create_cache (cache_config_t* config);
+void free_cache (cache_t* cache);
+
+// Operational
+void cache_access (cache_t* cache, paddr_t address, int is_write, int kind);
+void cache_access_uncached (cache_t* cache, int is_write);
+int cache_is_uncached_page (cache_t* cache, ullong_t virtual_page_number);
+
+// Debugging
+void print_cache_stats (cache_t* cache);
+
+#endif
@@ -0,0 +1,576 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_map.h"
+#include "trace.h"
+#include "workload.h"
+#include "binary_trace.h"
+#include "tlb.h"
+#include "process.h"
+#include "page_table.h"
+#include "paging.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+
+#define PUT(writer, value)		put(writer, &(value), sizeof(value))
+#define TAKE(reader, value)		take(reader, &(value), sizeof(value))
+
+/* Growable byte stream the state section is built in */
+typedef struct state_writer
+{
+	char*       data;
+	ullong_t    size;
+	ullong_t    capacity;
+} state_writer_t;
+
+typedef struct state_reader
+{
+	const char* data;
+	ullong_t    size;
+	ullong_t    offset;
+	int         failed;             /* Ran past the end, everything after reads as zero */
+} state_reader_t;
+
+static void put (state_writer_t* writer, const void* value, ullong_t size)
+{
+	if (writer->size + size > writer->capacity)
+	{
+		while (writer->size + size > writer->capacity)
+			writer->capacity = (writer->capacity > 0) ? writer->capacity * 2 : 4096;
+
+		writer->data = realloc(writer->data, writer->capacity);
+	}
+
+	memcpy(writer->data + writer->size, value, size);
+	writer->size += size;
+}
+
+/* A NULL value skips the bytes */
+static void take (state_reader_t* reader, void* value, ullong_t size)
+{
+	if (reader->failed || reader->offset + size > reader->size)
+	{
+		reader->failed = 1;
+
+		if (value)
+			memset(value, 0x00, size);
+
+		return;
+	}
+
+	if (value)
+		memcpy(value, reader->data + reader->offset, size);
+
+	reader->offset += size;
+}
+
+// Source: http://www.isthe.com/chongo/tech/comp/fnv/ [FNV-1a]
+static ullong_t trace_fingerprint (trace_t* trace)
+{
+	ullong_t hash = 0xCBF29CE484222325ULL;
+
+	/* A generated stream is fully described by its config */
+	if (trace && trace->workload)
+	{
+		uchar_t* bytes = (uchar_t*) &trace->workload->config;
+
+		for (unsigned long i = 0; i < sizeof(workload_config_t); ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+
+		return hash;
+	}
+
+	/* A binary trace by its header & block index, its blocks stay on disk */
+	if (trace && trace->binary)
+	{
+		uchar_t* bytes = (uchar_t*) &trace->binary->header;
+		uchar_t* offsets = (uchar_t*) trace->binary->block_offsets;
+
+		for (unsigned long i = 0; i < sizeof(binary_trace_header_t); ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+
+		for (unsigned long i = 0; i < trace->binary->header.block_count * sizeof(ullong_t); ++i)
+			hash = (hash ^ offsets[i]) * 0x100000001B3ULL;
+
+		return hash;
+	}
+
+	for (unsigned long i = 0; trace && i < trace->length; ++i)
+	{
+		hash = (hash ^ trace->entries[i].address) * 0x100000001B3ULL;
+		hash = (hash ^ trace->entries[i].is_write) * 0x100000001B3ULL;
+	}
+
+	return hash;
+}
+
+/*================================== SAVING ====================================*/
+static void put_page_map (state_writer_t* writer, page_map_t* map)
+{
+	PUT(writer, map->count);
+
+	for (ullong_t i = 0; i < map->capacity; ++i)
+	{
+		if (!map->used[i])
+			continue;
+
+		PUT(writer, map->keys[i]);
+		PUT(writer, map->values[i]);
+	}
+}
+
+static void put_tlb (state_writer_t* writer, tlb_t* tlb)
+{
+	int present = tlb != NULL;
+
+	PUT(writer, present);
+
+	if (!tlb)
+		return;
+
+	PUT(writer, tlb->config);
+	PUT(writer, tlb->tick);
+	PUT(writer, tlb->random_state);
+	PUT(writer, tlb->current_asid);
+	PUT(writer, tlb->base_only_missed);
+	PUT(writer, tlb->lookups);
+	PUT(writer, tlb->hits);
+	PUT(writer, tlb->huge_hits);
+	PUT(writer, tlb->misses);
+	PUT(writer, tlb->evictions);
+	PUT(writer, tlb->flushes);
+	PUT(writer, tlb->cycles);
+	put(writer, tlb->tags, tlb->config.entry_count * sizeof(ullong_t));
+	put(writer, tlb->frames, tlb->config.entry_count * sizeof(ullong_t));
+	put(writer, tlb->control_bits, tlb->config.entry_count * sizeof(uchar_t));
+	put(writer, tlb->stamps, tlb->config.entry_count * sizeof(ullong_t));
+	put(writer, tlb->referenced, tlb->config.entry_count * sizeof(uchar_t));
+	put(writer, tlb->clock_hands, tlb->set_count * sizeof(int));
+
+	put_tlb(writer, tlb->base_only);
+}
+
+static void put_pager (state_writer_t* writer, pager_t* pager)
+{
+	PUT(writer, pager->config);
+	PUT(writer, pager->resident_count);
+	PUT(writer, pager->resident_frames.hand);
+	PUT(writer, pager->disk_slot_hint);
+	PUT(writer, pager->inverted_table_base);
+	PUT(writer, pager->tick);
+	PUT(writer, pager->faults);
+	PUT(writer, pager->major_faults);
+	PUT(writer, pager->zero_fills);
+	PUT(writer, pager->evictions);
+	PUT(writer, pager->writebacks);
+	PUT(writer, pager->huge_pages);
+	PUT(writer, pager->promotions);
+	PUT(writer, pager->promotion_failures);
+	PUT(writer, pager->demotions);
+	put(writer, pager->frame_page, geometry.frame_count * sizeof(long long));
+	put(writer, pager->loaded_at, geometry.frame_count * sizeof(unsigned long));
+	put(writer, pager->last_used, geometry.frame_count * sizeof(unsigned long));
+	put(writer, pager->disk_slot_used, geometry.disk_frame_count * sizeof(uchar_t));
+
+	/* Owners are stored by pid, pointers mean nothing to the next run */
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		int pid = pager->frame_process[frame] ? pager->frame_process[frame]->pid : -1;
+		PUT(writer, pid);
+	}
+
+	/* Place in replacement order [CLOCK's ring can't be told from the stamps], 0 => Not listed */
+	unsigned long* ranks = calloc(geometry.frame_count, sizeof(unsigned long));
+	unsigned long rank = 0;
+
+	for (long long frame = pager->resident_frames.oldest; frame >= 0; frame = pager->newer_frame[frame])
+		ranks[frame] = ++rank;
+
+	put(writer, ranks, geometry.frame_count * sizeof(unsigned long));
+	free(ranks);
+}
+
+static void put_process (state_writer_t* writer, process_t* process)
+{
+	page_table_t* page_table = process->page_table;
+	ullong_t fingerprint = trace_fingerprint(process->trace);
+	unsigned long trace_length = process->trace ? process->trace->length : 0;
+	int has_table = page_table != NULL;
+
+	PUT(writer, process->pid);
+	PUT(writer, trace_length);
+	PUT(writer, fingerprint);
+	PUT(writer, process->position);
+	PUT(writer, process->resident_count);
+	PUT(writer, process->stats);
+	put_page_map(writer, process->swap_slots);
+	put_page_map(writer, process->region_resident);
+	PUT(writer, has_table);
+
+	if (!page_table)
+		return;
+
+	PUT(writer, page_table->type);
+	PUT(writer, page_table->base);
+	PUT(writer, page_table->pool_address);
+	PUT(writer, page_table->pool_used);
+	PUT(writer, page_table->table_bytes);
+	PUT(writer, page_table->walks);
+	PUT(writer, page_table->references);
+	PUT(writer, page_table->frame_count);
+	put(writer, page_table->frames, page_table->frame_count * sizeof(ullong_t));
+}
+
+/*================================== FILE I/O ==================================*/
+int save_checkpoint (const char* file_path, scheduler_t* scheduler)
+{
+	printf("%s - Checkpoint After %'lu Accesses...\n", SNAPSHOT_PRINT_TAG, scheduler->replayed);
+
+	state_writer_t writer = { NULL, 0, 0 };
+
+	PUT(&writer, scheduler->process_count);
+	PUT(&writer, scheduler->current);
+	PUT(&writer, scheduler->current_pid);
+	PUT(&writer, scheduler->slice_used);
+	PUT(&writer, scheduler->replayed);
+	PUT(&writer, scheduler->context_switches);
+
+	put_pager(&writer, scheduler->pager);
+	put_tlb(&writer, scheduler->tlb);
+
+	for (int i = 0; i < scheduler->process_count; ++i)
+		put_process(&writer, scheduler->processes[i]);
+
+	int result = write_snapshot(file_path, scheduler->pager, scheduler->processes, scheduler->process_count, writer.data, writer.size);
+
+	free(writer.data);
+
+	return result;
+}
+
+/*================================= RESTORING ==================================*/
+static page_map_t* take_page_map (state_reader_t* reader)
+{
+	ullong_t count;
+
+	TAKE(reader, count);
+
+	page_map_t* map = create_page_map(reader->failed ? 0 : count);
+
+	for (ullong_t i = 0; i < count && !reader->failed; ++i)
+	{
+		ullong_t key;
+		long long value;
+
+		TAKE(reader, key);
+		TAKE(reader, value);
+		page_map_put(map, key, value);
+	}
+
+	return map;
+}
+
+/*
+	Contents only carry over into a TLB of the same shape & policy, any
+	other TLB starts cold. tlb may be NULL to skip a saved one.
+*/
+static int take_tlb (state_reader_t* reader, tlb_t* tlb)
+{
+	int present;
+	tlb_config_t config;
+
+	TAKE(reader, present);
+
+	if (!present)
+		return 0;
+
+	TAKE(reader, config);
+
+	int entries = config.entry_count;
+	int set_count = (config.ways > 0) ? entries / config.ways : 0;
+	int compatible = tlb
+		&& tlb->config.entry_count == entries
+		&& tlb->config.ways == config.ways
+		&& tlb->config.policy == config.policy
+		&& tlb->config.use_asid == config.use_asid
+		&& tlb->config.huge_order == config.huge_order;
+
+	if (entries < 0 || set_count < 0)
+	{
+		reader->failed = 1;
+		return 0;
+	}
+
+	take(reader, compatible ? &tlb->tick : NULL, sizeof(tlb->tick));
+	take(reader, compatible ? &tlb->random_state : NULL, sizeof(tlb->random_state));
+	take(reader, compatible ? &tlb->current_asid : NULL, sizeof(tlb->current_asid));
+	take(reader, compatible ? &tlb->base_only_missed : NULL, sizeof(tlb->base_only_missed));
+	take(reader, compatible ? &tlb->lookups : NULL, sizeof(tlb->lookups));
+	take(reader, compatible ? &tlb->hits : NULL, sizeof(tlb->hits));
+	take(reader, compatible ? &tlb->huge_hits : NULL, sizeof(tlb->huge_hits));
+	take(reader, compatible ? &tlb->misses : NULL, sizeof(tlb->misses));
+	take(reader, compatible ? &tlb->evictions : NULL, sizeof(tlb->evictions));
+	take(reader, compatible ? &tlb->flushes : NULL, sizeof(tlb->flushes));
+	take(reader, compatible ? &tlb->cycles : NULL, sizeof(tlb->cycles));
+	take(reader, compatible ? tlb->tags : NULL, entries * sizeof(ullong_t));
+	take(reader, compatible ? tlb->frames : NULL, entries * sizeof(ullong_t));
+	take(reader, compatible ? tlb->control_bits : NULL, entries * sizeof(uchar_t));
+	take(reader, compatible ? tlb->stamps : NULL, entries * sizeof(ullong_t));
+	take(reader, compatible ? tlb->referenced : NULL, entries * sizeof(uchar_t));
+	take(reader, compatible ? tlb->clock_hands : NULL, set_count * sizeof(int));
+
+	take_tlb(reader, compatible ? tlb->base_only : NULL);
+
+	return compatible;
+}
+
+static void take_pager (state_reader_t* reader, pager_t* pager, int* frame_pids, unsigned long* ranks, long long* clock_hand)
+{
+	pager_config_t config;
+
+	/* Replacement policy & frame limit come from this run, only the huge page size is fixed */
+	TAKE(reader, config);
+	TAKE(reader, pager->resident_count);
+	TAKE(reader, *clock_hand);
+	TAKE(reader, pager->disk_slot_hint);
+	TAKE(reader, pager->inverted_table_base);
+	TAKE(reader, pager->tick);
+	TAKE(reader, pager->faults);
+	TAKE(reader, pager->major_faults);
+	TAKE(reader, pager->zero_fills);
+	TAKE(reader, pager->evictions);
+	TAKE(reader, pager->writebacks);
+	TAKE(reader, pager->huge_pages);
+	TAKE(reader, pager->promotions);
+	TAKE(reader, pager->promotion_failures);
+	TAKE(reader, pager->demotions);
+	take(reader, pager->frame_page, geometry.frame_count * sizeof(long long));
+	take(reader, pager->loaded_at, geometry.frame_count * sizeof(unsigned long));
+	take(reader, pager->last_used, geometry.frame_count * sizeof(unsigned long));
+	take(reader, pager->disk_slot_used, geometry.disk_frame_count * sizeof(uchar_t));
+	take(reader, frame_pids, geometry.frame_count * sizeof(int));
+	take(reader, ranks, geometry.frame_count * sizeof(unsigned long));
+
+	/* Free frames follow from the owners, the allocator isn't saved */
+	for (ullong_t frame = 0; frame < geometry.frame_count && !reader->failed; ++frame)
+	{
+		if (pager->frame_page[frame] != FRAME_FREE)
+			frame_allocator_claim(pager->frames, frame, 1);
+	}
+}
+
+static process_t* take_process (state_reader_t* reader, pager_t* pager, trace_t** traces, int trace_count)
+{
+	int pid;
+	unsigned long trace_length;
+	ullong_t fingerprint;
+
+	TAKE(reader, pid);
+	TAKE(reader, trace_length);
+	TAKE(reader, fingerprint);
+
+	if (reader->failed || pid < 0 || pid >= MAX_PROCESSES)
+		return NULL;
+
+	/* Same trace assignment as a fresh run, which must be the trace the checkpoint was replaying */
+	trace_t* trace = traces[pid % trace_count];
+
+	if (trace->length != trace_length || trace_fingerprint(trace) != fingerprint)
+	{
+		printf("%s - Process %d Was Checkpointed With A Different Trace...\n", ERROR_PRINT_TAG, pid);
+		return NULL;
+	}
+
+	process_t* process = create_process(pid, trace);
+	int has_table;
+
+	TAKE(reader, process->position);
+	TAKE(reader, process->resident_count);
+	TAKE(reader, process->stats);
+	free_page_map(process->swap_slots);
+	free_page_map(process->region_resident);
+	process->swap_slots = take_page_map(reader);
+	process->region_resident = take_page_map(reader);
+	TAKE(reader, has_table);
+
+	if (!has_table)
+		return process;
+
+	int type;
+	long long base;
+
+	TAKE(reader, type);
+	TAKE(reader, base);
+
+	if (type < PT_LINEAR || type > PT_INVERTED)
+	{
+		reader->failed = 1;
+		return process;
+	}
+
+	page_table_t* page_table = attach_page_table(type, pager->physical_memory, pid, base);
+	page_table->pager = pager;
+
+	TAKE(reader, page_table->pool_address);
+	TAKE(reader, page_table->pool_used);
+	TAKE(reader, page_table->table_bytes);
+	TAKE(reader, page_table->walks);
+	TAKE(reader, page_table->references);
+	TAKE(reader, page_table->frame_count);
+
+	if (page_table->frame_count < 0 || (ullong_t) page_table->frame_count > geometry.frame_count)
+	{
+		page_table->frame_count = 0;
+		reader->failed = 1;
+	}
+
+	page_table->frames = malloc((page_table->frame_count + 1) * sizeof(ullong_t));
+	take(reader, page_table->frames, page_table->frame_count * sizeof(ullong_t));
+	process->page_table = page_table;
+
+	return process;
+}
+
+/*=============================== INITIALIZATION ===============================*/
+/*
+	Rebuild the machine from a checkpoint, memory & disk images are copied
+	into the given buffers. The geometry must already be the snapshot's
+	[configure_snapshot_geometry]. A NULL tlb_config runs without a TLB.
+*/
+scheduler_t* restore_checkpoint (snapshot_t* snapshot, pager_config_t* pager_config, tlb_config_t* tlb_config, int quantum,
+	trace_t** traces, int trace_count, char* physical_memory, char* disk_memory)
+{
+	printf("%s - Restoring Checkpoint...\n", SNAPSHOT_PRINT_TAG);
+
+	if (!snapshot->state)
+	{
+		printf("%s - Snapshot Has No Checkpoint State...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	if (trace_count == 0)
+	{
+		printf("%s - Restoring Needs The Checkpointed Traces [-t]...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	state_reader_t reader = { snapshot->state, snapshot->header->state_size, 0, 0 };
+	int process_count, current, current_pid, slice_used;
+	unsigned long replayed, context_switches;
+
+	TAKE(&reader, process_count);
+	TAKE(&reader, current);
+	TAKE(&reader, current_pid);
+	TAKE(&reader, slice_used);
+	TAKE(&reader, replayed);
+	TAKE(&reader, context_switches);
+
+	/* Peek at the saved pager config, promoted regions only make sense with the same huge page size */
+	pager_config_t saved_config;
+	state_reader_t peek = reader;
+	TAKE(&peek, saved_config);
+
+	if (reader.failed || peek.failed || process_count <= 0 || process_count > MAX_PROCESSES)
+	{
+		printf("%s - Corrupt Checkpoint State...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	pager_config_t config = *pager_config;
+	config.huge_order 			= saved_config.huge_order;
+	config.promote_threshold 	= saved_config.promote_threshold;
+
+	tlb_t* tlb = NULL;
+
+	if (tlb_config)
+	{
+		tlb_config_t huge_config = *tlb_config;
+		huge_config.huge_order = saved_config.huge_order;
+
+		if (!(tlb = create_tlb(&huge_config)))
+			return NULL;
+	}
+
+	load_snapshot_memory(snapshot, physical_memory, disk_memory);
+
+	pager_t* pager = create_pager(&config, physical_memory, disk_memory, tlb);
+
+	if (!pager)
+	{
+		free_tlb(tlb);
+		return NULL;
+	}
+
+	int* frame_pids = malloc(geometry.frame_count * sizeof(int));
+	unsigned long* ranks = malloc(geometry.frame_count * sizeof(unsigned long));
+	long long clock_hand = -1;
+
+	take_pager(&reader, pager, frame_pids, ranks, &clock_hand);
+
+	if (!take_tlb(&reader, tlb) && tlb)
+		printf("%s - TLB Configuration Changed, TLB Starts Cold...\n", SNAPSHOT_PRINT_TAG);
+
+	scheduler_t* scheduler = create_scheduler(pager, tlb, quantum);
+	process_t* by_pid[MAX_PROCESSES] = { NULL };
+
+	for (int i = 0; i < process_count; ++i)
+	{
+		process_t* process = take_process(&reader, pager, traces, trace_count);
+
+		if (!process)
+		{
+			reader.failed = 1;
+			break;
+		}
+
+		by_pid[process->pid] = process;
+		scheduler_add_process(scheduler, process);
+	}
+
+	for (ullong_t frame = 0; frame < geometry.frame_count && !reader.failed; ++frame)
+	{
+		int pid = frame_pids[frame];
+		pager_set_owner(pager, frame, (pid >= 0 && pid < MAX_PROCESSES) ? by_pid[pid] : NULL);
+
+		/* Exactly the frames holding a process page have an owner */
+		if ((pager->frame_page[frame] >= 0) != (pager->frame_process[frame] != NULL))
+			reader.failed = 1;
+	}
+
+	free(frame_pids);
+
+	/* The saved order only holds for the policy it was kept by */
+	if (!reader.failed)
+		pager_order_frames(pager, (saved_config.policy == config.policy) ? ranks : NULL, clock_hand);
+
+	free(ranks);
+
+	if (reader.failed)
+	{
+		printf("%s - Corrupt Checkpoint State...\n", ERROR_PRINT_TAG);
+		free_scheduler(scheduler);
+		free_pager(pager);
+		free_tlb(tlb);
+		return NULL;
+	}
+
+	scheduler->current 				= (current >= 0 && current < process_count) ? current : 0;
+	scheduler->current_pid 			= current_pid;
+	scheduler->slice_used 			= (slice_used < scheduler->quantum) ? slice_used : scheduler->quantum;
+	scheduler->replayed 			= replayed;
+	scheduler->context_switches 	= context_switches;
+
+	for (int i = 0; i < scheduler->process_count; ++i)
+		pager_prepare_optimal(pager, scheduler->processes[i]);
+
+	/* A lower frame limit than the checkpoint ran with takes effect straight away */
+	pager_enforce_frame_limit(pager);
+
+	printf("%s - Resuming After %'lu Accesses...\n", SNAPSHOT_PRINT_TAG, replayed);
+
+	return scheduler;
+}
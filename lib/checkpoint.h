@@ -0,0 +1,26 @@
+#ifndef CHECKPOINTH
+#define CHECKPOINTH
+
+#include "utils.h"
+#include "trace.h"
+#include "tlb.h"
+#include "paging.h"
+#include "scheduler.h"
+#include "snapshot.h"
+
+/*
+    A checkpoint is a snapshot carrying the rest of the machine in its
+    state section: pager & replacement metadata, TLB contents, every
+    process' position, swap map & page table bookkeeping and the
+    scheduler's place in the rotation. Restoring resumes the replay at
+    the exact access it was saved at.
+*/
+
+// File I/O
+int save_checkpoint (const char* file_path, scheduler_t* scheduler);
+
+// Initialization
+scheduler_t* restore_checkpoint (snapshot_t* snapshot, pager_config_t* pager_config, tlb_config_t* tlb_config, int quantum,
+    trace_t** traces, int trace_count, char* physical_memory, char* disk_memory);
+
+#endif
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "compress.h"
+
+#define LZ_MIN_MATCH		4
+#define LZ_HASH_BITS		12
+#define LZ_MAX_OFFSET		65535
+#define LZ_LAST_LITERALS	5		/* Blocks end in literals, so the decoder never reads a match past the end */
+
+/*================================= OPERATIONAL ================================*/
+static inline uint_t read_word (const uchar_t* position)
+{
+	uint_t value;
+
+	memcpy(&value, position, sizeof(uint_t));
+
+	return value;
+}
+
+static inline uint_t hash_word (uint_t value)
+{
+	return (value * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/* Lengths past 15 continue in bytes of 255 & a final remainder */
+static uchar_t* write_length (uchar_t* out, ullong_t length)
+{
+	for (; length >= 255; length -= 255)
+		*out++ = 255;
+
+	*out++ = (uchar_t) length;
+
+	return out;
+}
+
+static uchar_t* write_sequence (uchar_t* out, const uchar_t* literals, ullong_t literal_count, ullong_t offset, ullong_t match_length)
+{
+	uchar_t* token = out++;
+	ullong_t match_extra = match_length ? match_length - LZ_MIN_MATCH : 0;
+
+	*token = ((literal_count >= 15) ? 15 : literal_count) << 4;
+
+	if (literal_count >= 15)
+		out = write_length(out, literal_count - 15);
+
+	memcpy(out, literals, literal_count);
+	out += literal_count;
+
+	if (match_length == 0)
+		return out;
+
+	*token |= (match_extra >= 15) ? 15 : match_extra;
+	*out++ = offset & 0xFF;
+	*out++ = offset >> 8;
+
+	if (match_extra >= 15)
+		out = write_length(out, match_extra - 15);
+
+	return out;
+}
+
+/* Compressed size, 0 if it doesn't fit in capacity */
+ullong_t lz_compress (const char* source, ullong_t length, char* destination, ullong_t capacity)
+{
+	const uchar_t* in = (const uchar_t*) source;
+	const uchar_t* end = in + length;
+	const uchar_t* anchor = in;
+	const uchar_t* position = in;
+	uchar_t* out = (uchar_t*) destination;
+	uchar_t* out_end = out + capacity;
+	uint_t table[1 << LZ_HASH_BITS];
+
+	memset(table, 0, sizeof(table));
+
+	while (length > LZ_LAST_LITERALS + LZ_MIN_MATCH && position < end - LZ_LAST_LITERALS - LZ_MIN_MATCH)
+	{
+		uint_t hash = hash_word(read_word(position));
+		const uchar_t* reference = in + table[hash];
+
+		table[hash] = position - in;
+
+		if (reference >= position || position - reference > LZ_MAX_OFFSET || read_word(reference) != read_word(position))
+		{
+			position++;
+			continue;
+		}
+
+		const uchar_t* match_end = position + LZ_MIN_MATCH;
+
+		reference += LZ_MIN_MATCH;
+
+		while (match_end < end - LZ_LAST_LITERALS && *match_end == *reference)
+		{
+			match_end++;
+			reference++;
+		}
+
+		ullong_t literal_count = position - anchor;
+		ullong_t match_length = match_end - position;
+
+		/* Token, offset & both length runs at their longest */
+		if ((ullong_t) (out_end - out) < 3 + literal_count + (literal_count / 255) + 1 + (match_length / 255) + 1)
+			return 0;
+
+		out = write_sequence(out, anchor, literal_count, match_end - reference, match_length);
+		position = match_end;
+		anchor = position;
+	}
+
+	ullong_t literal_count = end - anchor;
+
+	if ((ullong_t) (out_end - out) < 1 + literal_count + (literal_count / 255) + 1)
+		return 0;
+
+	out = write_sequence(out, anchor, literal_count, 0, 0);
+
+	return out - (uchar_t*) destination;
+}
+
+/* 0 once exactly capacity bytes were restored, -1 on a malformed block */
+int lz_decompress (const char* source, ullong_t length, char* destination, ullong_t capacity)
+{
+	const uchar_t* in = (const uchar_t*) source;
+	const uchar_t* in_end = in + length;
+	uchar_t* out = (uchar_t*) destination;
+	uchar_t* out_end = out + capacity;
+	uchar_t byte;
+
+	while (in < in_end)
+	{
+		uchar_t token = *in++;
+		ullong_t literal_count = token >> 4;
+
+		if (literal_count == 15)
+		{
+			do
+			{
+				byte = *in++;
+				literal_count += byte;
+			}
+			while (byte == 255 && in < in_end);
+		}
+
+		if (literal_count > (ullong_t) (in_end - in) || literal_count > (ullong_t) (out_end - out))
+			return -1;
+
+		memcpy(out, in, literal_count);
+		in += literal_count;
+		out += literal_count;
+
+		/* The last sequence has no match */
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return -1;
+
+		ullong_t offset = in[0] | (in[1] << 8);
+		ullong_t match_length = (token & 15) + LZ_MIN_MATCH;
+
+		in += 2;
+
+		if ((token & 15) == 15)
+		{
+			do
+			{
+				byte = *in++;
+				match_length += byte;
+			}
+			while (byte == 255 && in < in_end);
+		}
+
+		if (offset == 0 || offset > (ullong_t) (out - (uchar_t*) destination) || match_length > (ullong_t) (out_end - out))
+			return -1;
+
+		/* Byte by byte, the match may overlap what it's copying [Runs] */
+		for (const uchar_t* reference = out - offset; match_length > 0; --match_length)
+			*out++ = *reference++;
+	}
+
+	return (out == out_end) ? 0 : -1;
+}
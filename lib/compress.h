@@ -0,0 +1,16 @@
+#ifndef COMPRESSH
+#define COMPRESSH
+
+#include "utils.h"
+
+/*
+    LZ4 style block compression: Sequences of literals followed by a
+    back-reference [2-byte offset, at least 4 bytes long] found through a
+    hash of the next 4 bytes. Greedy & single pass, fast rather than tight.
+*/
+
+// Operational
+ullong_t lz_compress (const char* source, ullong_t length, char* destination, ullong_t capacity);
+int lz_decompress (const char* source, ullong_t length, char* destination, ullong_t capacity);
+
+#endif
@@ -9,14 +9,24 @@
 #define C_DISK   			(1 << 3)
 #define C_ACCESSED		    (1 << 4)
 #define C_CACHEDISABLED	    (1 << 5)
-#define C_NONE_6 			(1 << 6)
-#define C_NONE_7			(1 << 7)
+#define C_HUGE 			(1 << 6)
+#define C_COW				(1 << 7)
+
+#define MAX_PROCESSES		64
+#define MAX_SWEEP_CONFIGS	256
+
+/* translate_address() Results */
+#define T_MAPPED			0
+#define T_UNMAPPED			1
+#define T_ON_DISK			2
 
 static int PHYSICAL_MEMORY_SIZE     = 65536;
-static int DISK_MEMORY_SIZE         = 512;     // CA requires 2 items added to disk [Restrict memory to 2 frames]
+static int DISK_MEMORY_SIZE         = 262144;  // Backing store large enough to swap out 4 full address spaces
 static int PAGE_TABLE_SIZE          = 512;
 static int PAGE_SIZE                = 256;
 static int FRAME_COUNT              = 256;
+static int VIRTUAL_PAGE_COUNT       = 256;
+static int VPN_BITS                 = 8;
 static int PAYLOAD_LOWER_BOUNDS     = 2048;
 static int PAYLOAD_UPPER_BOUNDS     = 20480;
 static int ASCII_MIN_RANGE          = 33;
@@ -25,6 +35,65 @@ static int OOR_FRAME_OFFSET         = 20;
 static unsigned int OFFSET_MASK     = 0x00FF;
 static unsigned int BIT_SHIFT_BY    = 8;
 
+static int VIRTUAL_ADDRESS_BITS     = 16;
+static int PHYSICAL_ADDRESS_BITS    = 16;
+static int MIN_PAGE_SHIFT           = 8;       // 256 bytes
+static int MAX_PAGE_SHIFT           = 21;      // 2 MiB
+static int MAX_VPN_BITS             = 52;      // TLB tags keep the ASID above the page number
+static unsigned long long DEFAULT_MEMORY_CAP = 268435456;  // Installed memory when only the address width is given
+
+static int TLB_DEFAULT_ENTRIES      = 64;
+static int TLB_DEFAULT_WAYS         = 4;
+static int TLB_HIT_LATENCY          = 1;       // Modeled cycles
+static int MEMORY_LATENCY           = 100;     // Modeled cycles per memory reference
+static int NRU_RESET_INTERVAL       = 1024;    // Accesses between NRU reference bit resets
+static int SCHEDULER_QUANTUM        = 1000;    // Accesses per time slice
+static int HUGE_PROMOTE_PERCENT     = 50;      // Resident share of a region before it is collapsed into a huge page
+static int SNAPSHOT_VERSION         = 4;       // Bumped whenever the snapshot layout changes
+static int SNAPSHOT_ALIGNMENT       = 4096;    // Memory & disk images start on a host page so they can be mapped directly
+static char SNAPSHOT_MAGIC[]        = "VMSIMSNP";
+static int TRACE_FORMAT_VERSION     = 1;       // Bumped whenever the binary trace layout changes
+static char TRACE_MAGIC[]           = "VMSIMTRC";
+static int EVENTS_FORMAT_VERSION    = 1;       // Bumped whenever the event file layout changes
+static char EVENTS_MAGIC[]          = "VMSIMEVT";
+static int TRACE_PAGE_SHIFT         = 12;      // Binary traces split addresses into 4K pages & offsets
+static int TRACE_BLOCK_ENTRIES      = 65536;   // Accesses per binary trace block
+static int TRACE_MAX_BLOCK_ENTRIES  = 16777216;
+static int WORKLOAD_WRITE_PERCENT   = 25;
+static int WORKLOAD_WINDOW          = 65536;   // Generated accesses held at once
+static unsigned long WORKLOAD_DEFAULT_LENGTH = 10000000;
+static unsigned long WORKLOAD_PHASE_LENGTH   = 1000000;
+static unsigned long long WORKLOAD_DEFAULT_PAGES = 16384;
+static double WORKLOAD_ZIPF_EXPONENT = 0.99;
+static unsigned long long SWAP_LATENCY_NS = 80000;      // NVMe class read latency
+static unsigned long long SWAP_BANDWIDTH  = 2147483648;  // Bytes per second
+static int SWAP_QUEUE_DEPTH         = 32;
+static int SWAP_READAHEAD           = 8;       // Pages
+static int SWAP_WRITEBACK_BATCH     = 32;      // Pages
+static unsigned long long SWAP_ACCESS_NS  = 10;          // Modeled CPU time per access
+static int ZSWAP_UNIT               = 64;      // Bytes, smallest piece of the compressed pool
+static int ZSWAP_ACCEPT_PERCENT     = 75;      // Largest compressed page kept in the pool, % of a page
+static unsigned long long ZSWAP_COMPRESS_RATE   = 750000000;   // LZ class compression, bytes per second
+static unsigned long long ZSWAP_DECOMPRESS_RATE = 4000000000;  // Bytes per second
+static unsigned long long KSM_PAGES_TO_SCAN = 100;     // Frames per dedup scan pass
+static int NUMA_NODES               = 2;
+static int MAX_NUMA_NODES           = 64;
+static unsigned long long NUMA_REMOTE_LATENCY = 180;   // Modeled cycles per access to another node's memory
+static int CACHE_LINE_SIZE          = 64;      // Bytes
+static unsigned long long CACHE_DEFAULT_SIZES[] = { 32768, 262144, 8388608 };  // L1, L2 & LLC bytes
+static int CACHE_DEFAULT_WAYS[]     = { 8, 8, 16 };
+static int CACHE_DEFAULT_LATENCIES[] = { 4, 12, 40 };  // Cycles per lookup
+static int RECLAIM_MIN_PERCENT      = 1;       // Of the frame limit
+static unsigned long RECLAIM_INTERVAL = 64;    // Accesses between two background reclaim passes
+static int RECLAIM_BATCH            = 32;      // Pages
+static unsigned long long RECLAIM_PAGE_NS = 2000;      // Modeled CPU time to unmap & free one page
+static int METRICS_INTERVAL_MS      = 1000;    // Between two metrics file dumps
+static int METRICS_POLL_MS          = 100;     // Longest the metrics export thread sleeps
+static unsigned long long EVENTS_RING_SIZE = 65536;    // Events per thread [2M bytes]
+static int EVENTS_DRAIN_US          = 1000;    // Drain thread's nap once every ring is empty
+static int HEATMAP_BUCKET_SHIFT     = 4;       // 16 pages per heatmap cell
+static int WORKING_SET_HOT_PAGES    = 8;       // Hottest pages listed in the report
+
 static char INIT_PRINT_TAG[]        = "[System.Init]";
 static char CORE_PRINT_TAG[]        = "[System.Core]";
 static char FILEIO_PRINT_TAG[]      = "[System.FileIO]";
@@ -32,6 +101,8 @@ static char ERROR_PRINT_TAG[]       = "[System.Error]";
 static char SEGMENT_PRINT_TAG[]     = "[System.Segmentation]";
 static char DISK_PRINT_TAG[]        = "[System.Swapping]";
 static char TRANSLATION_PRINT_TAG[] = "[System.Translation]";
+static char TRACE_PRINT_TAG[]       = "[System.Trace]";
+static char SNAPSHOT_PRINT_TAG[]    = "[System.Snapshot]";
 
 /* printf Formatting */
 static char TABLE_BODY_FORMAT[]     = "Phyiscal Memory:\t%'d (bytes)\nPayload Size:\t\t%'d (bytes)\nFrame Count:\t\t%d frames\nRandom Frame:\t\t0x%02x\n";
@@ -40,12 +111,32 @@ static char TABLE_BODY_FORMAT[]     = "Phyiscal Memory:\t%'d (bytes)\nPayload Si
 static char TABLE_PHYSICAL_MEMORY[] = "0x%02X\t\t| %-3i\t\t| %-3c\r\n";
 static char TABLE_PAGE_TABLE[]      = "0x%02X\t| 0x%02X\t\t\t| %-3i\t\t| %-3i\t\t| %-3i\t\t| %-3i\r\n";
 static char HEX_PAD_4_FORMAT[]      = "0x%04X";
+static char TABLE_SNAPSHOT_MEMORY[] = "0x%02llX\t\t| %-3llu\t\t| %-3c\r\n";
+static char TABLE_SNAPSHOT_PAGE[]   = "0x%02llX\t| 0x%02llX\t\t\t| %-3i\t\t| %-3i\t\t| %-3i\t\t| %-3i\r\n";
+static char TABLE_SNAPSHOT_DISK[]   = "0x%02llX\t\t| %-3c\r\n";
 
 /* printf Headers*/
 static char TABLE_MEMORY_HEADER[]   = "============== [Init. Memory Configuration] ================\n";
 static char TABLE_PAYLOAD_HEADER[]  = "======================= [Payload] ==========================\n";
 static char TABLE_P_ENTRY_EXAMPLE[] = "\n================================ Example Page Table Entry ================================\n";
 static char TABLE_TRSLT_HEADER[]    = "======================= [VP/PF Translation] ==========================\n";
+static char TABLE_TLB_HEADER[]      = "========================== [TLB] ===============================\n";
+static char TABLE_PAGER_HEADER[]    = "========================= [Pager] ==============================\n";
+static char TABLE_SCHEDULER_HEADER[]= "======================= [Scheduler] ============================\n";
+static char TABLE_TRACE_HEADER[]    = "======================= [Trace Replay] ===========================\n";
+static char TABLE_GEOMETRY_HEADER[] = "======================== [Geometry] ============================\n";
+static char TABLE_SNAPSHOT_HEADER[] = "======================== [Snapshot] ============================\n";
+static char TABLE_MRC_HEADER[]      = "=================== [Miss Ratio Curve] =========================\n";
+static char TABLE_SWEEP_HEADER[]    = "========================= [Sweep] ==============================\n";
+static char TABLE_SWAP_HEADER[]     = "====================== [Swap Device] ===========================\n";
+static char TABLE_ZSWAP_HEADER[]    = "==================== [Compressed Swap] =========================\n";
+static char TABLE_KSM_HEADER[]      = "=================== [Page Deduplication] =======================\n";
+static char TABLE_CACHE_HEADER[]    = "====================== [Data Cache] ============================\n";
+static char TABLE_RECLAIM_HEADER[]  = "======================= [Reclaim] ==============================\n";
+static char TABLE_METRICS_HEADER[]  = "======================= [Metrics] ==============================\n";
+static char TABLE_EVENTS_HEADER[]   = "===================== [Event Trace] ============================\n";
+static char TABLE_NUMA_HEADER[]     = "========================= [NUMA] ===============================\n";
+static char TABLE_WORKING_SET_HEADER[] = "===================== [Working Set] ============================\n";
 static char TABLE_FRAME_HEADER[]    = "\n================ Physical Memory ================\n";
 static char TABLE_PHYSICAL_HEADER[] = "%-3s\t\t| %-3s\t\t| %-3s\r\n";
 static char TABLE_PAGE_HEADER[]     = "%-3s\t| %-3s\t| %-3s\t| %-3s\t| %-3s\t| %-3s\r\n";
@@ -57,11 +148,72 @@ static char TABLE_PAGE_HEADER[]     = "%-3s\t| %-3s\t| %-3s\t| %-3s\t| %-3s\t| %
     PAGE_TABLE_SIZE         => Total size of the page table
     PAGE_SIZE               => Single page size
     FRAME_COUNT             => Total # of frames in address space
+    VIRTUAL_PAGE_COUNT      => Total # of pages in the virtual address space [1 page table entry each]
+    VPN_BITS                => Width of a virtual page number [Split evenly between radix table levels]
     PAYLOAD_LOWER_BOUNDS    => Minimum size of random memory payload
     PAYLOAD_UPPER_BOUNDS    => Maximumt size of random memory payload
     ASCII_MIN_RANGE         => Lowest ASCII value
     ASCII_MAX_RANGE         => Highest ASCII value
     OOR_FRAME_OFFSET        => Additional Out Of Range offset [This allows extra empty frames if trying to write out of range]
+    VIRTUAL_ADDRESS_BITS    => Default virtual address width [Memory configuration above is the default geometry]
+    PHYSICAL_ADDRESS_BITS   => Default physical address width
+    MIN_PAGE_SHIFT          => Smallest page size accepted at startup [log2]
+    MAX_PAGE_SHIFT          => Largest page size accepted at startup [log2]
+    MAX_VPN_BITS            => Widest virtual page number [Leaves 12 tag bits for the ASID]
+    DEFAULT_MEMORY_CAP      => Installed memory when none is given and the physical address space is larger
+    TLB_DEFAULT_ENTRIES     => TLB size used when none is given on the command line
+    TLB_DEFAULT_WAYS        => TLB associativity used when none is given on the command line
+    TLB_HIT_LATENCY         => Modeled cycles for every TLB lookup
+    MEMORY_LATENCY          => Modeled cycles for every page table reference after a TLB miss
+    NRU_RESET_INTERVAL      => Accesses between clearing every C_ACCESSED bit under NRU replacement
+    SCHEDULER_QUANTUM       => Accesses a process replays before the scheduler switches to the next
+    HUGE_PROMOTE_PERCENT    => Percentage of a huge page region that must be resident before it is promoted
+    SNAPSHOT_VERSION        => Layout version written to & expected in snapshot headers
+    SNAPSHOT_ALIGNMENT      => Alignment of the memory & disk images inside a snapshot file
+    SNAPSHOT_MAGIC          => First 8 bytes of every snapshot file
+    TRACE_FORMAT_VERSION    => Layout version written to & expected in binary trace headers
+    TRACE_MAGIC             => First 8 bytes of every binary trace file
+    EVENTS_FORMAT_VERSION   => Layout version written to & expected in event file headers
+    EVENTS_MAGIC            => First 8 bytes of every event file
+    TRACE_PAGE_SHIFT        => Page size binary traces delta-encode with [Independent of the simulated one]
+    TRACE_BLOCK_ENTRIES     => Accesses per binary trace block when convert_trace gets no -b [Unit of seeking & decoding]
+    TRACE_MAX_BLOCK_ENTRIES => Largest binary trace block accepted
+    WORKLOAD_WRITE_PERCENT  => Share of generated accesses that are writes
+    WORKLOAD_WINDOW         => Accesses of a generated stream buffered at a time [Streams are never materialised]
+    WORKLOAD_DEFAULT_LENGTH => Accesses in a generated stream when no n= is given
+    WORKLOAD_PHASE_LENGTH   => Accesses before a phased workload moves to its next pattern & working set
+    WORKLOAD_DEFAULT_PAGES  => Footprint of a generated stream when no pages= is given
+    WORKLOAD_ZIPF_EXPONENT  => Skew of the zipf hot set [Higher => Hotter]
+    SWAP_LATENCY_NS         => Modeled swap device latency per request
+    SWAP_BANDWIDTH          => Modeled swap device transfer rate
+    SWAP_QUEUE_DEPTH        => Requests the swap device services at once
+    SWAP_READAHEAD          => Pages read ahead once major faults form a sequential or strided stream
+    SWAP_WRITEBACK_BATCH    => Dirty pages collected before the write-back queue is flushed
+    SWAP_ACCESS_NS          => Modeled CPU time of one access, the swap device's clock
+    ZSWAP_UNIT              => Allocation unit of the compressed swap pool [Entries take a buddy run of units]
+    ZSWAP_ACCEPT_PERCENT    => Pages compressing to more than this share of a page go straight to disk
+    ZSWAP_COMPRESS_RATE     => Modeled compression throughput, charged to the swap device's clock
+    ZSWAP_DECOMPRESS_RATE   => Modeled decompression throughput
+    KSM_PAGES_TO_SCAN       => Frames hashed per dedup scan pass when -D gives no count
+    NUMA_NODES              => Nodes physical memory is split into when -N gives no count
+    MAX_NUMA_NODES          => Most NUMA nodes
+    NUMA_REMOTE_LATENCY     => Modeled cycles for an access to another node [Local ones cost MEMORY_LATENCY]
+    CACHE_LINE_SIZE         => Bytes moved per memory transfer [Cache line when -L gives none, page migrations are costed per line]
+    CACHE_DEFAULT_SIZES     => Data cache levels used when -L names none
+    CACHE_DEFAULT_WAYS      => Associativity of a data cache level when its spec gives none
+    CACHE_DEFAULT_LATENCIES => Modeled cycles for a lookup in a data cache level when its spec gives none
+    RECLAIM_MIN_PERCENT     => Min free frame watermark when -k gives none [Low & high are 2 & 3 times min]
+    RECLAIM_INTERVAL        => Accesses between two passes of the background reclaimer
+    RECLAIM_BATCH           => Pages a background reclaim pass evicts at most
+    RECLAIM_PAGE_NS         => Modeled reclaim time per page, direct & limit reclaim stall the allocation for it
+    METRICS_INTERVAL_MS     => Time between two dumps of the metrics file when -O gives no interval
+    METRICS_POLL_MS         => Longest wait of the metrics export thread for a scrape, also how long a silent client is waited for
+    EVENTS_RING_SIZE        => Events a thread's ring holds when -E gives no ring= [Full rings drop events]
+    EVENTS_DRAIN_US         => Time the event drain thread waits once it found every ring empty
+    HEATMAP_BUCKET_SHIFT    => Pages per working set heatmap cell [log2]
+    WORKING_SET_HOT_PAGES   => Pages with the most sampled accesses listed by the working set report
+    MAX_PROCESSES           => Most simulated processes [Each needs 2 frames for its page table]
+    MAX_SWEEP_CONFIGS       => Most configurations replayed side by side by one sweep
 
     [Control Bits]          [Sets the flag to true]
     C_PRESENT               => Page is in physical memory [Not swapped]
@@ -70,7 +222,12 @@ static char TABLE_PAGE_HEADER[]     = "%-3s\t| %-3s\t| %-3s\t| %-3s\t| %-3s\t| %
     C_DIRTY 			    => Page is written to
     C_ACCESSED			    => Page is being accessed
     C_CACHEDISABLED		    => Disable caching
-    C_NONE_6 			    => Empty bit
-    C_NONE_7			    => Empty bit
+    C_HUGE 			    => Page size bit [Entry is part of an aligned, physically contiguous huge page]
+    C_COW				    => Copy-on-write [Frame shared since a fork, the first write copies it]
+
+    [Translation Results]
+    T_MAPPED                => Page is present in physical memory
+    T_UNMAPPED              => Page has no frame [Neither present nor on disk]
+    T_ON_DISK               => Page is swapped out to disk memory
 */
 #endif
\ No newline at end of file
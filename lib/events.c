@@ -0,0 +1,412 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "events.h"
+
+static const char* EVENT_NAMES[] = { "tlb-miss", "walk", "fault", "eviction", "writeback", "prefetch", "cow-trap" };
+static const char* EVENT_LABELS[] = { "TLB Miss", "Page Walk", "Fault", "Eviction", "Write Back", "Prefetch", "COW Trap" };
+
+events_t* events = NULL;
+
+/* Ring of the calling thread & the recorder it was pushed onto */
+static __thread event_ring_t* local_ring = NULL;
+static __thread events_t* local_recorder = NULL;
+
+/*=============================== INITIALIZATION ===============================*/
+void init_events_config (events_config_t* config)
+{
+	config->file_path 		= NULL;
+	config->chrome_path 	= NULL;
+	config->ring_size 		= EVENTS_RING_SIZE;
+	config->types 			= (1u << EVENT_TYPES) - 1;
+}
+
+/* tlb-miss:fault:eviction..., every type by default */
+static int parse_type_list (char* list, events_config_t* config)
+{
+	config->types = 0;
+
+	for (char* name = strtok(list, ":"); name; name = strtok(NULL, ":"))
+	{
+		int type = 0;
+
+		while (type < EVENT_TYPES && strcmp(name, EVENT_NAMES[type]) != 0)
+			type++;
+
+		if (type == EVENT_TYPES)
+		{
+			printf("%s - Unknown Event Type: %s\n", ERROR_PRINT_TAG, name);
+			return -1;
+		}
+
+		config->types |= 1u << type;
+	}
+
+	return 0;
+}
+
+/* file=<path>,chrome=<path>,ring=<events>,types=<type>:<type>... */
+int parse_events_config (const char* spec, events_config_t* config)
+{
+	char* buffer = strdup(spec);
+	char* type_list = NULL;
+	char* save;
+
+	for (char* option = strtok_r(buffer, ",", &save); option; option = strtok_r(NULL, ",", &save))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - Event Trace Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "file") == 0)
+			config->file_path = strdup(value);
+		else if (strcmp(option, "chrome") == 0)
+			config->chrome_path = strdup(value);
+		else if (strcmp(option, "ring") == 0)
+			config->ring_size = parse_size(value);
+		else if (strcmp(option, "types") == 0)
+			type_list = value;
+		else
+		{
+			printf("%s - Unknown Event Trace Option: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+	}
+
+	if (type_list && parse_type_list(type_list, config) < 0)
+	{
+		free(buffer);
+		return -1;
+	}
+
+	free(buffer);
+
+	if (!config->file_path)
+	{
+		printf("%s - Event Trace Needs A file=<path> To Drain Into...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	if (config->ring_size < 2 || (config->ring_size & (config->ring_size - 1)) != 0)
+	{
+		printf("%s - Event Ring Size Must Be A Power Of 2: %'llu\n", ERROR_PRINT_TAG, config->ring_size);
+		return -1;
+	}
+
+	return 0;
+}
+
+events_t* create_events (events_config_t* config)
+{
+	printf("%s - Initializing Event Trace...\n", INIT_PRINT_TAG);
+
+	event_file_header_t header;
+	FILE* file = fopen(config->file_path, "wb");
+
+	if (!file)
+	{
+		printf("%s - Can't Open Event File: %s\n", ERROR_PRINT_TAG, config->file_path);
+		return NULL;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, EVENTS_MAGIC, sizeof(header.magic));
+	header.version 		= EVENTS_FORMAT_VERSION;
+	header.event_size 	= sizeof(event_t);
+	fwrite(&header, sizeof(header), 1, file);
+
+	events_t* events = calloc(1, sizeof(events_t));
+	events->config 		= *config;
+	events->file 		= file;
+	events->started 	= events_clock();
+
+	return events;
+}
+
+void free_events (events_t* events)
+{
+	if (!events)
+		return;
+
+	event_ring_t* ring = events->rings;
+
+	while (ring)
+	{
+		event_ring_t* next = ring->next;
+
+		free(ring->events);
+		free(ring);
+		ring = next;
+	}
+
+	if (events->file)
+		fclose(events->file);
+
+	free(events->config.file_path);
+	free(events->config.chrome_path);
+	free(events);
+}
+
+/*================================= OPERATIONAL ================================*/
+ullong_t events_clock ()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* First event of a thread, its ring goes on top of the recorder's stack */
+static event_ring_t* register_ring ()
+{
+	event_ring_t* ring = calloc(1, sizeof(event_ring_t));
+
+	ring->events 	= malloc(events->config.ring_size * sizeof(event_t));
+	ring->mask 		= events->config.ring_size - 1;
+	ring->thread 	= __atomic_fetch_add(&events->ring_count, 1, __ATOMIC_RELAXED);
+	ring->next 		= __atomic_load_n(&events->rings, __ATOMIC_RELAXED);
+
+	while (!__atomic_compare_exchange_n(&events->rings, &ring->next, ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+
+	local_ring = ring;
+	local_recorder = events;
+
+	return ring;
+}
+
+/* started 0 => Instant event now, otherwise one that lasted from started until now */
+void events_record (int type, int pid, ullong_t page, uint_t argument, uchar_t flags, ullong_t started)
+{
+	if ((events->config.types & (1u << type)) == 0)
+		return;
+
+	event_ring_t* ring = (local_recorder == events) ? local_ring : register_ring();
+	ullong_t head = ring->head;
+
+	/* Full until the drain moves tail past the oldest event */
+	if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring->mask)
+	{
+		__atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	ullong_t now = events_clock();
+	ullong_t duration = started ? now - started : 0;
+	event_t* event = &ring->events[head & ring->mask];
+
+	event->timestamp 	= (started ? started : now) - events->started;
+	event->duration 	= (duration < UINT_MAX) ? duration : UINT_MAX;
+	event->argument 	= argument;
+	event->page 		= page;
+	event->pid 			= pid;
+	event->type 		= type;
+	event->flags 		= flags;
+	event->thread 		= ring->thread;
+
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Copies what every ring holds to the file, returns how many events that was */
+static ullong_t drain_rings (events_t* events)
+{
+	ullong_t drained = 0;
+
+	for (event_ring_t* ring = __atomic_load_n(&events->rings, __ATOMIC_ACQUIRE); ring; ring = ring->next)
+	{
+		ullong_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		ullong_t tail = ring->tail;
+
+		while (tail < head)
+		{
+			/* Up to the end of the ring's memory, then on from its start */
+			ullong_t first = tail & ring->mask;
+			ullong_t count = (head - tail < ring->mask + 1 - first) ? head - tail : ring->mask + 1 - first;
+
+			fwrite(&ring->events[first], sizeof(event_t), count, events->file);
+
+			for (ullong_t i = 0; i < count; ++i)
+				events->type_counts[ring->events[first + i].type]++;
+
+			tail += count;
+			drained += count;
+		}
+
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	events->written += drained;
+
+	return drained;
+}
+
+#ifdef __linux__
+/* Sleeps only when a whole turn found nothing to drain */
+static void* drain_loop (void* argument)
+{
+	events_t* events = argument;
+	struct timespec pause = { 0, EVENTS_DRAIN_US * 1000L };
+
+	while (!events->stopping)
+	{
+		if (drain_rings(events) == 0)
+			nanosleep(&pause, NULL);
+	}
+
+	return NULL;
+}
+#endif
+
+/* Without a drain thread the rings are drained once, when it's stopped */
+int start_events_drain (events_t* events)
+{
+#ifdef __linux__
+	if (pthread_create(&events->drain, NULL, drain_loop, events) != 0)
+	{
+		printf("%s - Can't Start The Event Drain Thread...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	events->draining = 1;
+#endif
+
+	printf("%s - Tracing Events To: %s\n", FILEIO_PRINT_TAG, events->config.file_path);
+
+	return 0;
+}
+
+void stop_events_drain (events_t* events)
+{
+#ifdef __linux__
+	if (events->draining)
+	{
+		events->stopping = 1;
+		pthread_join(events->drain, NULL);
+		events->draining = 0;
+	}
+#endif
+
+	drain_rings(events);
+	fflush(events->file);
+
+	if (events->config.chrome_path && export_chrome_trace(events->config.file_path, events->config.chrome_path) == 0)
+		printf("%s - Chrome Trace Written To: %s\n", FILEIO_PRINT_TAG, events->config.chrome_path);
+}
+
+/*
+	Chrome trace event JSON, which ui.perfetto.dev opens as well. Events with
+	a duration become complete [X] events, the rest instant [i] ones on
+	their thread. Simulated processes are the trace's processes, recording
+	threads its threads.
+*/
+int export_chrome_trace (const char* events_path, const char* json_path)
+{
+	event_file_header_t header;
+	event_t event;
+	FILE* input = fopen(events_path, "rb");
+
+	if (!input)
+	{
+		printf("%s - Can't Open Event File: %s\n", ERROR_PRINT_TAG, events_path);
+		return -1;
+	}
+
+	if (fread(&header, sizeof(header), 1, input) != 1 || memcmp(header.magic, EVENTS_MAGIC, sizeof(header.magic)) != 0
+		|| header.version != (uint_t) EVENTS_FORMAT_VERSION || header.event_size != sizeof(event_t))
+	{
+		printf("%s - Not An Event File Of Version %d: %s\n", ERROR_PRINT_TAG, EVENTS_FORMAT_VERSION, events_path);
+		fclose(input);
+		return -1;
+	}
+
+	FILE* output = fopen(json_path, "w");
+
+	if (!output)
+	{
+		printf("%s - Can't Open Chrome Trace File: %s\n", ERROR_PRINT_TAG, json_path);
+		fclose(input);
+		return -1;
+	}
+
+	/* Every process gets named the first time one of its events shows up */
+	uchar_t* named = calloc(USHRT_MAX + 1, sizeof(uchar_t));
+	const char* separator = "";
+
+	fprintf(output, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	while (fread(&event, sizeof(event_t), 1, input) == 1)
+	{
+		if (event.type >= EVENT_TYPES)
+			continue;
+
+		if (!named[event.pid])
+		{
+			fprintf(output, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"Process %u\"}}", separator, event.pid, event.pid);
+			named[event.pid] = 1;
+			separator = ",\n";
+		}
+
+		fprintf(output, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,", separator,
+			EVENT_LABELS[event.type], EVENT_NAMES[event.type], event.pid, event.thread, event.timestamp / 1e3);
+
+		if (event.duration > 0)
+			fprintf(output, "\"ph\":\"X\",\"dur\":%.3f,", event.duration / 1e3);
+		else
+			fprintf(output, "\"ph\":\"i\",\"s\":\"t\",");
+
+		fprintf(output, "\"args\":{\"page\":\"0x%llX\",\"argument\":%u,\"write\":%d,\"major\":%d}}",
+			event.page, event.argument, (event.flags & EVENT_WRITE) != 0, (event.flags & EVENT_MAJOR) != 0);
+
+		separator = ",\n";
+	}
+
+	fprintf(output, "\n]}\n");
+
+	free(named);
+	fclose(input);
+
+	return fclose(output) == 0 ? 0 : -1;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_events_stats (events_t* events)
+{
+	ullong_t dropped = 0;
+
+	for (event_ring_t* ring = events->rings; ring; ring = ring->next)
+		dropped += ring->dropped;
+
+	printf("%s", TABLE_EVENTS_HEADER);
+	printf("Recording Threads:\t%u (rings of %'llu events, %'llu bytes each)\n", events->ring_count, events->config.ring_size, events->config.ring_size * (ullong_t) sizeof(event_t));
+	printf("Events Written:\t\t%'llu (%'llu bytes)\n", events->written, events->written * (ullong_t) sizeof(event_t));
+	printf("Events Dropped:\t\t%'llu (rings full before the drain came by)\n", dropped);
+
+	for (int type = 0; type < EVENT_TYPES; ++type)
+	{
+		if ((events->config.types & (1u << type)) == 0)
+			continue;
+
+		/* Tabs up to the value column, like every other line */
+		int column = printf("[%s]", EVENT_LABELS[type]);
+
+		for (; column < 24; column = (column / 8 + 1) * 8)
+			printf("\t");
+
+		printf("%'llu\n", events->type_counts[type]);
+	}
+
+	print_header_end('=', strlen(TABLE_EVENTS_HEADER));
+}
@@ -0,0 +1,113 @@
+#ifndef EVENTSH
+#define EVENTSH
+
+#include "utils.h"
+
+#ifdef __linux__
+	#include <pthread.h>
+#endif
+
+enum event_type
+{
+    EVENT_TLB_MISS,                     /* argument: Unused */
+    EVENT_WALK,                         /* argument: Page table memory references */
+    EVENT_FAULT,                        /* argument: Frame it got, duration: Host time servicing it */
+    EVENT_EVICTION,                     /* argument: Frame, duration: Host time evicting it */
+    EVENT_WRITEBACK,                    /* argument: Disk slot written */
+    EVENT_PREFETCH,                     /* argument: Disk slot read ahead */
+    EVENT_COW_TRAP,                     /* argument: Frame the TLB hit, the write walks to break the sharing */
+    EVENT_TYPES
+};
+
+/* Event flags */
+#define EVENT_WRITE             0x01    /* Caused by a write */
+#define EVENT_MAJOR             0x02    /* Fault read its page back from swap */
+
+/* Fixed size, written to the event file as is */
+typedef struct event
+{
+    ullong_t        timestamp;          /* Host ns since the recorder started */
+    uint_t          duration;           /* Host ns, 0 => Instant, UINT_MAX => That long or longer */
+    uint_t          argument;           /* By type, see event_type */
+    ullong_t        page;               /* Virtual page number */
+    ushort_t        pid;
+    uchar_t         type;
+    uchar_t         flags;
+    uint_t          thread;             /* Recording thread, in the order they first recorded */
+} event_t;
+
+typedef struct event_file_header
+{
+    char            magic[8];
+    uint_t          version;
+    uint_t          event_size;         /* sizeof(event_t) of the writer */
+} event_file_header_t;
+
+typedef struct events_config
+{
+    char*           file_path;          /* Binary event file the drain thread writes */
+    char*           chrome_path;        /* Chrome trace JSON written once the run is over, NULL => None */
+    ullong_t        ring_size;          /* Events per thread, a power of 2 */
+    uint_t          types;              /* 1 << event_type of every type recorded */
+} events_config_t;
+
+/*
+    Single producer, single consumer: The recording thread only moves head,
+    the drain thread only moves tail. An event is visible to the drain once
+    head passed it, its slot is free again once tail did. A full ring drops
+    the event rather than wait for the drain.
+*/
+typedef struct event_ring
+{
+    event_t*        events;
+    ullong_t        mask;               /* ring_size - 1 */
+    ullong_t        head;               /* Events recorded */
+    ullong_t        tail;               /* Events drained */
+    ullong_t        dropped;            /* Events the full ring had no room for */
+    uint_t          thread;
+    struct event_ring* next;
+} event_ring_t;
+
+/*
+    Recorder every thread's ring hangs off. Rings are pushed onto a lock-free
+    stack the first time a thread records & live as long as the recorder.
+    A drain thread copies what they hold to the event file while the run
+    goes on, dist/export_events [or chrome= at the end] turns the file into
+    Chrome trace JSON for chrome://tracing or ui.perfetto.dev.
+*/
+typedef struct events
+{
+    events_config_t config;
+    ullong_t        started;            /* Host ns the timestamps count from */
+    event_ring_t*   rings;
+    uint_t          ring_count;
+    FILE*           file;
+    volatile int    stopping;
+    int             draining;
+    ullong_t        written;            /* Events in the file */
+    ullong_t        type_counts[EVENT_TYPES];
+#ifdef __linux__
+    pthread_t       drain;
+#endif
+} events_t;
+
+/* Recorder every hook records into, NULL => Event tracing off [Hooks check it first] */
+extern events_t* events;
+
+// Initialization
+void init_events_config (events_config_t* config);
+int parse_events_config (const char* spec, events_config_t* config);
+events_t* create_events (events_config_t* config);
+void free_events (events_t* events);
+
+// Operational
+ullong_t events_clock ();
+void events_record (int type, int pid, ullong_t page, uint_t argument, uchar_t flags, ullong_t started);
+int start_events_drain (events_t* events);
+void stop_events_drain (events_t* events);
+int export_chrome_trace (const char* events_path, const char* json_path);
+
+// Debugging
+void print_events_stats (events_t* events);
+
+#endif
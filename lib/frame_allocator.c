@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "frame_allocator.h"
+
+#define WORD_BITS			64
+#define WORD_SHIFT			6
+
+/*=============================== INITIALIZATION ===============================*/
+frame_allocator_t* create_frame_allocator (ullong_t frame_count)
+{
+	frame_allocator_t* allocator = calloc(1, sizeof(frame_allocator_t));
+	allocator->frame_count = frame_count;
+	allocator->free_count = frame_count;
+
+	/* Largest order is the largest block that fits */
+	while (allocator->order_count < WORD_BITS - 1 && (1ULL << allocator->order_count) <= frame_count)
+		allocator->order_count++;
+
+	allocator->free_blocks = calloc(allocator->order_count, sizeof(ullong_t*));
+	allocator->word_counts = calloc(allocator->order_count, sizeof(ullong_t));
+
+	for (int order = 0; order < allocator->order_count; ++order)
+	{
+		ullong_t blocks = frame_count >> order;
+
+		allocator->word_counts[order] = (blocks + WORD_BITS - 1) >> WORD_SHIFT;
+		allocator->free_blocks[order] = calloc(allocator->word_counts[order], sizeof(ullong_t));
+
+		/* Blocks that would run past the last frame are never free */
+		for (ullong_t word = 0; word < (blocks >> WORD_SHIFT); ++word)
+			allocator->free_blocks[order][word] = ~0ULL;
+
+		if (blocks % WORD_BITS != 0)
+			allocator->free_blocks[order][blocks >> WORD_SHIFT] = (1ULL << (blocks % WORD_BITS)) - 1;
+	}
+
+	allocator->summary_words = (allocator->word_counts[0] + WORD_BITS - 1) >> WORD_SHIFT;
+	allocator->summary = calloc(allocator->summary_words, sizeof(ullong_t));
+
+	for (ullong_t word = 0; word < allocator->word_counts[0]; ++word)
+		allocator->summary[word >> WORD_SHIFT] |= 1ULL << (word % WORD_BITS);
+
+	return allocator;
+}
+
+void free_frame_allocator (frame_allocator_t* allocator)
+{
+	if (!allocator)
+		return;
+
+	for (int order = 0; order < allocator->order_count; ++order)
+		free(allocator->free_blocks[order]);
+
+	free(allocator->free_blocks);
+	free(allocator->word_counts);
+	free(allocator->summary);
+	free(allocator);
+}
+
+/*================================= OPERATIONAL ================================*/
+static inline int test_block (frame_allocator_t* allocator, int order, ullong_t block)
+{
+	return (allocator->free_blocks[order][block >> WORD_SHIFT] >> (block % WORD_BITS)) & 1;
+}
+
+/* A used frame splits every block above it, up to the first that was already split */
+static void mark_used (frame_allocator_t* allocator, ullong_t frame)
+{
+	ullong_t* words = allocator->free_blocks[0];
+	ullong_t word = frame >> WORD_SHIFT;
+
+	words[word] &= ~(1ULL << (frame % WORD_BITS));
+
+	if (words[word] == 0)
+		allocator->summary[word >> WORD_SHIFT] &= ~(1ULL << (word % WORD_BITS));
+
+	for (int order = 1; order < allocator->order_count; ++order)
+	{
+		ullong_t block = frame >> order;
+
+		if (!test_block(allocator, order, block))
+			break;
+
+		allocator->free_blocks[order][block >> WORD_SHIFT] &= ~(1ULL << (block % WORD_BITS));
+	}
+
+	allocator->free_count--;
+}
+
+/* A freed frame merges with its buddy for as long as the buddy is free too */
+static void mark_free (frame_allocator_t* allocator, ullong_t frame)
+{
+	ullong_t word = frame >> WORD_SHIFT;
+
+	allocator->free_blocks[0][word] |= 1ULL << (frame % WORD_BITS);
+	allocator->summary[word >> WORD_SHIFT] |= 1ULL << (word % WORD_BITS);
+
+	if ((word >> WORD_SHIFT) < allocator->summary_hint)
+		allocator->summary_hint = word >> WORD_SHIFT;
+
+	for (int order = 1; order < allocator->order_count; ++order)
+	{
+		ullong_t block = frame >> order;
+
+		if ((block + 1) << order > allocator->frame_count)
+			break;
+
+		if (!test_block(allocator, order - 1, block << 1) || !test_block(allocator, order - 1, (block << 1) | 1))
+			break;
+
+		allocator->free_blocks[order][block >> WORD_SHIFT] |= 1ULL << (block % WORD_BITS);
+	}
+
+	allocator->free_count++;
+}
+
+/* Lowest free frame, -1 if there is none */
+long long frame_allocator_allocate (frame_allocator_t* allocator)
+{
+	for (ullong_t index = allocator->summary_hint; index < allocator->summary_words; ++index)
+	{
+		if (allocator->summary[index] == 0)
+			continue;
+
+		ullong_t word = (index << WORD_SHIFT) + __builtin_ctzll(allocator->summary[index]);
+		ullong_t frame = (word << WORD_SHIFT) + __builtin_ctzll(allocator->free_blocks[0][word]);
+
+		allocator->summary_hint = index;
+		mark_used(allocator, frame);
+
+		return frame;
+	}
+
+	allocator->summary_hint = allocator->summary_words;
+
+	return -1;
+}
+
+/* Lowest free frame in [first_frame, end_frame), -1 if there is none */
+long long frame_allocator_allocate_in (frame_allocator_t* allocator, ullong_t first_frame, ullong_t end_frame)
+{
+	ullong_t* words = allocator->free_blocks[0];
+	ullong_t word = first_frame >> WORD_SHIFT;
+	ullong_t last_word = (end_frame - 1) >> WORD_SHIFT;
+
+	while (first_frame < end_frame && word <= last_word)
+	{
+		/* The summary skips up to 64 full words at once */
+		ullong_t summary = allocator->summary[word >> WORD_SHIFT] >> (word % WORD_BITS);
+
+		if (summary == 0)
+		{
+			word = ((word >> WORD_SHIFT) + 1) << WORD_SHIFT;
+			continue;
+		}
+
+		word += __builtin_ctzll(summary);
+
+		if (word > last_word)
+			break;
+
+		ullong_t bits = words[word];
+
+		if (word == first_frame >> WORD_SHIFT)
+			bits &= ~0ULL << (first_frame % WORD_BITS);
+
+		if (word == last_word && end_frame % WORD_BITS != 0)
+			bits &= (1ULL << (end_frame % WORD_BITS)) - 1;
+
+		if (bits != 0)
+		{
+			ullong_t frame = (word << WORD_SHIFT) + __builtin_ctzll(bits);
+
+			mark_used(allocator, frame);
+			return frame;
+		}
+
+		word++;
+	}
+
+	return -1;
+}
+
+/*
+	First free block of the smallest order that holds count frames & is
+	aligned to align [a power of 2]. Frames of the block past count stay
+	free, so odd sized runs don't waste the rest of their block.
+*/
+long long frame_allocator_allocate_run (frame_allocator_t* allocator, ullong_t count, ullong_t align)
+{
+	int order = 0;
+
+	if (count == 1 && align <= 1)
+		return frame_allocator_allocate(allocator);
+
+	while (order < allocator->order_count && ((1ULL << order) < count || (1ULL << order) < align))
+		order++;
+
+	if (count == 0 || order == allocator->order_count)
+		return -1;
+
+	for (ullong_t word = 0; word < allocator->word_counts[order]; ++word)
+	{
+		ullong_t bits = allocator->free_blocks[order][word];
+
+		if (bits == 0)
+			continue;
+
+		ullong_t first_frame = ((word << WORD_SHIFT) + __builtin_ctzll(bits)) << order;
+
+		for (ullong_t frame = first_frame; frame < first_frame + count; ++frame)
+			mark_used(allocator, frame);
+
+		return first_frame;
+	}
+
+	return -1;
+}
+
+/* Take specific frames, nothing is taken unless every one of them is free */
+int frame_allocator_claim (frame_allocator_t* allocator, ullong_t first_frame, ullong_t count)
+{
+	for (ullong_t frame = first_frame; frame < first_frame + count; ++frame)
+	{
+		if (frame >= allocator->frame_count || !test_block(allocator, 0, frame))
+			return -1;
+	}
+
+	for (ullong_t frame = first_frame; frame < first_frame + count; ++frame)
+		mark_used(allocator, frame);
+
+	return 0;
+}
+
+void frame_allocator_release (frame_allocator_t* allocator, ullong_t first_frame, ullong_t count)
+{
+	for (ullong_t frame = first_frame; frame < first_frame + count && frame < allocator->frame_count; ++frame)
+	{
+		if (!test_block(allocator, 0, frame))
+			mark_free(allocator, frame);
+	}
+}
+
+int frame_allocator_is_free (frame_allocator_t* allocator, ullong_t frame)
+{
+	return frame < allocator->frame_count && test_block(allocator, 0, frame);
+}
+
+/*================================== DEBUGGING =================================*/
+/* Frames in the largest free buddy block, 0 if memory is full */
+ullong_t get_largest_free_block (frame_allocator_t* allocator)
+{
+	for (int order = allocator->order_count - 1; order >= 0; --order)
+	{
+		for (ullong_t word = 0; word < allocator->word_counts[order]; ++word)
+		{
+			if (allocator->free_blocks[order][word] != 0)
+				return 1ULL << order;
+		}
+	}
+
+	return 0;
+}
+
+/* Rows for the pager table: Free memory & how much of it can still be handed out as one block */
+void print_frame_allocator_stats (frame_allocator_t* allocator)
+{
+	ullong_t largest = get_largest_free_block(allocator);
+	double fragmentation = allocator->free_count ? 100.0 * (1.0 - (double) largest / allocator->free_count) : 0;
+
+	printf("Free Frames:\t\t%'llu\n", allocator->free_count);
+	printf("Largest Free Block:\t%'llu (frames)\n", largest);
+	printf("Fragmentation:\t\t%.2f%%\n", fragmentation);
+	printf("Free Blocks:\t\t");
+
+	/* Whole buddy blocks per order [Not part of a larger free block] */
+	for (int order = 0; order < allocator->order_count; ++order)
+	{
+		ullong_t blocks = 0;
+
+		for (ullong_t block = 0; block < (allocator->frame_count >> order); ++block)
+		{
+			if (test_block(allocator, order, block) && (order + 1 == allocator->order_count || !test_block(allocator, order + 1, block >> 1)))
+				blocks++;
+		}
+
+		if (blocks > 0)
+			printf("%llu x %llu ", blocks, 1ULL << order);
+	}
+
+	printf("\n");
+}
@@ -0,0 +1,42 @@
+#ifndef FRAMEALLOCATORH
+#define FRAMEALLOCATORH
+
+#include "utils.h"
+
+/*
+    Physical frame allocator. Order 0 is a bitmap of free frames, order k
+    has a bit for every aligned block of 2^k frames that is entirely free,
+    which is the buddy allocator's view: a block is free once both of its
+    buddies are. Single frames come from the lowest free frame [found a
+    64-bit word at a time through a summary of non-empty words], runs
+    from the first free block of the smallest order that holds them.
+*/
+typedef struct frame_allocator
+{
+    ullong_t        frame_count;
+    int             order_count;        /* Orders 0 .. order_count - 1 */
+    ullong_t**      free_blocks;        /* [order][word], bit => Aligned block of 2^order free frames */
+    ullong_t*       word_counts;        /* Words per order */
+    ullong_t*       summary;            /* Bit w => Word w of order 0 has a free frame */
+    ullong_t        summary_words;
+    ullong_t        summary_hint;       /* No free frame in a summary word below this one */
+    ullong_t        free_count;
+} frame_allocator_t;
+
+// Initialization
+frame_allocator_t* create_frame_allocator (ullong_t frame_count);
+void free_frame_allocator (frame_allocator_t* allocator);
+
+// Operational
+long long frame_allocator_allocate (frame_allocator_t* allocator);
+long long frame_allocator_allocate_in (frame_allocator_t* allocator, ullong_t first_frame, ullong_t end_frame);
+long long frame_allocator_allocate_run (frame_allocator_t* allocator, ullong_t count, ullong_t align);
+int frame_allocator_claim (frame_allocator_t* allocator, ullong_t first_frame, ullong_t count);
+void frame_allocator_release (frame_allocator_t* allocator, ullong_t first_frame, ullong_t count);
+int frame_allocator_is_free (frame_allocator_t* allocator, ullong_t frame);
+
+// Debugging
+ullong_t get_largest_free_block (frame_allocator_t* allocator);
+void print_frame_allocator_stats (frame_allocator_t* allocator);
+
+#endif
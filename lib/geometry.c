@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+
+#ifdef __linux__
+	#include <sys/mman.h>
+#endif
+
+geometry_t geometry;
+
+/*=============================== INITIALIZATION ===============================*/
+static int log2_exact (ullong_t value)
+{
+	int shift = 0;
+
+	if (value == 0 || (value & (value - 1)) != 0)
+		return -1;
+
+	while ((1ULL << shift) != value)
+		shift++;
+
+	return shift;
+}
+
+void init_geometry (geometry_t* geometry)
+{
+	configure_geometry(geometry, 0, 0, 0, 0, 0);
+}
+
+/* Zero leaves a field at its default, returns -1 if the combination can't be simulated */
+int configure_geometry (geometry_t* geometry, int va_bits, int pa_bits, ullong_t page_size, ullong_t memory_size, ullong_t disk_size)
+{
+	int page_shift = (page_size > 0) ? log2_exact(page_size) : (int) BIT_SHIFT_BY;
+
+#ifdef SIM_PAGE_SHIFT
+	if (page_size == 0)
+		page_shift = SIM_PAGE_SHIFT;
+#endif
+
+	va_bits = (va_bits > 0) ? va_bits : VIRTUAL_ADDRESS_BITS;
+	pa_bits = (pa_bits > 0) ? pa_bits : PHYSICAL_ADDRESS_BITS;
+
+	if (page_shift < MIN_PAGE_SHIFT || page_shift > MAX_PAGE_SHIFT)
+	{
+		printf("%s - Page Size Must Be A Power Of 2 Between %d & %d Bytes...\n", ERROR_PRINT_TAG, 1 << MIN_PAGE_SHIFT, 1 << MAX_PAGE_SHIFT);
+		return -1;
+	}
+
+#ifdef SIM_PAGE_SHIFT
+	if (page_shift != SIM_PAGE_SHIFT)
+	{
+		printf("%s - Built For %d Byte Pages Only...\n", ERROR_PRINT_TAG, 1 << SIM_PAGE_SHIFT);
+		return -1;
+	}
+#endif
+
+	if (va_bits <= page_shift || va_bits > 64 || va_bits - page_shift > MAX_VPN_BITS)
+	{
+		printf("%s - Virtual Address Width Must Leave 1 - %d Page Number Bits...\n", ERROR_PRINT_TAG, MAX_VPN_BITS);
+		return -1;
+	}
+
+	if (pa_bits <= page_shift || pa_bits > 64)
+	{
+		printf("%s - Physical Address Width Must Be Wider Than The Page Offset...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	ullong_t address_space = (pa_bits == 64) ? ~0ULL : (1ULL << pa_bits);
+
+	if (memory_size == 0)
+		memory_size = (address_space < DEFAULT_MEMORY_CAP) ? address_space : DEFAULT_MEMORY_CAP;
+
+	/* Four times the memory, or as many whole pages as a 64-bit size holds */
+	if (disk_size == 0)
+		disk_size = (memory_size <= ~0ULL / 4) ? memory_size * 4 : ~0ULL << page_shift;
+
+	if (memory_size > address_space || memory_size % (1ULL << page_shift) != 0 || disk_size % (1ULL << page_shift) != 0)
+	{
+		printf("%s - Memory Sizes Must Be Whole Pages Within The Physical Address Space...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	ullong_t frame_count = memory_size >> page_shift;
+
+	if (frame_count > 0xFFFFFFFEULL)
+	{
+		printf("%s - At Most 2^32 Physical Frames Supported...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	/* Nothing is assigned before here, a rejected combination leaves the geometry as it was */
+	geometry->va_bits 				= va_bits;
+	geometry->pa_bits 				= pa_bits;
+	geometry->page_shift 			= page_shift;
+	geometry->vpn_bits 				= va_bits - page_shift;
+	geometry->page_size 			= 1ULL << page_shift;
+	geometry->offset_mask 			= geometry->page_size - 1;
+	geometry->virtual_page_count 	= 1ULL << geometry->vpn_bits;
+	geometry->physical_memory_size 	= memory_size;
+	geometry->frame_count 			= frame_count;
+	geometry->disk_memory_size 		= disk_size;
+	geometry->disk_frame_count 		= disk_size >> page_shift;
+
+	/* Smallest entry that holds a frame number plus the control byte & a node address */
+	int frame_bits = pa_bits - page_shift;
+
+	geometry->pte_size = 8;
+
+	if (frame_bits + 8 <= 16 && pa_bits <= 16)
+		geometry->pte_size = 2;
+	else if (frame_bits + 8 <= 32 && pa_bits <= 32)
+		geometry->pte_size = 4;
+
+	return 0;
+}
+
+/* Only the original geometry has the payload, text dumps & interactive prompt */
+int is_legacy_geometry (geometry_t* geometry)
+{
+	return geometry->va_bits == VIRTUAL_ADDRESS_BITS
+		&& geometry->page_shift == (int) BIT_SHIFT_BY
+		&& geometry->physical_memory_size == (ullong_t) PHYSICAL_MEMORY_SIZE
+		&& geometry->disk_memory_size == (ullong_t) DISK_MEMORY_SIZE
+		&& geometry->pte_size == 2;
+}
+
+/* Accepts plain byte counts or a K, M, G or T suffix, i.e. 4K => 4096 */
+ullong_t parse_size (const char* text)
+{
+	char* end;
+	ullong_t size = strtoull(text, &end, 0);
+
+	switch (toupper((unsigned char) *end))
+	{
+		case 'T': size <<= 10;	/* fall through */
+		case 'G': size <<= 10;	/* fall through */
+		case 'M': size <<= 10;	/* fall through */
+		case 'K': size <<= 10;
+		default: break;
+	}
+
+	return size;
+}
+
+/*=================================== MEMORY ===================================*/
+/*
+	Large simulated memories are reserved without backing so only the
+	pages the simulation actually touches cost host memory.
+*/
+char* allocate_simulated_memory (ullong_t size)
+{
+#ifdef __linux__
+	char* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (memory == MAP_FAILED)
+		memory = NULL;
+#else
+	char* memory = calloc(1, size);
+#endif
+
+	if (!memory)
+		printf("%s - Failed To Allocate %'llu Bytes Of Simulated Memory...\n", ERROR_PRINT_TAG, size);
+
+	return memory;
+}
+
+void free_simulated_memory (char* memory, ullong_t size)
+{
+	if (!memory)
+		return;
+
+#ifdef __linux__
+	munmap(memory, size);
+#else
+	free(memory);
+#endif
+}
+
+/*================================== DEBUGGING =================================*/
+void print_geometry (geometry_t* geometry)
+{
+	printf("%s", TABLE_GEOMETRY_HEADER);
+	printf("Virtual Address:\t%d (bits)\n", geometry->va_bits);
+	printf("Physical Address:\t%d (bits)\n", geometry->pa_bits);
+	printf("Page Size:\t\t%'llu (bytes)\n", geometry->page_size);
+	printf("Entry Size:\t\t%d (bytes)\n", geometry->pte_size);
+	printf("Physical Memory:\t%'llu (bytes)\n", geometry->physical_memory_size);
+	printf("Frame Count:\t\t%'llu\n", geometry->frame_count);
+	printf("Disk Memory:\t\t%'llu (bytes)\n", geometry->disk_memory_size);
+	print_header_end('=', strlen(TABLE_GEOMETRY_HEADER));
+}
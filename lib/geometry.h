@@ -0,0 +1,53 @@
+#ifndef GEOMETRYH
+#define GEOMETRYH
+
+#include "utils.h"
+
+/*
+    Address-space geometry, fixed once at startup. Defaults reproduce the
+    original 16-bit address space with 256-byte pages & 2-byte entries.
+*/
+typedef struct geometry
+{
+    int         va_bits;                /* Virtual address width */
+    int         pa_bits;                /* Physical address width */
+    int         page_shift;             /* log2(page_size) */
+    int         vpn_bits;               /* va_bits - page_shift */
+    int         pte_size;               /* Bytes per page table entry [2, 4 or 8] */
+    ullong_t    page_size;
+    ullong_t    offset_mask;
+    ullong_t    virtual_page_count;
+    ullong_t    physical_memory_size;   /* Installed memory [<= 2^pa_bits] */
+    ullong_t    frame_count;
+    ullong_t    disk_memory_size;
+    ullong_t    disk_frame_count;
+} geometry_t;
+
+extern geometry_t geometry;
+
+/*
+    Building with -DSIM_PAGE_SHIFT=<n> turns the hot path shift & mask into
+    constants, the runtime page size then has to agree with it.
+*/
+#ifdef SIM_PAGE_SHIFT
+    #define GEO_PAGE_SHIFT      (SIM_PAGE_SHIFT)
+    #define GEO_OFFSET_MASK     ((1ULL << SIM_PAGE_SHIFT) - 1)
+#else
+    #define GEO_PAGE_SHIFT      (geometry.page_shift)
+    #define GEO_OFFSET_MASK     (geometry.offset_mask)
+#endif
+
+// Initialization
+void init_geometry (geometry_t* geometry);
+int configure_geometry (geometry_t* geometry, int va_bits, int pa_bits, ullong_t page_size, ullong_t memory_size, ullong_t disk_size);
+int is_legacy_geometry (geometry_t* geometry);
+ullong_t parse_size (const char* text);
+
+// Memory
+char* allocate_simulated_memory (ullong_t size);
+void free_simulated_memory (char* memory, ullong_t size);
+
+// Debugging
+void print_geometry (geometry_t* geometry);
+
+#endif
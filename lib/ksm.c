@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_map.h"
+#include "tlb.h"
+#include "page_table.h"
+#include "process.h"
+#include "paging.h"
+#include "ksm.h"
+
+/*=============================== INITIALIZATION ===============================*/
+ksm_t* create_ksm (unsigned long interval, ullong_t pages_per_scan)
+{
+	printf("%s - Initializing Page Deduplication...\n", INIT_PRINT_TAG);
+
+	ksm_t* ksm = calloc(1, sizeof(ksm_t));
+	ksm->interval 			= interval;
+	ksm->next_scan 			= interval;
+	ksm->pages_per_scan 	= pages_per_scan;
+	ksm->checksum 			= calloc(geometry.frame_count, sizeof(ullong_t));
+	ksm->checked_at 		= calloc(geometry.frame_count, sizeof(unsigned long));
+	ksm->references 		= calloc(geometry.frame_count, sizeof(uint_t));
+	ksm->stable 			= create_page_map(0);
+	ksm->unstable 			= create_page_map(0);
+	ksm->zero_frame 		= -1;
+
+	return ksm;
+}
+
+void free_ksm (ksm_t* ksm)
+{
+	if (!ksm)
+		return;
+
+	free(ksm->checksum);
+	free(ksm->checked_at);
+	free(ksm->references);
+	free_page_map(ksm->stable);
+	free_page_map(ksm->unstable);
+	free(ksm);
+}
+
+/*================================= OPERATIONAL ================================*/
+/* 64 bits at a time, pages are a multiple of 256 bytes */
+static ullong_t hash_page (const char* data)
+{
+	ullong_t hash = 0xCBF29CE484222325ULL;
+
+	for (ullong_t i = 0; i < geometry.page_size; i += sizeof(ullong_t))
+	{
+		ullong_t word;
+
+		memcpy(&word, &data[i], sizeof(ullong_t));
+		hash = (hash ^ word) * 0x100000001B3ULL;
+		hash ^= hash >> 29;
+	}
+
+	return hash;
+}
+
+static int is_zero_page (const char* data)
+{
+	for (ullong_t i = 0; i < geometry.page_size; i += sizeof(ullong_t))
+	{
+		ullong_t word;
+
+		memcpy(&word, &data[i], sizeof(ullong_t));
+
+		if (word != 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+static int same_contents (ksm_t* ksm, pager_t* pager, ullong_t frame, ullong_t other)
+{
+	ullong_t page_size = geometry.page_size;
+
+	ksm->bytes_compared += page_size;
+
+	return memcmp(&pager->physical_memory[frame * page_size], &pager->physical_memory[other * page_size], page_size) == 0;
+}
+
+/*
+	Only a process' own private page can merge: Not shared by a fork, not
+	part of a huge page & not in an inverted table [One frame, one page].
+*/
+static int is_mergeable (pager_t* pager, ullong_t frame)
+{
+	long long page = pager->frame_page[frame];
+	process_t* process = pager->frame_process[frame];
+	ullong_t frame_number;
+	uchar_t control_bits;
+
+	if (page < 0 || pager->frame_shared[frame] > 0 || process->page_table->type == PT_INVERTED)
+		return 0;
+
+	page_table_get(process->page_table, page, &frame_number, &control_bits);
+
+	return (control_bits & C_PRESENT) != 0 && (control_bits & (C_HUGE | C_COW)) == 0;
+}
+
+/* Writes through the page's mapping trap from now on */
+static void protect_mapping (pager_t* pager, ullong_t frame, ullong_t into)
+{
+	long long page = pager->frame_page[frame];
+	process_t* process = pager->frame_process[frame];
+	ullong_t frame_number;
+	uchar_t control_bits;
+
+	page_table_get(process->page_table, page, &frame_number, &control_bits);
+
+	if ((control_bits & C_READWRITE) != 0)
+		control_bits = (control_bits & ~C_READWRITE) | C_COW;
+
+	page_table_map(process->page_table, page, into, control_bits);
+
+	if (pager->tlb)
+		tlb_invalidate(pager->tlb, process->pid, page);
+}
+
+void ksm_share (ksm_t* ksm, ullong_t frame)
+{
+	ksm->references[frame]++;
+	ksm->mappings++;
+
+	if (ksm->mappings - ksm->merged_frames > ksm->peak_saved)
+		ksm->peak_saved = ksm->mappings - ksm->merged_frames;
+}
+
+/* The frame's page stays where it is, the frame becomes a merged one */
+static void convert_frame (ksm_t* ksm, pager_t* pager, ullong_t frame)
+{
+	protect_mapping(pager, frame, frame);
+
+	pager->frame_page[frame] 	= FRAME_MERGED;
+	pager_set_owner(pager, frame, NULL);
+	ksm->merged_frames++;
+	ksm_share(ksm, frame);
+}
+
+/* The frame's page moves to the merged frame & the frame is free again */
+static void merge_frame (ksm_t* ksm, pager_t* pager, ullong_t frame, ullong_t into)
+{
+	protect_mapping(pager, frame, into);
+
+	pager->frame_page[frame] 	= FRAME_FREE;
+	pager_set_owner(pager, frame, NULL);
+	pager->resident_count--;
+	frame_allocator_release(pager->frames, frame, 1);
+	ksm_share(ksm, into);
+}
+
+static void scan_frame (ksm_t* ksm, pager_t* pager, ullong_t frame)
+{
+	const char* data = &pager->physical_memory[frame * geometry.page_size];
+
+	if (!is_mergeable(pager, frame))
+		return;
+
+	ullong_t hash = hash_page(data);
+
+	/* Pages still being written would be copied straight back, only ones that held still merge */
+	int is_stable = ksm->checksum[frame] == hash && ksm->checked_at[frame] >= pager->loaded_at[frame];
+
+	ksm->frames_scanned++;
+	ksm->bytes_hashed 		+= geometry.page_size;
+	ksm->checksum[frame] 	= hash;
+	ksm->checked_at[frame] 	= pager->tick;
+
+	if (!is_stable)
+	{
+		ksm->volatile_skips++;
+		return;
+	}
+
+	if (is_zero_page(data))
+	{
+		if (ksm->zero_frame < 0)
+		{
+			convert_frame(ksm, pager, frame);
+			ksm->zero_frame = frame;
+		}
+		else
+		{
+			merge_frame(ksm, pager, frame, ksm->zero_frame);
+		}
+
+		ksm->zero_merges++;
+		return;
+	}
+
+	long long merged = page_map_get(ksm->stable, hash, -1);
+
+	if (merged >= 0)
+	{
+		if (same_contents(ksm, pager, frame, merged))
+		{
+			merge_frame(ksm, pager, frame, merged);
+			ksm->merges++;
+		}
+
+		return;
+	}
+
+	long long candidate = page_map_get(ksm->unstable, hash, -1);
+
+	/* The candidate may have changed or been evicted since it was seen */
+	if (candidate >= 0 && (ullong_t) candidate != frame && is_mergeable(pager, candidate)
+		&& ksm->checksum[candidate] == hash && same_contents(ksm, pager, frame, candidate))
+	{
+		page_map_remove(ksm->unstable, hash);
+		page_map_put(ksm->stable, hash, candidate);
+		convert_frame(ksm, pager, candidate);
+		merge_frame(ksm, pager, frame, candidate);
+		ksm->merges += 2;
+		return;
+	}
+
+	page_map_put(ksm->unstable, hash, frame);
+}
+
+/* One pass of the background scanner, between two accesses of the replay */
+void ksm_scan (ksm_t* ksm, pager_t* pager, unsigned long replayed)
+{
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (ullong_t i = 0; i < ksm->pages_per_scan; ++i)
+	{
+		ullong_t frame = ksm->cursor;
+
+		ksm->cursor = (ksm->cursor + 1) % geometry.frame_count;
+		scan_frame(ksm, pager, frame);
+
+		/* Candidates only pair up within a round, like the unstable tree */
+		if (ksm->cursor == 0)
+		{
+			free_page_map(ksm->unstable);
+			ksm->unstable = create_page_map(0);
+			ksm->rounds++;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	ksm->passes++;
+	ksm->next_scan 		= replayed + ksm->interval;
+	ksm->scan_seconds 	+= (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* A page stops mapping the merged frame, the last one frees it */
+void ksm_release (ksm_t* ksm, pager_t* pager, ullong_t frame)
+{
+	ksm->mappings--;
+	ksm->unmerges++;
+
+	if (--ksm->references[frame] > 0)
+		return;
+
+	if ((long long) frame == ksm->zero_frame)
+		ksm->zero_frame = -1;
+	else if (page_map_get(ksm->stable, ksm->checksum[frame], -1) == (long long) frame)
+		page_map_remove(ksm->stable, ksm->checksum[frame]);
+
+	pager->frame_page[frame] = FRAME_FREE;
+	pager->resident_count--;
+	frame_allocator_release(pager->frames, frame, 1);
+	ksm->merged_frames--;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_ksm_stats (ksm_t* ksm)
+{
+	double scanned = ksm->frames_scanned ? (double) ksm->frames_scanned : 1.0;
+
+	printf("%s", TABLE_KSM_HEADER);
+	printf("Scan Passes:\t\t%'lu (%'llu frames every %'lu accesses, %'lu full rounds)\n", ksm->passes, ksm->pages_per_scan, ksm->interval, ksm->rounds);
+	printf("Frames Scanned:\t\t%'lu (%'lu changed since their last scan)\n", ksm->frames_scanned, ksm->volatile_skips);
+	printf("Bytes Hashed:\t\t%'llu\n", ksm->bytes_hashed);
+	printf("Bytes Compared:\t\t%'llu\n", ksm->bytes_compared);
+	printf("Scan Time:\t\t%.3f (ms, %.1f ns/frame)\n", ksm->scan_seconds * 1e3, ksm->scan_seconds * 1e9 / scanned);
+	printf("Merged Pages:\t\t%'lu (%'lu of them all zeros)\n", ksm->merges + ksm->zero_merges, ksm->zero_merges);
+	printf("Zero Page Reads:\t%'lu (faults mapped to the zero frame)\n", ksm->zero_maps);
+	printf("Unmerged:\t\t%'lu (pages copied out on a write or huge page)\n", ksm->unmerges);
+	printf("Shared Frames:\t\t%'lu (mapped by %'lu pages)\n", ksm->merged_frames, ksm->mappings);
+	printf("Frames Saved:\t\t%'lu (peak %'lu)\n", ksm->mappings - ksm->merged_frames, ksm->peak_saved);
+	print_header_end('=', strlen(TABLE_KSM_HEADER));
+}
@@ -0,0 +1,60 @@
+#ifndef KSMH
+#define KSMH
+
+#include "utils.h"
+#include "page_map.h"
+
+struct pager;
+
+/*
+    Same-page merging. Every interval accesses a scan pass hashes the next
+    pages_per_scan frames. A frame whose hash held still since its last
+    pass is merged: into the shared zero frame if it's all zeros, into a
+    merged frame with the same contents if there is one, or together with
+    a frame of the same hash seen earlier in the round. Merged frames are
+    read-only & belong to no process [FRAME_MERGED], every page mapping one
+    is copy-on-write & the last one to leave frees it. Reads of a page that
+    was never written map the zero frame instead of a frame of their own.
+*/
+typedef struct ksm
+{
+    unsigned long   interval;           /* Accesses between two scan passes */
+    unsigned long   next_scan;
+    ullong_t        pages_per_scan;     /* Frames looked at per pass */
+    ullong_t        cursor;             /* Next frame to scan */
+    ullong_t*       checksum;           /* Frame -> Hash of its contents on its last scan */
+    unsigned long*  checked_at;         /* Frame -> Tick of that scan */
+    uint_t*         references;         /* Merged frame -> Pages mapping it */
+    page_map_t*     stable;             /* Hash -> Merged frame */
+    page_map_t*     unstable;           /* Hash -> Unmerged frame seen with it this round */
+    long long       zero_frame;         /* -1 until a page needs it */
+
+    unsigned long   passes;
+    unsigned long   rounds;             /* Scans of the whole memory */
+    unsigned long   frames_scanned;
+    unsigned long   volatile_skips;     /* Frames whose contents changed since their last scan */
+    ullong_t        bytes_hashed;
+    ullong_t        bytes_compared;
+    double          scan_seconds;       /* Host time spent scanning */
+    unsigned long   merges;             /* Pages merged into a frame with the same contents */
+    unsigned long   zero_merges;        /* Pages found to be all zeros */
+    unsigned long   zero_maps;          /* Read faults mapped to the zero frame */
+    unsigned long   unmerges;           /* Pages that left a merged frame [Write or huge page] */
+    unsigned long   merged_frames;      /* Current merged frames, the zero frame included */
+    unsigned long   mappings;           /* Current pages mapping a merged frame */
+    unsigned long   peak_saved;         /* Most frames saved at once */
+} ksm_t;
+
+// Initialization
+ksm_t* create_ksm (unsigned long interval, ullong_t pages_per_scan);
+void free_ksm (ksm_t* ksm);
+
+// Operational
+void ksm_scan (ksm_t* ksm, struct pager* pager, unsigned long replayed);
+void ksm_share (ksm_t* ksm, ullong_t frame);
+void ksm_release (ksm_t* ksm, struct pager* pager, ullong_t frame);
+
+// Debugging
+void print_ksm_stats (ksm_t* ksm);
+
+#endif
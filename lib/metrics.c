@@ -0,0 +1,589 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include "constants.h"
+#include "utils.h"
+#include "metrics.h"
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <poll.h>
+	#include <sys/stat.h>
+	#include <sys/socket.h>
+	#include <sys/un.h>
+#endif
+
+typedef struct metric_info
+{
+    const char*     name;
+    const char*     help;
+} metric_info_t;
+
+static const metric_info_t COUNTER_INFO[] =
+{
+	{ "vmsim_accesses_total", 		"Accesses replayed." },
+	{ "vmsim_tlb_hits_total", 		"TLB lookups that hit, copy-on-write traps included." },
+	{ "vmsim_tlb_misses_total", 	"TLB lookups that missed & walked the page table." },
+	{ "vmsim_page_faults_total", 	"Accesses that found their page not present." },
+	{ "vmsim_major_faults_total", 	"Faults that read their page back from swap." },
+	{ "vmsim_evictions_total", 		"Frames taken from their page by replacement or reclaim." },
+	{ "vmsim_writebacks_total", 	"Evicted frames that were dirty & written to swap." },
+	{ "vmsim_cow_traps_total", 		"TLB hits that trapped to the walk for a write to a copy-on-write page." }
+};
+
+static const metric_info_t HISTOGRAM_INFO[] =
+{
+	{ "vmsim_translation_latency_cycles", 	"Modeled cycles per translation, TLB lookup & page table walk." },
+	{ "vmsim_fault_service_nanoseconds", 	"Host time servicing a page fault." },
+	{ "vmsim_eviction_cost_nanoseconds", 	"Host time evicting a frame, write back included." }
+};
+
+metrics_t* metrics = NULL;
+
+/* Shard of the calling thread & the registry it was pushed onto */
+static __thread metrics_shard_t* local_shard = NULL;
+static __thread metrics_t* local_registry = NULL;
+
+/*=============================== INITIALIZATION ===============================*/
+void init_metrics_config (metrics_config_t* config)
+{
+	config->socket_path 	= NULL;
+	config->file_path 		= NULL;
+	config->interval_ms 	= METRICS_INTERVAL_MS;
+}
+
+/* socket=<path>,file=<path>,interval=<ms> */
+int parse_metrics_config (const char* spec, metrics_config_t* config)
+{
+	char* buffer = strdup(spec);
+	char* save;
+
+	for (char* option = strtok_r(buffer, ",", &save); option; option = strtok_r(NULL, ",", &save))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - Metrics Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "socket") == 0)
+			config->socket_path = strdup(value);
+		else if (strcmp(option, "file") == 0)
+			config->file_path = strdup(value);
+		else if (strcmp(option, "interval") == 0)
+			config->interval_ms = atoi(value);
+		else
+		{
+			printf("%s - Unknown Metrics Option: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+	}
+
+	free(buffer);
+
+	if (config->interval_ms <= 0)
+	{
+		printf("%s - Metrics Interval Must Be Above 0 ms...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	return 0;
+}
+
+metrics_t* create_metrics (metrics_config_t* config)
+{
+	printf("%s - Initializing Metrics Registry...\n", INIT_PRINT_TAG);
+
+	metrics_t* metrics = calloc(1, sizeof(metrics_t));
+	metrics->config 	= *config;
+	metrics->listener 	= -1;
+
+	return metrics;
+}
+
+void free_metrics (metrics_t* metrics)
+{
+	if (!metrics)
+		return;
+
+	metrics_shard_t* shard = metrics->shards;
+
+	while (shard)
+	{
+		metrics_shard_t* next = shard->next;
+
+		free(shard);
+		shard = next;
+	}
+
+	free(metrics->config.socket_path);
+	free(metrics->config.file_path);
+	free(metrics);
+}
+
+/*================================= OPERATIONAL ================================*/
+ullong_t metrics_clock ()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* First record of a thread, its shard goes on top of the registry's stack */
+static metrics_shard_t* register_shard ()
+{
+	metrics_shard_t* shard = calloc(1, sizeof(metrics_shard_t));
+
+	shard->next = __atomic_load_n(&metrics->shards, __ATOMIC_RELAXED);
+
+	while (!__atomic_compare_exchange_n(&metrics->shards, &shard->next, shard, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+
+	__atomic_fetch_add(&metrics->shard_count, 1, __ATOMIC_RELAXED);
+
+	local_shard = shard;
+	local_registry = metrics;
+
+	return shard;
+}
+
+static inline metrics_shard_t* get_local_shard ()
+{
+	return (local_registry == metrics) ? local_shard : register_shard();
+}
+
+/* Only the owning thread writes, a plain add stored atomically is enough */
+static inline void add (ullong_t* value, ullong_t delta)
+{
+	__atomic_store_n(value, *value + delta, __ATOMIC_RELAXED);
+}
+
+static inline ullong_t load (ullong_t* value)
+{
+	return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+/* Values below 2 x METRICS_SUB_BUCKETS have a bucket each, past that 1 of METRICS_SUB_BUCKETS per power of 2 */
+static inline int bucket_of (ullong_t value)
+{
+	if (value < METRICS_SUB_BUCKETS)
+		return value;
+
+	int exponent = 63 - __builtin_clzll(value);
+
+	return (exponent - METRICS_SUB_BITS + 1) * METRICS_SUB_BUCKETS + ((value >> (exponent - METRICS_SUB_BITS)) & (METRICS_SUB_BUCKETS - 1));
+}
+
+/* Largest value that falls in the bucket */
+static ullong_t bucket_highest (int bucket)
+{
+	if (bucket < METRICS_SUB_BUCKETS)
+		return bucket;
+
+	int shift = bucket / METRICS_SUB_BUCKETS - 1;
+	ullong_t sub_bucket = bucket % METRICS_SUB_BUCKETS;
+
+	return ((METRICS_SUB_BUCKETS + sub_bucket) << shift) + (1ULL << shift) - 1;
+}
+
+void metrics_count (int counter, ullong_t value)
+{
+	metrics_shard_t* shard = get_local_shard();
+
+	add(&shard->counters[counter], value);
+}
+
+void metrics_record (int histogram, ullong_t value)
+{
+	metrics_shard_t* shard = get_local_shard();
+
+	add(&shard->buckets[histogram][bucket_of(value)], 1);
+	add(&shard->counts[histogram], 1);
+	add(&shard->sums[histogram], value);
+
+	if (value > shard->maxima[histogram])
+		__atomic_store_n(&shard->maxima[histogram], value, __ATOMIC_RELAXED);
+}
+
+/* Every shard summed into one, while their threads keep writing */
+static void collect (metrics_t* metrics, metrics_shard_t* totals)
+{
+	memset(totals, 0, sizeof(metrics_shard_t));
+
+	for (metrics_shard_t* shard = __atomic_load_n(&metrics->shards, __ATOMIC_ACQUIRE); shard; shard = shard->next)
+	{
+		for (int i = 0; i < METRIC_COUNTERS; ++i)
+			totals->counters[i] += load(&shard->counters[i]);
+
+		for (int i = 0; i < METRIC_HISTOGRAMS; ++i)
+		{
+			ullong_t maximum = load(&shard->maxima[i]);
+
+			totals->counts[i] 	+= load(&shard->counts[i]);
+			totals->sums[i] 	+= load(&shard->sums[i]);
+
+			if (maximum > totals->maxima[i])
+				totals->maxima[i] = maximum;
+
+			for (int bucket = 0; bucket < METRICS_BUCKETS; ++bucket)
+				totals->buckets[i][bucket] += load(&shard->buckets[i][bucket]);
+		}
+	}
+}
+
+/* Upper bound of the value below which the fraction of samples lies [Within 1/METRICS_SUB_BUCKETS] */
+static ullong_t histogram_quantile (metrics_shard_t* totals, int histogram, double fraction)
+{
+	ullong_t count = 0;
+	ullong_t seen = 0;
+	ullong_t rank;
+
+	for (int bucket = 0; bucket < METRICS_BUCKETS; ++bucket)
+		count += totals->buckets[histogram][bucket];
+
+	if (count == 0)
+		return 0;
+
+	rank = (ullong_t) (fraction * count);
+	rank = (rank < 1) ? 1 : rank;
+
+	for (int bucket = 0; bucket < METRICS_BUCKETS; ++bucket)
+	{
+		seen += totals->buckets[histogram][bucket];
+
+		if (seen >= rank)
+		{
+			ullong_t highest = bucket_highest(bucket);
+
+			return (highest < totals->maxima[histogram]) ? highest : totals->maxima[histogram];
+		}
+	}
+
+	return totals->maxima[histogram];
+}
+
+typedef struct text
+{
+	char*		data;
+	ullong_t	length;
+	ullong_t	capacity;
+} text_t;
+
+static void append (text_t* text, const char* format, ...)
+{
+	va_list arguments;
+
+	for (;;)
+	{
+		ullong_t room = text->capacity - text->length;
+
+		va_start(arguments, format);
+		int written = vsnprintf(text->data + text->length, room, format, arguments);
+		va_end(arguments);
+
+		if ((ullong_t) written < room)
+		{
+			text->length += written;
+			return;
+		}
+
+		text->capacity = 2 * text->capacity + written;
+		text->data = realloc(text->data, text->capacity);
+	}
+}
+
+/*
+	Prometheus text format. Histogram buckets end at 2^k - 1, the edges of
+	the log-linear buckets, so every le="" line is exact. The caller frees
+	the text.
+*/
+char* render_metrics (metrics_t* metrics, ullong_t* length)
+{
+	metrics_shard_t* totals = malloc(sizeof(metrics_shard_t));
+	text_t text = { malloc(4096), 0, 4096 };
+
+	collect(metrics, totals);
+
+	for (int i = 0; i < METRIC_COUNTERS; ++i)
+	{
+		append(&text, "# HELP %s %s\n# TYPE %s counter\n", COUNTER_INFO[i].name, COUNTER_INFO[i].help, COUNTER_INFO[i].name);
+		append(&text, "%s %llu\n", COUNTER_INFO[i].name, totals->counters[i]);
+	}
+
+	for (int i = 0; i < METRIC_HISTOGRAMS; ++i)
+	{
+		const char* name = HISTOGRAM_INFO[i].name;
+		ullong_t cumulative = 0;
+
+		append(&text, "# HELP %s %s\n# TYPE %s histogram\n", name, HISTOGRAM_INFO[i].help, name);
+
+		for (int bucket = 0; bucket < METRICS_BUCKETS; ++bucket)
+		{
+			ullong_t highest = bucket_highest(bucket);
+
+			cumulative += totals->buckets[i][bucket];
+
+			/* Only the edges of powers of 2, up to the first that holds every sample */
+			if ((highest & (highest + 1)) != 0)
+				continue;
+
+			append(&text, "%s_bucket{le=\"%llu\"} %llu\n", name, highest, cumulative);
+
+			if (highest >= totals->maxima[i])
+				break;
+		}
+
+		append(&text, "%s_bucket{le=\"+Inf\"} %llu\n", name, totals->counts[i]);
+		append(&text, "%s_sum %llu\n%s_count %llu\n", name, totals->sums[i], name, totals->counts[i]);
+	}
+
+	append(&text, "# HELP vmsim_metrics_threads Threads that recorded metrics.\n# TYPE vmsim_metrics_threads gauge\n");
+	append(&text, "vmsim_metrics_threads %d\n", __atomic_load_n(&metrics->shard_count, __ATOMIC_RELAXED));
+
+	free(totals);
+	*length = text.length;
+
+	return text.data;
+}
+
+#ifdef __linux__
+static int write_all (int descriptor, const char* data, ullong_t length)
+{
+	while (length > 0)
+	{
+		ssize_t written = send(descriptor, data, length, MSG_NOSIGNAL);
+
+		if (written <= 0)
+			return -1;
+
+		data += written;
+		length -= written;
+	}
+
+	return 0;
+}
+
+/* Written next to the file & renamed over it, a reader never sees half a dump */
+static void dump_metrics (metrics_t* metrics)
+{
+	char temporary_path[4096];
+	ullong_t length;
+	char* text = render_metrics(metrics, &length);
+
+	snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", metrics->config.file_path);
+
+	FILE* file = fopen(temporary_path, "wb");
+
+	if (file && fwrite(text, 1, length, file) == length && fclose(file) == 0)
+	{
+		rename(temporary_path, metrics->config.file_path);
+		metrics->dumps++;
+	}
+	else if (file)
+	{
+		fclose(file);
+	}
+
+	free(text);
+}
+
+/* Whatever the client asked for it gets the metrics, as a plain HTTP response [curl --unix-socket works] */
+static void serve_scrape (metrics_t* metrics)
+{
+	int client = accept(metrics->listener, NULL, NULL);
+	struct timeval timeout = { 0, METRICS_POLL_MS * 1000 };
+	char request[4096];
+	char header[256];
+	ullong_t length;
+
+	if (client < 0)
+		return;
+
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	/* Clients that send nothing [socat, nc] are answered once the timeout runs out */
+	if (recv(client, request, sizeof(request), 0) < 0)
+		request[0] = '\0';
+
+	char* text = render_metrics(metrics, &length);
+	int header_length = snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %llu\r\n\r\n", length);
+
+	if (write_all(client, header, header_length) == 0)
+		write_all(client, text, length);
+
+	metrics->scrapes++;
+	free(text);
+	close(client);
+}
+
+static int open_listener (metrics_t* metrics)
+{
+	struct sockaddr_un address;
+	struct stat status;
+	char* path = metrics->config.socket_path;
+
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		printf("%s - Metrics Socket Path Longer Than %d Characters: %s\n", ERROR_PRINT_TAG, (int) sizeof(address.sun_path) - 1, path);
+		return -1;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	/* A socket left behind by an earlier run is replaced, any other file is kept */
+	if (stat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+		unlink(path);
+
+	metrics->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (metrics->listener < 0 || bind(metrics->listener, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(metrics->listener, 8) < 0)
+	{
+		printf("%s - Can't Listen On Metrics Socket: %s\n", ERROR_PRINT_TAG, path);
+
+		if (metrics->listener >= 0)
+			close(metrics->listener);
+
+		metrics->listener = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Wakes every METRICS_POLL_MS at most, so stopping never waits long */
+static void* export_loop (void* argument)
+{
+	metrics_t* metrics = argument;
+	ullong_t interval = metrics->config.interval_ms * 1000000ULL;
+	ullong_t next_dump = metrics_clock() + interval;
+
+	while (!metrics->stopping)
+	{
+		if (metrics->listener >= 0)
+		{
+			struct pollfd listener = { metrics->listener, POLLIN, 0 };
+
+			if (poll(&listener, 1, METRICS_POLL_MS) > 0)
+			{
+				ullong_t started = metrics_clock();
+
+				serve_scrape(metrics);
+				metrics->export_seconds += (metrics_clock() - started) / 1e9;
+			}
+		}
+		else
+		{
+			struct timespec pause = { 0, METRICS_POLL_MS * 1000000L };
+			nanosleep(&pause, NULL);
+		}
+
+		if (metrics->config.file_path && metrics_clock() >= next_dump)
+		{
+			ullong_t started = metrics_clock();
+
+			dump_metrics(metrics);
+			metrics->export_seconds += (metrics_clock() - started) / 1e9;
+			next_dump = started + interval;
+		}
+	}
+
+	return NULL;
+}
+#endif
+
+/* Export thread for the socket & the file, nothing to start without either */
+int start_metrics_export (metrics_t* metrics)
+{
+	metrics_config_t* config = &metrics->config;
+
+	if (!config->socket_path && !config->file_path)
+		return 0;
+
+#ifdef __linux__
+	if (config->socket_path && open_listener(metrics) < 0)
+		return -1;
+
+	if (pthread_create(&metrics->exporter, NULL, export_loop, metrics) != 0)
+	{
+		printf("%s - Can't Start The Metrics Export Thread...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	metrics->exporting = 1;
+
+	if (config->socket_path)
+		printf("%s - Serving Metrics On: %s\n", FILEIO_PRINT_TAG, config->socket_path);
+
+	if (config->file_path)
+		printf("%s - Dumping Metrics Every %d ms To: %s\n", FILEIO_PRINT_TAG, config->interval_ms, config->file_path);
+
+	return 0;
+#else
+	printf("%s - Metrics Export Needs Linux...\n", ERROR_PRINT_TAG);
+	return -1;
+#endif
+}
+
+/* The file gets the final totals, the socket goes away with the thread */
+void stop_metrics_export (metrics_t* metrics)
+{
+	if (!metrics->exporting)
+		return;
+
+#ifdef __linux__
+	metrics->stopping = 1;
+	pthread_join(metrics->exporter, NULL);
+
+	if (metrics->config.file_path)
+		dump_metrics(metrics);
+
+	if (metrics->listener >= 0)
+	{
+		close(metrics->listener);
+		unlink(metrics->config.socket_path);
+		metrics->listener = -1;
+	}
+#endif
+
+	metrics->exporting = 0;
+}
+
+/*================================== DEBUGGING =================================*/
+static void print_histogram (metrics_shard_t* totals, int histogram, const char* label, double scale, const char* unit)
+{
+	ullong_t count = totals->counts[histogram];
+
+	printf("%s%.2f / %.2f / %.2f / %.2f (%s p50 / p99 / p99.9 / max, %.2f avg. over %'llu)\n", label,
+		histogram_quantile(totals, histogram, 0.50) / scale, histogram_quantile(totals, histogram, 0.99) / scale,
+		histogram_quantile(totals, histogram, 0.999) / scale, totals->maxima[histogram] / scale, unit,
+		count ? totals->sums[histogram] / scale / count : 0.0, count);
+}
+
+void print_metrics_stats (metrics_t* metrics)
+{
+	metrics_shard_t* totals = malloc(sizeof(metrics_shard_t));
+
+	collect(metrics, totals);
+
+	printf("%s", TABLE_METRICS_HEADER);
+	printf("Recording Threads:\t%d\n", metrics->shard_count);
+	print_histogram(totals, METRIC_TRANSLATION_CYCLES, "Translation Latency:\t", 1.0, "cycles");
+	print_histogram(totals, METRIC_FAULT_NS, "Fault Service Time:\t", 1e3, "us");
+	print_histogram(totals, METRIC_EVICTION_NS, "Eviction Cost:\t\t", 1e3, "us");
+	printf("Exported:\t\t%'lu (scrapes, %'lu file dumps, %.3f ms)\n", metrics->scrapes, metrics->dumps, metrics->export_seconds * 1e3);
+	print_header_end('=', strlen(TABLE_METRICS_HEADER));
+
+	free(totals);
+}
@@ -0,0 +1,101 @@
+#ifndef METRICSH
+#define METRICSH
+
+#include "utils.h"
+
+#ifdef __linux__
+	#include <pthread.h>
+#endif
+
+/* Log-linear histogram: 2^4 buckets per power of 2, every value within 1/16 of its bucket */
+#define METRICS_SUB_BITS        4
+#define METRICS_SUB_BUCKETS     (1 << METRICS_SUB_BITS)
+#define METRICS_BUCKETS         ((64 - METRICS_SUB_BITS + 1) * METRICS_SUB_BUCKETS)
+
+enum metrics_counter
+{
+    METRIC_ACCESSES,
+    METRIC_TLB_HITS,
+    METRIC_TLB_MISSES,
+    METRIC_FAULTS,
+    METRIC_MAJOR_FAULTS,
+    METRIC_EVICTIONS,
+    METRIC_WRITEBACKS,
+    METRIC_COW_TRAPS,                   /* TLB hits that were writes to a copy-on-write page [Counted as hits too] */
+    METRIC_COUNTERS
+};
+
+enum metrics_histogram
+{
+    METRIC_TRANSLATION_CYCLES,          /* Modeled cycles of every translation [TLB lookup & walk] */
+    METRIC_FAULT_NS,                    /* Host time servicing a fault */
+    METRIC_EVICTION_NS,                 /* Host time evicting a frame [Write back included] */
+    METRIC_HISTOGRAMS
+};
+
+typedef struct metrics_config
+{
+    char*           socket_path;        /* Unix socket serving the metrics on every connection, NULL => None */
+    char*           file_path;          /* File rewritten every interval, NULL => None */
+    int             interval_ms;
+} metrics_config_t;
+
+/*
+    One per thread that records anything, only that thread writes it. The
+    exporter reads every shard while they're written: Each value is one
+    relaxed atomic word, so a read may miss the latest updates but never
+    sees a torn one & the hot path takes no lock.
+*/
+typedef struct metrics_shard
+{
+    ullong_t        counters[METRIC_COUNTERS];
+    ullong_t        counts[METRIC_HISTOGRAMS];
+    ullong_t        sums[METRIC_HISTOGRAMS];
+    ullong_t        maxima[METRIC_HISTOGRAMS];
+    ullong_t        buckets[METRIC_HISTOGRAMS][METRICS_BUCKETS];
+    struct metrics_shard* next;
+} metrics_shard_t;
+
+/*
+    Registry of every shard, threads push theirs the first time they record.
+    Shards live as long as the registry, so the totals outlast the threads
+    of a sweep. An export thread serves or dumps the totals in Prometheus
+    text format while the replay runs.
+*/
+typedef struct metrics
+{
+    metrics_config_t config;
+    metrics_shard_t* shards;            /* Lock-free stack, only ever pushed onto */
+    int             shard_count;
+    volatile int    stopping;
+    int             exporting;
+    int             listener;           /* Socket descriptor, -1 => None */
+    unsigned long   scrapes;            /* Socket requests served */
+    unsigned long   dumps;              /* Files written */
+    double          export_seconds;     /* Export thread's time rendering & writing */
+#ifdef __linux__
+    pthread_t       exporter;
+#endif
+} metrics_t;
+
+/* Registry every hook records into, NULL => Metrics off [Hooks check it first] */
+extern metrics_t* metrics;
+
+// Initialization
+void init_metrics_config (metrics_config_t* config);
+int parse_metrics_config (const char* spec, metrics_config_t* config);
+metrics_t* create_metrics (metrics_config_t* config);
+void free_metrics (metrics_t* metrics);
+
+// Operational
+ullong_t metrics_clock ();
+void metrics_count (int counter, ullong_t value);
+void metrics_record (int histogram, ullong_t value);
+int start_metrics_export (metrics_t* metrics);
+void stop_metrics_export (metrics_t* metrics);
+char* render_metrics (metrics_t* metrics, ullong_t* length);
+
+// Debugging
+void print_metrics_stats (metrics_t* metrics);
+
+#endif
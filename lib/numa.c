@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "frame_allocator.h"
+#include "numa.h"
+
+static const char* NUMA_POLICY_NAMES[] = { "first-touch", "interleave", "preferred" };
+
+/*=============================== INITIALIZATION ===============================*/
+void init_numa_config (numa_config_t* config)
+{
+	config->node_count 			= NUMA_NODES;
+	config->local_latency 		= MEMORY_LATENCY;
+	config->remote_latency 		= NUMA_REMOTE_LATENCY;
+	config->policy 				= NUMA_FIRST_TOUCH;
+	config->preferred_node 		= 0;
+	config->migrate_threshold 	= 0;
+	config->bind 				= NULL;
+	config->bind_count 			= 0;
+}
+
+/* Home nodes in pid order: 0:1:1 */
+static int parse_bind_list (char* list, numa_config_t* config)
+{
+	config->bind = calloc(MAX_PROCESSES, sizeof(int));
+	config->bind_count = 0;
+
+	for (char* node = strtok(list, ":"); node; node = strtok(NULL, ":"))
+	{
+		if (config->bind_count == MAX_PROCESSES)
+			return -1;
+
+		config->bind[config->bind_count++] = atoi(node);
+	}
+
+	return 0;
+}
+
+/* nodes=<count>,local=<cycles>,remote=<cycles>,policy=<name>,node=<preferred>,migrate=<accesses>,bind=<node>:<node>... */
+int parse_numa_config (const char* spec, numa_config_t* config)
+{
+	char* buffer = strdup(spec);
+	char* bind_list = NULL;
+	char* save;
+
+	for (char* option = strtok_r(buffer, ",", &save); option; option = strtok_r(NULL, ",", &save))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - NUMA Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "nodes") == 0)
+			config->node_count = atoi(value);
+		else if (strcmp(option, "local") == 0)
+			config->local_latency = strtoull(value, NULL, 0);
+		else if (strcmp(option, "remote") == 0)
+			config->remote_latency = strtoull(value, NULL, 0);
+		else if (strcmp(option, "node") == 0)
+			config->preferred_node = atoi(value);
+		else if (strcmp(option, "migrate") == 0)
+			config->migrate_threshold = strtoull(value, NULL, 0);
+		else if (strcmp(option, "bind") == 0)
+			bind_list = value;
+		else if (strcmp(option, "policy") == 0)
+		{
+			config->policy = -1;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				if (strcmp(value, NUMA_POLICY_NAMES[i]) == 0)
+					config->policy = i;
+			}
+
+			if (config->policy < 0)
+			{
+				printf("%s - Unknown NUMA Policy: %s [first-touch, interleave, preferred]\n", ERROR_PRINT_TAG, value);
+				free(buffer);
+				return -1;
+			}
+		}
+		else
+		{
+			printf("%s - Unknown NUMA Option: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+	}
+
+	if (bind_list && parse_bind_list(bind_list, config) < 0)
+	{
+		printf("%s - NUMA Binds At Most %d Processes...\n", ERROR_PRINT_TAG, MAX_PROCESSES);
+		free(buffer);
+		return -1;
+	}
+
+	free(buffer);
+
+	if (config->node_count < 1 || config->node_count > MAX_NUMA_NODES || config->preferred_node < 0 || config->preferred_node >= config->node_count)
+	{
+		printf("%s - NUMA Needs 1 To %d Nodes & A Preferred Node Among Them...\n", ERROR_PRINT_TAG, MAX_NUMA_NODES);
+		return -1;
+	}
+
+	for (int i = 0; i < config->bind_count; ++i)
+	{
+		if (config->bind[i] < 0 || config->bind[i] >= config->node_count)
+		{
+			printf("%s - Process %d Bound To Node %d, There Are %d...\n", ERROR_PRINT_TAG, i, config->bind[i], config->node_count);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+numa_t* create_numa (numa_config_t* config)
+{
+	printf("%s - Initializing NUMA Nodes...\n", INIT_PRINT_TAG);
+
+	if (geometry.frame_count < (ullong_t) config->node_count)
+	{
+		printf("%s - %d NUMA Nodes Need At Least As Many Frames...\n", ERROR_PRINT_TAG, config->node_count);
+		return NULL;
+	}
+
+	numa_t* numa = calloc(1, sizeof(numa_t));
+	numa->config 				= *config;
+	numa->frames_per_node 		= geometry.frame_count / config->node_count;
+	numa->remote_hits 			= calloc(geometry.frame_count, sizeof(uint_t));
+	numa->node_allocations 		= calloc(config->node_count, sizeof(ullong_t));
+	numa->node_fallbacks 		= calloc(config->node_count, sizeof(ullong_t));
+	numa->node_local 			= calloc(config->node_count, sizeof(ullong_t));
+	numa->node_remote 			= calloc(config->node_count, sizeof(ullong_t));
+	numa->node_migrated_in 		= calloc(config->node_count, sizeof(ullong_t));
+	numa->node_migrated_out 	= calloc(config->node_count, sizeof(ullong_t));
+	numa->process_local 		= calloc(MAX_PROCESSES, sizeof(ullong_t));
+	numa->process_remote 		= calloc(MAX_PROCESSES, sizeof(ullong_t));
+
+	return numa;
+}
+
+void free_numa (numa_t* numa)
+{
+	if (!numa)
+		return;
+
+	free(numa->config.bind);
+	free(numa->remote_hits);
+	free(numa->node_allocations);
+	free(numa->node_fallbacks);
+	free(numa->node_local);
+	free(numa->node_remote);
+	free(numa->node_migrated_in);
+	free(numa->node_migrated_out);
+	free(numa->process_local);
+	free(numa->process_remote);
+	free(numa);
+}
+
+/*================================= OPERATIONAL ================================*/
+int numa_node_of (numa_t* numa, ullong_t frame)
+{
+	ullong_t node = frame / numa->frames_per_node;
+
+	return (node < (ullong_t) numa->config.node_count) ? (int) node : numa->config.node_count - 1;
+}
+
+int numa_home_node (numa_t* numa, int pid)
+{
+	if (pid >= 0 && pid < numa->config.bind_count)
+		return numa->config.bind[pid];
+
+	return pid % numa->config.node_count;
+}
+
+/* Lowest free frame of the node, -1 once it's full */
+long long numa_allocate_on (numa_t* numa, frame_allocator_t* frames, int node)
+{
+	ullong_t first_frame = node * numa->frames_per_node;
+	ullong_t end_frame = (node == numa->config.node_count - 1) ? geometry.frame_count : first_frame + numa->frames_per_node;
+	long long frame = frame_allocator_allocate_in(frames, first_frame, end_frame);
+
+	if (frame >= 0)
+		numa->remote_hits[frame] = 0;
+
+	return frame;
+}
+
+/* Frame for a data page on the node the policy picks, or the next one with room */
+long long numa_allocate (numa_t* numa, frame_allocator_t* frames, int pid, ullong_t virtual_page_number)
+{
+	int node_count = numa->config.node_count;
+	int target;
+
+	switch (numa->config.policy)
+	{
+		case NUMA_INTERLEAVE: 	target = virtual_page_number % node_count; break;
+		case NUMA_PREFERRED: 	target = numa->config.preferred_node; break;
+		default: 				target = numa_home_node(numa, pid); break;
+	}
+
+	for (int i = 0; i < node_count; ++i)
+	{
+		int node = (target + i) % node_count;
+		long long frame = numa_allocate_on(numa, frames, node);
+
+		if (frame < 0)
+			continue;
+
+		if (i > 0)
+			numa->node_fallbacks[target]++;
+
+		numa->node_allocations[node]++;
+
+		return frame;
+	}
+
+	return -1;
+}
+
+/* Charges one access, 1 once the frame's page has been remote often enough to migrate */
+int numa_access (numa_t* numa, int pid, ullong_t frame)
+{
+	int node = numa_node_of(numa, frame);
+
+	if (node == numa_home_node(numa, pid))
+	{
+		numa->local_accesses++;
+		numa->node_local[node]++;
+		numa->process_local[pid]++;
+		numa->access_cycles += numa->config.local_latency;
+		return 0;
+	}
+
+	numa->remote_accesses++;
+	numa->node_remote[node]++;
+	numa->process_remote[pid]++;
+	numa->access_cycles += numa->config.remote_latency;
+
+	return numa->config.migrate_threshold > 0 && ++numa->remote_hits[frame] >= numa->config.migrate_threshold;
+}
+
+void numa_migrated (numa_t* numa, ullong_t from, ullong_t to)
+{
+	numa->migrations++;
+	numa->node_migrated_out[numa_node_of(numa, from)]++;
+	numa->node_migrated_in[numa_node_of(numa, to)]++;
+	numa->remote_hits[from] = 0;
+	numa->remote_hits[to] = 0;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_numa_stats (numa_t* numa, frame_allocator_t* frames)
+{
+	numa_config_t* config = &numa->config;
+	ullong_t accesses = numa->local_accesses + numa->remote_accesses;
+	ullong_t migrated_bytes = numa->migrations * geometry.page_size;
+
+	/* Every line of the page is read from the old node once */
+	ullong_t migration_cycles = numa->migrations * (geometry.page_size / CACHE_LINE_SIZE) * config->remote_latency;
+
+	printf("%s", TABLE_NUMA_HEADER);
+	printf("Nodes:\t\t\t%d (%'llu frames each)\n", config->node_count, numa->frames_per_node);
+	printf("Placement:\t\t%s\n", NUMA_POLICY_NAMES[config->policy]);
+	printf("Latency:\t\t%'llu local / %'llu remote (cycles)\n", config->local_latency, config->remote_latency);
+	printf("Local Accesses:\t\t%'llu (%.2f%%)\n", numa->local_accesses, accesses ? 100.0 * numa->local_accesses / accesses : 0.0);
+	printf("Remote Accesses:\t%'llu (%.2f%%)\n", numa->remote_accesses, accesses ? 100.0 * numa->remote_accesses / accesses : 0.0);
+	printf("Avg. Access Latency:\t%.2f (cycles)\n", accesses ? (double) numa->access_cycles / accesses : 0.0);
+
+	if (config->migrate_threshold > 0)
+	{
+		printf("Migrations:\t\t%'llu (after %'llu remote accesses, %'llu failed on a full node)\n", numa->migrations, config->migrate_threshold, numa->migration_failures);
+		printf("Migration Traffic:\t%'llu (bytes, ~%'llu cycles)\n", migrated_bytes, migration_cycles);
+	}
+
+	for (int node = 0; node < config->node_count; ++node)
+	{
+		ullong_t first_frame = node * numa->frames_per_node;
+		ullong_t end_frame = (node == config->node_count - 1) ? geometry.frame_count : first_frame + numa->frames_per_node;
+		ullong_t used = 0;
+
+		for (ullong_t frame = first_frame; frame < end_frame; ++frame)
+			used += !frame_allocator_is_free(frames, frame);
+
+		printf("[Node %d]\t\tUsed: %'llu/%'llu\tPlaced: %'llu (%'llu spilled)\tLocal: %'llu\tRemote: %'llu\tIn: %'llu\tOut: %'llu\n", node, used, end_frame - first_frame,
+			numa->node_allocations[node], numa->node_fallbacks[node], numa->node_local[node], numa->node_remote[node],
+			numa->node_migrated_in[node], numa->node_migrated_out[node]);
+	}
+
+	for (int pid = 0; pid < MAX_PROCESSES; ++pid)
+	{
+		ullong_t total = numa->process_local[pid] + numa->process_remote[pid];
+
+		if (total > 0)
+			printf("[PID %d]\t\t\tNode: %d\tLocal: %'llu\tRemote: %'llu (%.2f%%)\n", pid, numa_home_node(numa, pid), numa->process_local[pid], numa->process_remote[pid], 100.0 * numa->process_remote[pid] / total);
+	}
+
+	print_header_end('=', strlen(TABLE_NUMA_HEADER));
+}
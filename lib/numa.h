@@ -0,0 +1,74 @@
+#ifndef NUMAH
+#define NUMAH
+
+#include "utils.h"
+#include "frame_allocator.h"
+
+enum numa_policy
+{
+    NUMA_FIRST_TOUCH,       /* Node of the faulting process */
+    NUMA_INTERLEAVE,        /* Pages round-robin over the nodes */
+    NUMA_PREFERRED          /* One node for everyone, the others once it's full */
+};
+
+typedef struct numa_config
+{
+    int             node_count;
+    ullong_t        local_latency;      /* Cycles per access to the process' own node */
+    ullong_t        remote_latency;     /* Cycles per access to any other node */
+    int             policy;
+    int             preferred_node;     /* NUMA_PREFERRED's node */
+    ullong_t        migrate_threshold;  /* Remote accesses before a page follows its process [0 => Off] */
+    int*            bind;               /* Pid -> Home node, NULL => Unbound */
+    int             bind_count;         /* Pids bound explicitly, the rest take pid % node_count */
+} numa_config_t;
+
+/*
+    NUMA model over the flat frame range. Physical memory is split into
+    node_count runs of frames of the same size [The last one takes any
+    remainder], every process runs on a home node & every access costs the
+    local or the remote latency depending on where its frame is. Data pages
+    are placed by policy & fall back to the next node with a free frame.
+    With migration on, a private page accessed remotely migrate_threshold
+    times is copied to a frame on its process' node.
+*/
+typedef struct numa
+{
+    numa_config_t   config;
+    ullong_t        frames_per_node;
+    uint_t*         remote_hits;        /* Frame -> Remote accesses since its page got there */
+
+    ullong_t*       node_allocations;   /* Node -> Data pages placed on it */
+    ullong_t*       node_fallbacks;     /* Node -> Pages that wanted it but went elsewhere */
+    ullong_t*       node_local;         /* Node -> Accesses from its own processes */
+    ullong_t*       node_remote;        /* Node -> Accesses from other nodes' processes */
+    ullong_t*       node_migrated_in;
+    ullong_t*       node_migrated_out;
+    ullong_t*       process_local;      /* Pid -> Accesses to its home node */
+    ullong_t*       process_remote;
+
+    ullong_t        local_accesses;
+    ullong_t        remote_accesses;
+    ullong_t        access_cycles;      /* Modeled memory latency of every access */
+    ullong_t        migrations;
+    ullong_t        migration_failures; /* Home node had no free frame */
+} numa_t;
+
+// Initialization
+void init_numa_config (numa_config_t* config);
+int parse_numa_config (const char* spec, numa_config_t* config);
+numa_t* create_numa (numa_config_t* config);
+void free_numa (numa_t* numa);
+
+// Operational
+int numa_node_of (numa_t* numa, ullong_t frame);
+int numa_home_node (numa_t* numa, int pid);
+long long numa_allocate (numa_t* numa, frame_allocator_t* frames, int pid, ullong_t virtual_page_number);
+long long numa_allocate_on (numa_t* numa, frame_allocator_t* frames, int node);
+int numa_access (numa_t* numa, int pid, ullong_t frame);
+void numa_migrated (numa_t* numa, ullong_t from, ullong_t to);
+
+// Debugging
+void print_numa_stats (numa_t* numa, frame_allocator_t* frames);
+
+#endif
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "page_map.h"
+
+static ullong_t PAGE_MAP_MIN_CAPACITY = 64;
+
+// Source: https://github.com/skeeto/hash-prospector [splitmix64 finalizer]
+static inline ullong_t hash_key (ullong_t key)
+{
+	key ^= key >> 30;
+	key *= 0xBF58476D1CE4E5B9ULL;
+	key ^= key >> 27;
+	key *= 0x94D049BB133111EBULL;
+	key ^= key >> 31;
+
+	return key;
+}
+
+/*=============================== INITIALIZATION ===============================*/
+page_map_t* create_page_map (ullong_t capacity)
+{
+	ullong_t size = PAGE_MAP_MIN_CAPACITY;
+
+	/* Capacity is kept a power of 2 so the hash can be masked */
+	while (size < capacity)
+		size <<= 1;
+
+	page_map_t* map = calloc(1, sizeof(page_map_t));
+	map->capacity 	= size;
+	map->keys 		= malloc(size * sizeof(ullong_t));
+	map->values 	= malloc(size * sizeof(long long));
+	map->used 		= calloc(size, sizeof(uchar_t));
+
+	return map;
+}
+
+void free_page_map (page_map_t* map)
+{
+	if (!map)
+		return;
+
+	free(map->keys);
+	free(map->values);
+	free(map->used);
+	free(map);
+}
+
+/*================================= OPERATIONAL ================================*/
+static ullong_t find_slot (page_map_t* map, ullong_t key)
+{
+	ullong_t mask = map->capacity - 1;
+	ullong_t slot = hash_key(key) & mask;
+
+	while (map->used[slot] && map->keys[slot] != key)
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+static void grow_page_map (page_map_t* map)
+{
+	page_map_t* grown = create_page_map(map->capacity * 2);
+
+	for (ullong_t i = 0; i < map->capacity; ++i)
+	{
+		if (map->used[i])
+			page_map_put(grown, map->keys[i], map->values[i]);
+	}
+
+	free(map->keys);
+	free(map->values);
+	free(map->used);
+	*map = *grown;
+	free(grown);
+}
+
+long long page_map_get (page_map_t* map, ullong_t key, long long missing)
+{
+	ullong_t slot = find_slot(map, key);
+
+	return map->used[slot] ? map->values[slot] : missing;
+}
+
+void page_map_put (page_map_t* map, ullong_t key, long long value)
+{
+	/* Keep load factor under 3/4 */
+	if ((map->count + 1) * 4 > map->capacity * 3)
+		grow_page_map(map);
+
+	ullong_t slot = find_slot(map, key);
+
+	if (!map->used[slot])
+	{
+		map->used[slot] = 1;
+		map->keys[slot] = key;
+		map->count++;
+	}
+
+	map->values[slot] = value;
+}
+
+void page_map_remove (page_map_t* map, ullong_t key)
+{
+	ullong_t mask = map->capacity - 1;
+	ullong_t slot = find_slot(map, key);
+
+	if (!map->used[slot])
+		return;
+
+	map->used[slot] = 0;
+	map->count--;
+
+	/* Backward shift deletion keeps probe chains intact without tombstones */
+	ullong_t next = (slot + 1) & mask;
+
+	while (map->used[next])
+	{
+		ullong_t home = hash_key(map->keys[next]) & mask;
+
+		if (((next - home) & mask) >= ((next - slot) & mask))
+		{
+			map->keys[slot] = map->keys[next];
+			map->values[slot] = map->values[next];
+			map->used[slot] = 1;
+			map->used[next] = 0;
+			slot = next;
+		}
+
+		next = (next + 1) & mask;
+	}
+}
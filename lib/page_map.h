@@ -0,0 +1,25 @@
+#ifndef PAGEMAPH
+#define PAGEMAPH
+
+#include "utils.h"
+
+/* Sparse virtual page -> value map [Open addressing, linear probing] */
+typedef struct page_map
+{
+    ullong_t*   keys;
+    long long*  values;
+    uchar_t*    used;
+    ullong_t    capacity;
+    ullong_t    count;
+} page_map_t;
+
+// Initialization
+page_map_t* create_page_map (ullong_t capacity);
+void free_page_map (page_map_t* map);
+
+// Operational
+long long page_map_get (page_map_t* map, ullong_t key, long long missing);
+void page_map_put (page_map_t* map, ullong_t key, long long value);
+void page_map_remove (page_map_t* map, ullong_t key);
+
+#endif
@@ -0,0 +1,621 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "paging.h"
+#include "page_table.h"
+
+#define NODE_PRESENT		0x0001
+#define IPT_NONE			0xFFFFFFFFULL
+#define IPT_ANCHOR_SIZE		4
+#define IPT_ENTRY_SIZE		16			/* [PID x2][Control][Valid][Next x4][VPN x8] */
+
+static const char* PAGE_TABLE_NAMES[] = { "LINEAR", "RADIX-2", "RADIX-4", "INVERTED" };
+
+/* Little-endian value of size bytes, entries are only byte aligned */
+static inline ullong_t read_value (char* physical_memory, paddr_t address, int size)
+{
+	ullong_t value = 0;
+
+	for (int i = size - 1; i >= 0; --i)
+		value = (value << 8) | (uchar_t) physical_memory[address + i];
+
+	return value;
+}
+
+static inline void write_value (char* physical_memory, paddr_t address, int size, ullong_t value)
+{
+	for (int i = 0; i < size; ++i)
+	{
+		physical_memory[address + i] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+/* A hardware walk reads its entries through the pager's data caches, software lookups don't */
+static inline void walk_reference (page_table_t* page_table, paddr_t address, int* references)
+{
+	(*references)++;
+
+	if (page_table->walking && page_table->pager && page_table->pager->cache)
+		cache_access(page_table->pager->cache, address, 0, CACHE_TABLE);
+}
+
+static void track_frames (page_table_t* page_table, paddr_t base, ullong_t count)
+{
+	page_table->frames = realloc(page_table->frames, (page_table->frame_count + count) * sizeof(ullong_t));
+
+	for (ullong_t i = 0; i < count; ++i)
+		page_table->frames[page_table->frame_count++] = (base >> geometry.page_shift) + i;
+}
+
+/*=================================== LINEAR ===================================*/
+/*
+	One entry per virtual page: [Physical Frame Number][Control Bits], the
+	frame number takes every byte of the entry but the last.
+*/
+static int linear_lookup (page_table_t* page_table, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t** control_bits)
+{
+	int size = page_table->entry_size;
+	int references = 0;
+	paddr_t address = page_table->base + (virtual_page_number * size);
+
+	walk_reference(page_table, address, &references);
+
+	*frame_number = read_value(page_table->physical_memory, address, size - 1);
+	*control_bits = (uchar_t*) &page_table->physical_memory[address + size - 1];
+
+	return references;
+}
+
+static int linear_map (page_table_t* page_table, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	int size = page_table->entry_size;
+	paddr_t address = page_table->base + (virtual_page_number * size);
+
+	write_value(page_table->physical_memory, address, size - 1, frame_number);
+	page_table->physical_memory[address + size - 1] = control_bits;
+
+	return 0;
+}
+
+static void linear_unmap (page_table_t* page_table, ullong_t virtual_page_number)
+{
+	linear_map(page_table, virtual_page_number, 0x00, 0x00);
+}
+
+static void linear_for_each (page_table_t* page_table, page_table_visit_t visit, void* context)
+{
+	int size = page_table->entry_size;
+
+	for (ullong_t page = 0; page < geometry.virtual_page_count; ++page)
+	{
+		paddr_t address = page_table->base + (page * size);
+		ullong_t frame_number = read_value(page_table->physical_memory, address, size - 1);
+		uchar_t control_bits = page_table->physical_memory[address + size - 1];
+
+		if (frame_number != 0 || control_bits != 0)
+			visit(context, page, frame_number, control_bits);
+	}
+}
+
+static const page_table_ops_t LINEAR_OPS = { linear_lookup, linear_map, linear_unmap, linear_for_each };
+
+/*=================================== RADIX ====================================*/
+/*
+	Interior entries hold the physical address of the next level node with
+	NODE_PRESENT in bit 0 [Nodes are at least 2-byte aligned], leaf entries
+	use the same layout as the linear table. Nodes smaller than a page are
+	carved from a shared frame, larger ones get their own contiguous frames.
+*/
+static long long allocate_radix_node (page_table_t* page_table)
+{
+	ullong_t page_size = geometry.page_size;
+	ullong_t node_size = page_table->node_size;
+
+	if (node_size >= page_size)
+	{
+		ullong_t frames = node_size / page_size;
+		long long node = pager_allocate_table_frames(page_table->pager, frames);
+
+		if (node < 0)
+			return -1;
+
+		track_frames(page_table, node, frames);
+		page_table->table_bytes += node_size;
+
+		return node;
+	}
+
+	if (page_table->pool_address < 0 || page_table->pool_used + node_size > page_size)
+	{
+		long long frame_address = pager_allocate_table_frames(page_table->pager, 1);
+
+		if (frame_address < 0)
+			return -1;
+
+		track_frames(page_table, frame_address, 1);
+		page_table->pool_address = frame_address;
+		page_table->pool_used = 0;
+	}
+
+	long long node = page_table->pool_address + page_table->pool_used;
+
+	page_table->pool_used += node_size;
+	page_table->table_bytes += node_size;
+	memset(&page_table->physical_memory[node], 0x00, node_size);
+
+	return node;
+}
+
+/* Returns the physical address of the leaf entry, or -1 if an interior node is missing */
+static long long radix_walk (page_table_t* page_table, ullong_t virtual_page_number, int allocate, int* references)
+{
+	char* physical_memory = page_table->physical_memory;
+	int size = page_table->entry_size;
+	ullong_t index_mask = (1ULL << page_table->bits_per_level) - 1;
+	paddr_t node = page_table->base;
+
+	for (int level = 0; level < page_table->levels; ++level)
+	{
+		int shift = (page_table->levels - 1 - level) * page_table->bits_per_level;
+		paddr_t entry = node + (((virtual_page_number >> shift) & index_mask) * size);
+
+		walk_reference(page_table, entry, references);
+
+		if (level == page_table->levels - 1)
+			return entry;
+
+		ullong_t next = read_value(physical_memory, entry, size);
+
+		if ((next & NODE_PRESENT) == 0)
+		{
+			if (!allocate)
+				return -1;
+
+			long long child = allocate_radix_node(page_table);
+
+			if (child < 0)
+				return -1;
+
+			next = child | NODE_PRESENT;
+			write_value(physical_memory, entry, size, next);
+		}
+
+		node = next & ~(ullong_t) NODE_PRESENT;
+	}
+
+	return -1;
+}
+
+static int radix_lookup (page_table_t* page_table, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t** control_bits)
+{
+	int size = page_table->entry_size;
+	int references = 0;
+	long long entry = radix_walk(page_table, virtual_page_number, 0, &references);
+
+	*frame_number = (entry < 0) ? 0 : read_value(page_table->physical_memory, entry, size - 1);
+	*control_bits = (entry < 0) ? NULL : (uchar_t*) &page_table->physical_memory[entry + size - 1];
+
+	return references;
+}
+
+static int radix_map (page_table_t* page_table, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	int size = page_table->entry_size;
+	int references = 0;
+	long long entry = radix_walk(page_table, virtual_page_number, 1, &references);
+
+	if (entry < 0)
+		return -1;
+
+	write_value(page_table->physical_memory, entry, size - 1, frame_number);
+	page_table->physical_memory[entry + size - 1] = control_bits;
+
+	return 0;
+}
+
+static void radix_unmap (page_table_t* page_table, ullong_t virtual_page_number)
+{
+	int references = 0;
+	long long entry = radix_walk(page_table, virtual_page_number, 0, &references);
+
+	if (entry >= 0)
+		memset(&page_table->physical_memory[entry], 0x00, page_table->entry_size);
+}
+
+/* Only descends into nodes that exist, so sparse address spaces stay cheap to walk */
+static void radix_visit_node (page_table_t* page_table, paddr_t node, int level, ullong_t prefix, page_table_visit_t visit, void* context)
+{
+	char* physical_memory = page_table->physical_memory;
+	int size = page_table->entry_size;
+	ullong_t entries = 1ULL << page_table->bits_per_level;
+
+	for (ullong_t index = 0; index < entries; ++index)
+	{
+		paddr_t entry = node + (index * size);
+		ullong_t page = (prefix << page_table->bits_per_level) | index;
+
+		if (level < page_table->levels - 1)
+		{
+			ullong_t next = read_value(physical_memory, entry, size);
+
+			if ((next & NODE_PRESENT) != 0)
+				radix_visit_node(page_table, next & ~(ullong_t) NODE_PRESENT, level + 1, page, visit, context);
+
+			continue;
+		}
+
+		ullong_t frame_number = read_value(physical_memory, entry, size - 1);
+		uchar_t control_bits = physical_memory[entry + size - 1];
+
+		if ((frame_number != 0 || control_bits != 0) && page < geometry.virtual_page_count)
+			visit(context, page, frame_number, control_bits);
+	}
+}
+
+static void radix_for_each (page_table_t* page_table, page_table_visit_t visit, void* context)
+{
+	radix_visit_node(page_table, page_table->base, 0, 0, visit, context);
+}
+
+static const page_table_ops_t RADIX_OPS = { radix_lookup, radix_map, radix_unmap, radix_for_each };
+
+/*================================== INVERTED ==================================*/
+/*
+	One table shared by every process with an entry per physical frame,
+	found through a hash anchor table of one chain head per frame. Only
+	resident pages have entries, swapped pages are tracked by the pager.
+*/
+static inline paddr_t ipt_entry (page_table_t* page_table, ullong_t frame)
+{
+	return page_table->base + (geometry.frame_count * IPT_ANCHOR_SIZE) + (frame * IPT_ENTRY_SIZE);
+}
+
+static inline paddr_t ipt_anchor (page_table_t* page_table, ullong_t virtual_page_number)
+{
+	return page_table->base + ((((page_table->pid * 31ULL) + virtual_page_number) % geometry.frame_count) * IPT_ANCHOR_SIZE);
+}
+
+/* Returns the frame holding the page or -1, previous_frame is the chain predecessor */
+static long long ipt_find (page_table_t* page_table, ullong_t virtual_page_number, long long* previous_frame, int* references)
+{
+	char* physical_memory = page_table->physical_memory;
+	ullong_t frame = read_value(physical_memory, ipt_anchor(page_table, virtual_page_number), IPT_ANCHOR_SIZE);
+
+	*previous_frame = -1;
+	walk_reference(page_table, ipt_anchor(page_table, virtual_page_number), references);
+
+	while (frame != IPT_NONE)
+	{
+		paddr_t entry = ipt_entry(page_table, frame);
+
+		walk_reference(page_table, entry, references);
+
+		if (read_value(physical_memory, entry, 2) == (ullong_t) page_table->pid && read_value(physical_memory, entry + 8, 8) == virtual_page_number)
+			return frame;
+
+		*previous_frame = frame;
+		frame = read_value(physical_memory, entry + 4, 4);
+	}
+
+	return -1;
+}
+
+static int inverted_lookup (page_table_t* page_table, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t** control_bits)
+{
+	int references = 0;
+	long long previous_frame;
+	long long frame = ipt_find(page_table, virtual_page_number, &previous_frame, &references);
+
+	*frame_number = (frame < 0) ? 0 : frame;
+	*control_bits = (frame < 0) ? NULL : (uchar_t*) &page_table->physical_memory[ipt_entry(page_table, frame) + 2];
+
+	return references;
+}
+
+static void inverted_unmap (page_table_t* page_table, ullong_t virtual_page_number)
+{
+	char* physical_memory = page_table->physical_memory;
+	int references = 0;
+	long long previous_frame;
+	long long frame = ipt_find(page_table, virtual_page_number, &previous_frame, &references);
+
+	if (frame < 0)
+		return;
+
+	paddr_t entry = ipt_entry(page_table, frame);
+	ullong_t next = read_value(physical_memory, entry + 4, 4);
+
+	/* Unlink from the hash chain */
+	if (previous_frame < 0)
+		write_value(physical_memory, ipt_anchor(page_table, virtual_page_number), IPT_ANCHOR_SIZE, next);
+	else
+		write_value(physical_memory, ipt_entry(page_table, previous_frame) + 4, 4, next);
+
+	memset(&physical_memory[entry], 0x00, IPT_ENTRY_SIZE);
+}
+
+static int inverted_map (page_table_t* page_table, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	char* physical_memory = page_table->physical_memory;
+
+	inverted_unmap(page_table, virtual_page_number);
+
+	/* Non-resident pages have no frame and therefore no entry */
+	if ((control_bits & C_PRESENT) == 0)
+		return 0;
+
+	paddr_t entry = ipt_entry(page_table, frame_number);
+	paddr_t anchor = ipt_anchor(page_table, virtual_page_number);
+
+	write_value(physical_memory, entry, 2, page_table->pid);
+	physical_memory[entry + 2] = control_bits;
+	physical_memory[entry + 3] = 0x01;
+	write_value(physical_memory, entry + 4, 4, read_value(physical_memory, anchor, IPT_ANCHOR_SIZE));
+	write_value(physical_memory, entry + 8, 8, virtual_page_number);
+	write_value(physical_memory, anchor, IPT_ANCHOR_SIZE, frame_number);
+
+	return 0;
+}
+
+static void inverted_for_each (page_table_t* page_table, page_table_visit_t visit, void* context)
+{
+	char* physical_memory = page_table->physical_memory;
+
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		paddr_t entry = ipt_entry(page_table, frame);
+
+		if (physical_memory[entry + 3] && read_value(physical_memory, entry, 2) == (ullong_t) page_table->pid)
+			visit(context, read_value(physical_memory, entry + 8, 8), frame, physical_memory[entry + 2]);
+	}
+}
+
+static const page_table_ops_t INVERTED_OPS = { inverted_lookup, inverted_map, inverted_unmap, inverted_for_each };
+
+/*=============================== INITIALIZATION ===============================*/
+page_table_t* create_page_table (int type, pager_t* pager, int pid)
+{
+	ullong_t page_size = geometry.page_size;
+
+	page_table_t* page_table = calloc(1, sizeof(page_table_t));
+	page_table->type 			= type;
+	page_table->pager 			= pager;
+	page_table->physical_memory = pager->physical_memory;
+	page_table->pid 			= pid;
+	page_table->entry_size 		= geometry.pte_size;
+	page_table->pool_address 	= -1;
+	page_table->base 			= -1;
+
+	switch (type)
+	{
+		case PT_RADIX_2:
+		case PT_RADIX_4:
+			page_table->ops 			= &RADIX_OPS;
+			page_table->levels 			= (type == PT_RADIX_2) ? 2 : 4;
+			page_table->bits_per_level 	= (geometry.vpn_bits + page_table->levels - 1) / page_table->levels;
+			page_table->node_size 		= (1ULL << page_table->bits_per_level) * page_table->entry_size;
+			page_table->base 			= allocate_radix_node(page_table);
+			break;
+
+		case PT_INVERTED:
+			page_table->ops = &INVERTED_OPS;
+
+			/* First inverted table allocates the shared structure, the rest reuse it */
+			if (pager->inverted_table_base < 0)
+			{
+				ullong_t anchors = geometry.frame_count * IPT_ANCHOR_SIZE;
+				ullong_t size = anchors + (geometry.frame_count * IPT_ENTRY_SIZE);
+				ullong_t frames = (size + page_size - 1) / page_size;
+				long long base = pager_allocate_table_frames(pager, frames);
+
+				if (base >= 0)
+				{
+					memset(&pager->physical_memory[base], 0xFF, anchors);
+					memset(&pager->physical_memory[base + anchors], 0x00, geometry.frame_count * IPT_ENTRY_SIZE);
+					page_table->table_bytes = size;
+					track_frames(page_table, base, frames);
+				}
+
+				pager->inverted_table_base = base;
+			}
+
+			page_table->base = pager->inverted_table_base;
+			break;
+
+		case PT_LINEAR:
+		default:
+		{
+			ullong_t size = geometry.virtual_page_count * page_table->entry_size;
+			ullong_t frames = (size + page_size - 1) / page_size;
+
+			page_table->ops = &LINEAR_OPS;
+
+			/* Wide virtual address spaces need a sparse structure [At least one frame must be left for data] */
+			if (frames >= pager->frames->free_count)
+			{
+				printf("%s - Linear Page Table Needs %'llu Frames, Use A Radix Table...\n", ERROR_PRINT_TAG, frames);
+				break;
+			}
+
+			page_table->base 		= pager_allocate_table_frames(pager, frames);
+			page_table->table_bytes = size;
+
+			if (page_table->base >= 0)
+				track_frames(page_table, page_table->base, frames);
+			break;
+		}
+	}
+
+	if (page_table->base < 0)
+	{
+		printf("%s - Failed To Allocate %s Page Table...\n", ERROR_PRINT_TAG, PAGE_TABLE_NAMES[type]);
+		free_page_table(page_table);
+		return NULL;
+	}
+
+	return page_table;
+}
+
+/* Wrap a linear table that was already written into physical memory [Default geometry only] */
+page_table_t* create_linear_page_table_at (pager_t* pager, int pid, long long base)
+{
+	page_table_t* page_table = calloc(1, sizeof(page_table_t));
+	page_table->type 			= PT_LINEAR;
+	page_table->ops 			= &LINEAR_OPS;
+	page_table->pager 			= pager;
+	page_table->physical_memory = pager->physical_memory;
+	page_table->pid 			= pid;
+	page_table->entry_size 		= geometry.pte_size;
+	page_table->base 			= base;
+	page_table->pool_address 	= -1;
+	page_table->table_bytes 	= PAGE_TABLE_SIZE;
+
+	track_frames(page_table, base, PAGE_TABLE_SIZE / PAGE_SIZE);
+
+	return page_table;
+}
+
+/* Read-only view of a table found in a memory image, i.e. a snapshot [No pager, can't grow] */
+page_table_t* attach_page_table (int type, char* physical_memory, int pid, long long base)
+{
+	page_table_t* page_table = calloc(1, sizeof(page_table_t));
+	page_table->type 			= type;
+	page_table->physical_memory = physical_memory;
+	page_table->pid 			= pid;
+	page_table->entry_size 		= geometry.pte_size;
+	page_table->base 			= base;
+	page_table->pool_address 	= -1;
+
+	switch (type)
+	{
+		case PT_RADIX_2:
+		case PT_RADIX_4:
+			page_table->ops 			= &RADIX_OPS;
+			page_table->levels 			= (type == PT_RADIX_2) ? 2 : 4;
+			page_table->bits_per_level 	= (geometry.vpn_bits + page_table->levels - 1) / page_table->levels;
+			page_table->node_size 		= (1ULL << page_table->bits_per_level) * page_table->entry_size;
+			break;
+
+		case PT_INVERTED:
+			page_table->ops = &INVERTED_OPS;
+			break;
+
+		case PT_LINEAR:
+		default:
+			page_table->ops = &LINEAR_OPS;
+			break;
+	}
+
+	return page_table;
+}
+
+void free_page_table (page_table_t* page_table)
+{
+	if (!page_table)
+		return;
+
+	/* Shared inverted table frames stay with the pager */
+	if (page_table->type != PT_INVERTED)
+	{
+		for (int i = 0; i < page_table->frame_count; ++i)
+			pager_release_frames(page_table->pager, page_table->frames[i], 1);
+	}
+
+	free(page_table->frames);
+	free(page_table);
+}
+
+int parse_page_table_type (const char* name)
+{
+	for (int i = 0; i < (int) (sizeof(PAGE_TABLE_NAMES) / sizeof(PAGE_TABLE_NAMES[0])); ++i)
+	{
+		if (strcasecmp(name, PAGE_TABLE_NAMES[i]) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+const char* get_page_table_name (int type)
+{
+	return PAGE_TABLE_NAMES[type];
+}
+
+/*================================= OPERATIONAL ================================*/
+/* Hardware walk: Counts memory references & sets C_ACCESSED [C_DIRTY on write] */
+int page_table_translate (page_table_t* page_table, vaddr_t input_address, int is_write, translation_t* translation)
+{
+	ullong_t frame_number;
+	uchar_t* control_bits;
+	ullong_t virtual_page_number = input_address >> GEO_PAGE_SHIFT;
+	ullong_t page_offset = input_address & GEO_OFFSET_MASK;
+
+	page_table->walking = 1;
+
+	int references = page_table->ops->lookup(page_table, virtual_page_number, &frame_number, &control_bits);
+
+	page_table->walking = 0;
+	page_table->walks++;
+	page_table->references += references;
+
+	translation->input_address 			= input_address;
+	translation->virtual_page_number 	= virtual_page_number;
+	translation->page_offset 			= page_offset;
+	translation->control_bits 			= control_bits ? *control_bits : 0x00;
+	translation->physical_frame_number 	= frame_number;
+	translation->physical_address 		= (frame_number << GEO_PAGE_SHIFT) | page_offset;
+	translation->memory_references 		= references;
+
+	if ((translation->control_bits & C_PRESENT) != 0)
+	{
+		*control_bits |= is_write ? (C_ACCESSED | C_DIRTY) : C_ACCESSED;
+		return T_MAPPED;
+	}
+
+	if ((translation->control_bits & C_DISK) != 0)
+		return T_ON_DISK;
+
+	return T_UNMAPPED;
+}
+
+/* Software access from the OS side, not counted as a walk */
+int page_table_get (page_table_t* page_table, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t* control_bits)
+{
+	uchar_t* control;
+
+	page_table->ops->lookup(page_table, virtual_page_number, frame_number, &control);
+	*control_bits = control ? *control : 0x00;
+
+	return control ? 0 : -1;
+}
+
+uchar_t* page_table_control (page_table_t* page_table, ullong_t virtual_page_number)
+{
+	ullong_t frame_number;
+	uchar_t* control;
+
+	page_table->ops->lookup(page_table, virtual_page_number, &frame_number, &control);
+
+	return control;
+}
+
+int page_table_map (page_table_t* page_table, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	return page_table->ops->map(page_table, virtual_page_number, frame_number, control_bits);
+}
+
+void page_table_unmap (page_table_t* page_table, ullong_t virtual_page_number)
+{
+	page_table->ops->unmap(page_table, virtual_page_number);
+}
+
+/* Visits every non-empty entry in virtual page order [Frame order for inverted tables] */
+void page_table_for_each (page_table_t* page_table, page_table_visit_t visit, void* context)
+{
+	page_table->ops->for_each(page_table, visit, context);
+}
@@ -0,0 +1,73 @@
+#ifndef PAGETABLEH
+#define PAGETABLEH
+
+#include "utils.h"
+
+struct pager;
+
+/* Page table structures */
+#define PT_LINEAR           0
+#define PT_RADIX_2          1
+#define PT_RADIX_4          2
+#define PT_INVERTED         3
+
+typedef struct page_table page_table_t;
+
+/* Called for every non-empty entry by page_table_for_each() */
+typedef void (*page_table_visit_t) (void* context, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits);
+
+/*
+    Every structure stores its entries in simulated physical memory and
+    implements the same operations, lookups return the number of memory
+    references the walk needed.
+*/
+typedef struct page_table_ops
+{
+    int         (*lookup)   (page_table_t* page_table, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t** control_bits);
+    int         (*map)      (page_table_t* page_table, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits);
+    void        (*unmap)    (page_table_t* page_table, ullong_t virtual_page_number);
+    void        (*for_each) (page_table_t* page_table, page_table_visit_t visit, void* context);
+} page_table_ops_t;
+
+struct page_table
+{
+    int                     type;
+    const page_table_ops_t* ops;
+    struct pager*           pager;
+    char*                   physical_memory;
+    int                     pid;
+    int                     entry_size;         /* Bytes per entry [geometry.pte_size] */
+    long long               base;               /* Linear: Table, Radix: Root node, Inverted: Shared table */
+
+    int                     levels;             /* Radix only */
+    int                     bits_per_level;
+    ullong_t                node_size;
+    long long               pool_address;       /* Radix: Frame nodes are currently carved from */
+    ullong_t                pool_used;
+
+    ullong_t*               frames;             /* Frames holding this table */
+    int                     frame_count;
+    unsigned long           table_bytes;        /* Simulated memory used by entries & nodes */
+
+    int                     walking;            /* Inside page_table_translate(), references go through the pager's caches */
+    unsigned long           walks;
+    unsigned long           references;
+};
+
+// Initialization
+page_table_t* create_page_table (int type, struct pager* pager, int pid);
+page_table_t* create_linear_page_table_at (struct pager* pager, int pid, long long base);
+page_table_t* attach_page_table (int type, char* physical_memory, int pid, long long base);
+void free_page_table (page_table_t* page_table);
+int parse_page_table_type (const char* name);
+const char* get_page_table_name (int type);
+
+// Operational
+int page_table_translate (page_table_t* page_table, vaddr_t input_address, int is_write, translation_t* translation);
+int page_table_get (page_table_t* page_table, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t* control_bits);
+uchar_t* page_table_control (page_table_t* page_table, ullong_t virtual_page_number);
+int page_table_map (page_table_t* page_table, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits);
+void page_table_unmap (page_table_t* page_table, ullong_t virtual_page_number);
+void page_table_for_each (page_table_t* page_table, page_table_visit_t visit, void* context);
+
+#endif
@@ -0,0 +1,1489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_map.h"
+#include "tlb.h"
+#include "process.h"
+#include "page_table.h"
+#include "paging.h"
+#include "metrics.h"
+#include "events.h"
+
+#define NEVER_USED			ULONG_MAX
+
+static const char* REPLACEMENT_POLICY_NAMES[] = { "FIFO", "LRU", "CLOCK", "NRU", "OPTIMAL" };
+
+static long long evict_frame (pager_t* pager, process_t* owner);
+static void count_resident (pager_t* pager, process_t* process, ullong_t virtual_page_number, int delta);
+
+/* Resident frames the frame limit applies to: Merged frames belong to no process & are never evicted */
+static inline int limited_frames (pager_t* pager)
+{
+	return pager->resident_count - (pager->ksm ? (int) pager->ksm->merged_frames : 0);
+}
+
+/* Bits every new mapping of the page starts with, C_CACHEDISABLED inside the caches' uncached range */
+static inline uchar_t page_attributes (pager_t* pager, ullong_t virtual_page_number)
+{
+	return (pager->cache && cache_is_uncached_page(pager->cache, virtual_page_number)) ? C_CACHEDISABLED : 0x00;
+}
+
+static void clear_frame_list (frame_list_t* list)
+{
+	list->oldest 	= -1;
+	list->newest 	= -1;
+	list->hand 		= -1;
+	list->count 	= 0;
+}
+
+/* Put the frame in the list just older than at [-1 => As the newest] */
+static void link_frame (frame_list_t* list, long long* older, long long* newer, long long frame, long long at)
+{
+	long long previous = (at >= 0) ? older[at] : list->newest;
+
+	older[frame] = previous;
+	newer[frame] = at;
+
+	if (previous >= 0)
+		newer[previous] = frame;
+	else
+		list->oldest = frame;
+
+	if (at >= 0)
+		older[at] = frame;
+	else
+		list->newest = frame;
+
+	list->count++;
+}
+
+static void unlink_frame (frame_list_t* list, long long* older, long long* newer, long long frame)
+{
+	if (older[frame] >= 0)
+		newer[older[frame]] = newer[frame];
+	else
+		list->oldest = newer[frame];
+
+	if (newer[frame] >= 0)
+		older[newer[frame]] = older[frame];
+	else
+		list->newest = older[frame];
+
+	if (list->hand == frame)
+		list->hand = newer[frame];
+
+	list->count--;
+}
+
+/* A new frame goes where the hand looks last under CLOCK, in as the newest otherwise */
+static inline long long insert_point (pager_t* pager, frame_list_t* list)
+{
+	return (pager->config.policy == PR_CLOCK) ? list->hand : -1;
+}
+
+/* Frame changes hands, NULL once no process owns it [Only owned frames are eviction candidates] */
+void pager_set_owner (pager_t* pager, ullong_t frame, process_t* process)
+{
+	process_t* owner = pager->frame_process[frame];
+
+	if (owner == process)
+		return;
+
+	if (owner)
+	{
+		owner->owned_count--;
+		unlink_frame(&owner->owned_frames, pager->older_owned, pager->newer_owned, frame);
+	}
+
+	/* First owner makes it a candidate, no owner takes it out again [Changing owners keeps its place] */
+	if (owner && !process)
+		unlink_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame);
+	else if (!owner)
+		link_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame, insert_point(pager, &pager->resident_frames));
+
+	if (process)
+	{
+		process->owned_count++;
+		link_frame(&process->owned_frames, pager->older_owned, pager->newer_owned, frame, insert_point(pager, &process->owned_frames));
+	}
+
+	pager->frame_process[frame] = process;
+}
+
+/* Most recently used from now on [LRU] */
+static void refresh_frame (pager_t* pager, ullong_t frame)
+{
+	process_t* owner = pager->frame_process[frame];
+
+	unlink_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame);
+	link_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame, -1);
+	unlink_frame(&owner->owned_frames, pager->older_owned, pager->newer_owned, frame);
+	link_frame(&owner->owned_frames, pager->older_owned, pager->newer_owned, frame, -1);
+}
+
+/* Target takes the frame's place in both orders along with its owner */
+static void move_frame (pager_t* pager, ullong_t frame, ullong_t target)
+{
+	process_t* owner = pager->frame_process[frame];
+
+	link_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, target, frame);
+	link_frame(&owner->owned_frames, pager->older_owned, pager->newer_owned, target, frame);
+
+	if (pager->resident_frames.hand == (long long) frame)
+		pager->resident_frames.hand = target;
+
+	if (owner->owned_frames.hand == (long long) frame)
+		owner->owned_frames.hand = target;
+
+	unlink_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame);
+	unlink_frame(&owner->owned_frames, pager->older_owned, pager->newer_owned, frame);
+
+	pager->frame_process[target] 	= owner;
+	pager->frame_process[frame] 	= NULL;
+}
+
+/*=============================== INITIALIZATION ===============================*/
+void init_pager_config (pager_config_t* config)
+{
+	config->policy 			= PR_CLOCK;
+	config->frame_limit 	= 0;
+	config->nru_interval 	= NRU_RESET_INTERVAL;
+	config->huge_order 		= 0;
+	config->promote_threshold = 0;
+}
+
+pager_t* create_pager (pager_config_t* config, char* physical_memory, char* disk_memory, tlb_t* tlb)
+{
+	printf("%s - Initializing Pager...\n", INIT_PRINT_TAG);
+
+	if (!physical_memory || !disk_memory)
+	{
+		printf("%s - Physical Or Disk Memory Not Defined...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	if (config->huge_order < 0 || config->huge_order > geometry.vpn_bits || (1ULL << config->huge_order) > geometry.frame_count)
+	{
+		printf("%s - Huge Pages Must Fit In Both Address Spaces...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	pager_t* pager = calloc(1, sizeof(pager_t));
+	pager->config 			= *config;
+	pager->physical_memory 	= physical_memory;
+	pager->disk_memory 		= disk_memory;
+	pager->tlb 				= tlb;
+	pager->frame_page 		= malloc(geometry.frame_count * sizeof(long long));
+	pager->frame_process 	= calloc(geometry.frame_count, sizeof(process_t*));
+	pager->loaded_at 		= calloc(geometry.frame_count, sizeof(unsigned long));
+	pager->last_used 		= calloc(geometry.frame_count, sizeof(unsigned long));
+	pager->disk_slot_used 	= calloc(geometry.disk_frame_count, sizeof(uchar_t));
+	pager->older_frame 		= malloc(geometry.frame_count * sizeof(long long));
+	pager->newer_frame 		= malloc(geometry.frame_count * sizeof(long long));
+	pager->frame_shared 	= calloc(geometry.frame_count, sizeof(uint_t));
+	pager->older_owned 		= malloc(geometry.frame_count * sizeof(long long));
+	pager->newer_owned 		= malloc(geometry.frame_count * sizeof(long long));
+	pager->frames 			= create_frame_allocator(geometry.frame_count);
+	pager->inverted_table_base = -1;
+
+	clear_frame_list(&pager->resident_frames);
+
+	if (pager->config.frame_limit <= 0 || (ullong_t) pager->config.frame_limit > geometry.frame_count)
+		pager->config.frame_limit = geometry.frame_count;
+
+	if (pager->config.huge_order > 0 && pager->config.promote_threshold <= 0)
+		pager->config.promote_threshold = ((1ULL << pager->config.huge_order) * HUGE_PROMOTE_PERCENT + 99) / 100;
+
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+		pager->frame_page[frame] = FRAME_FREE;
+
+	return pager;
+}
+
+void free_pager (pager_t* pager)
+{
+	if (!pager)
+		return;
+
+	free(pager->frame_page);
+	free(pager->frame_process);
+	free(pager->loaded_at);
+	free(pager->last_used);
+	free(pager->disk_slot_used);
+	free(pager->older_frame);
+	free(pager->newer_frame);
+	free(pager->frame_shared);
+	free(pager->older_owned);
+	free(pager->newer_owned);
+	free(pager->sharers);
+	free_frame_allocator(pager->frames);
+	free(pager);
+}
+
+int parse_replacement_policy (const char* name)
+{
+	for (int i = 0; i < (int) (sizeof(REPLACEMENT_POLICY_NAMES) / sizeof(REPLACEMENT_POLICY_NAMES[0])); ++i)
+	{
+		if (strcasecmp(name, REPLACEMENT_POLICY_NAMES[i]) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/* Take frames out of circulation [Page tables live in physical memory too] */
+int pager_reserve_frames (pager_t* pager, ullong_t first_frame, ullong_t count)
+{
+	if (frame_allocator_claim(pager->frames, first_frame, count) < 0)
+		return -1;
+
+	for (ullong_t frame = first_frame; frame < first_frame + count; ++frame)
+		pager->frame_page[frame] = FRAME_RESERVED;
+
+	return 0;
+}
+
+void pager_release_frames (pager_t* pager, ullong_t first_frame, ullong_t count)
+{
+	for (ullong_t frame = first_frame; frame < first_frame + count && frame < geometry.frame_count; ++frame)
+	{
+		if (pager->frame_page[frame] == FRAME_RESERVED)
+		{
+			pager->frame_page[frame] = FRAME_FREE;
+			frame_allocator_release(pager->frames, frame, 1);
+		}
+	}
+}
+
+/* Find a contiguous run of frames for page table memory, returns its physical address */
+long long pager_allocate_table_frames (pager_t* pager, ullong_t count)
+{
+	long long first_frame = frame_allocator_allocate_run(pager->frames, count, 1);
+
+	/* A single frame can always be made by evicting a page */
+	if (first_frame < 0 && count == 1)
+	{
+		first_frame = evict_frame(pager, NULL);
+
+		if (first_frame >= 0)
+			frame_allocator_claim(pager->frames, first_frame, 1);
+	}
+
+	for (ullong_t i = 0; first_frame >= 0 && i < count; ++i)
+		pager->frame_page[first_frame + i] = FRAME_RESERVED;
+
+	if (first_frame < 0)
+	{
+		printf("%s - No Contiguous Frames Left For A Page Table...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	memset(&pager->physical_memory[first_frame << geometry.page_shift], 0x00, count << geometry.page_shift);
+
+	return first_frame << geometry.page_shift;
+}
+
+/*
+	Take over the linear table the payload was written into. The frames
+	it maps are claimed first so a new table can't be placed over them,
+	then every entry is copied into a table of the requested type. The
+	payload only exists in the default geometry.
+*/
+int pager_adopt_linear_table (pager_t* pager, process_t* process, int type, long long base)
+{
+	int disk_frames = DISK_MEMORY_SIZE / PAGE_SIZE;
+	int table_frames = PAGE_TABLE_SIZE / PAGE_SIZE;
+	uchar_t entries[PAGE_TABLE_SIZE];
+
+	memcpy(entries, &pager->physical_memory[base], PAGE_TABLE_SIZE);
+	pager_reserve_frames(pager, base / PAGE_SIZE, table_frames);
+
+	for (int page = 0; page < VIRTUAL_PAGE_COUNT; ++page)
+	{
+		uchar_t frame_number = entries[page * 2];
+		uchar_t control_bits = entries[(page * 2) + 1];
+
+		if ((control_bits & C_PRESENT) != 0 && frame_allocator_claim(pager->frames, frame_number, 1) == 0)
+		{
+			pager->frame_page[frame_number] = page;
+			pager->frame_process[frame_number] = process;
+			pager->resident_count++;
+			process->resident_count++;
+			count_resident(pager, process, page, 1);
+		}
+	}
+
+	if (type == PT_LINEAR)
+		process->page_table = create_linear_page_table_at(pager, process->pid, base);
+	else
+		process->page_table = create_page_table(type, pager, process->pid);
+
+	if (!process->page_table)
+		return -1;
+
+	for (int page = 0; page < VIRTUAL_PAGE_COUNT; ++page)
+	{
+		uchar_t frame_number = entries[page * 2];
+		uchar_t control_bits = entries[(page * 2) + 1];
+
+		if ((control_bits & C_PRESENT) != 0 && pager->frame_page[frame_number] == page && pager->frame_process[frame_number] == process)
+		{
+			/* Payload only exists in memory, so it must be written out if evicted */
+			page_table_map(process->page_table, page, frame_number, control_bits | C_DIRTY);
+		}
+		else if ((control_bits & C_DISK) != 0 && frame_number < disk_frames)
+		{
+			page_map_put(process->swap_slots, page, frame_number);
+			pager->disk_slot_used[frame_number] = 1;
+			page_table_map(process->page_table, page, frame_number, control_bits);
+		}
+		else
+		{
+			page_table_unmap(process->page_table, page);
+		}
+	}
+
+	/* The payload was loaded all at once, its frames queue up in frame order */
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		if (pager->frame_process[frame] == process)
+		{
+			link_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame, -1);
+			link_frame(&process->owned_frames, pager->older_owned, pager->newer_owned, frame, -1);
+			process->owned_count++;
+		}
+	}
+
+	if (type != PT_LINEAR)
+		pager_release_frames(pager, base / PAGE_SIZE, table_frames);
+
+	/* Respect the frame limit from the very first access */
+	pager_enforce_frame_limit(pager);
+
+	return 0;
+}
+
+/* Evict until the resident pages fit the frame limit again */
+void pager_enforce_frame_limit (pager_t* pager)
+{
+	while (limited_frames(pager) > pager->config.frame_limit)
+	{
+		if (evict_frame(pager, NULL) < 0)
+			break;
+	}
+}
+
+typedef struct frame_stamp
+{
+	unsigned long	stamp;
+	long long		frame;
+} frame_stamp_t;
+
+static int compare_frame_stamps (const void* a, const void* b)
+{
+	const frame_stamp_t* left = a;
+	const frame_stamp_t* right = b;
+
+	if (left->stamp != right->stamp)
+		return (left->stamp > right->stamp) - (left->stamp < right->stamp);
+
+	return (left->frame > right->frame) - (left->frame < right->frame);
+}
+
+/*
+	Rebuild the resident frame list once every owner is restored, so
+	replacement goes on where it left off. ranks is each frame's saved
+	place in the list, NULL when the policy changed: The new one orders
+	by its own stamps then & CLOCK's ring goes by frame.
+*/
+void pager_order_frames (pager_t* pager, unsigned long* ranks, long long clock_hand)
+{
+	frame_stamp_t* order = malloc(geometry.frame_count * sizeof(frame_stamp_t));
+	unsigned long* stamps = (pager->config.policy == PR_LRU) ? pager->last_used : pager->loaded_at;
+	ullong_t count = 0;
+
+	if (ranks)
+		stamps = ranks;
+
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		process_t* owner = pager->frame_process[frame];
+
+		if (!owner)
+			continue;
+
+		order[count].stamp 	= (pager->config.policy == PR_CLOCK && !ranks) ? 0 : stamps[frame];
+		order[count].frame 	= frame;
+		count++;
+
+		clear_frame_list(&owner->owned_frames);
+	}
+
+	qsort(order, count, sizeof(frame_stamp_t), compare_frame_stamps);
+	clear_frame_list(&pager->resident_frames);
+
+	for (ullong_t i = 0; i < count; ++i)
+	{
+		long long frame = order[i].frame;
+		process_t* owner = pager->frame_process[frame];
+
+		link_frame(&pager->resident_frames, pager->older_frame, pager->newer_frame, frame, -1);
+		link_frame(&owner->owned_frames, pager->older_owned, pager->newer_owned, frame, -1);
+	}
+
+	/* A hand on a frame nobody owns starts over at the oldest */
+	if (clock_hand >= 0 && (ullong_t) clock_hand < geometry.frame_count && pager->frame_process[clock_hand])
+		pager->resident_frames.hand = clock_hand;
+
+	free(order);
+}
+
+/* Belady needs the whole future, so walk the trace backwards once up front [From the current position when restored] */
+void pager_prepare_optimal (pager_t* pager, process_t* process)
+{
+	trace_t* trace = process->trace;
+
+	if (!pager || !trace || pager->config.policy != PR_OPTIMAL)
+		return;
+
+	if (trace->workload)
+	{
+		printf("%s - OPTIMAL Needs A Trace File, Generated Streams Have No Future To Read...\n", ERROR_PRINT_TAG);
+		return;
+	}
+
+	free(process->next_use);
+	free_page_map(process->page_next_use);
+
+	process->next_use = malloc(trace->length * sizeof(long long));
+	process->page_next_use = create_page_map(0);
+
+	for (unsigned long i = 0; i < process->position && i < trace->length; ++i)
+		process->next_use[i] = -1;
+
+	/* Back to front a window at a time, a binary trace is decoded block by block */
+	for (unsigned long end = trace->length; end > process->position;)
+	{
+		unsigned long start = (end - 1) / trace->capacity * trace->capacity;
+		unsigned long count = end - start;
+		trace_entry_t* entries = trace_window(trace, start, &count);
+
+		/* A damaged block ended the trace, nothing past it is replayed */
+		if (count != end - start)
+		{
+			for (unsigned long i = process->position; i < end; ++i)
+				process->next_use[i] = -1;
+
+			break;
+		}
+
+		for (unsigned long i = end; i-- > start && i >= process->position;)
+		{
+			ullong_t page = entries[i - start].address >> geometry.page_shift;
+
+			process->next_use[i] = page_map_get(process->page_next_use, page, -1);
+			page_map_put(process->page_next_use, page, i);
+		}
+
+		end = start;
+	}
+}
+
+/*================================= OPERATIONAL ================================*/
+static long long allocate_disk_slot (pager_t* pager)
+{
+	/* Slots are only freed by release_disk_slot(), which moves the hint back */
+	for (ullong_t slot = pager->disk_slot_hint; slot < geometry.disk_frame_count; ++slot)
+	{
+		if (!pager->disk_slot_used[slot])
+		{
+			pager->disk_slot_used[slot] = 1;
+			pager->disk_slot_hint = slot + 1;
+			return slot;
+		}
+	}
+
+	return -1;
+}
+
+/* One process stops referring to the slot, the last one frees it */
+static void release_disk_slot (pager_t* pager, long long slot)
+{
+	if (slot < 0 || pager->disk_slot_used[slot] == 0)
+		return;
+
+	if (--pager->disk_slot_used[slot] != 0)
+		return;
+
+	if ((ullong_t) slot < pager->disk_slot_hint)
+		pager->disk_slot_hint = slot;
+
+	if (pager->zswap)
+		zswap_invalidate(pager->zswap, slot);
+}
+
+/* Slot contents into the frame: From the compressed pool while it holds them, from disk otherwise */
+static void read_disk_slot (pager_t* pager, process_t* process, ullong_t virtual_page_number, ullong_t slot, ullong_t frame)
+{
+	char* page = &pager->physical_memory[frame * geometry.page_size];
+
+	if (pager->zswap && zswap_load(pager->zswap, slot, page) == 0)
+		return;
+
+	memcpy(page, &pager->disk_memory[slot * geometry.page_size], geometry.page_size);
+
+	if (pager->swap)
+		swap_device_read(pager->swap, process, virtual_page_number, slot);
+}
+
+static void write_disk_slot (pager_t* pager, ullong_t slot, ullong_t frame)
+{
+	char* page = &pager->physical_memory[frame * geometry.page_size];
+
+	if (pager->zswap && zswap_store(pager->zswap, slot, page) == 0)
+		return;
+
+	memcpy(&pager->disk_memory[slot * geometry.page_size], page, geometry.page_size);
+
+	if (pager->swap)
+		swap_device_write(pager->swap, slot);
+}
+
+/*================================ SHARED FRAMES ===============================*/
+/*
+	Every process mapping a frame, the owner first. Only processes that took
+	part in a fork can share one, so those are the only ones searched.
+*/
+static int collect_mappers (pager_t* pager, ullong_t frame, process_t** mappers)
+{
+	long long page = pager->frame_page[frame];
+	int count = 0;
+
+	mappers[count++] = pager->frame_process[frame];
+
+	for (int i = 0; i < pager->sharer_count && (ullong_t) count <= pager->frame_shared[frame]; ++i)
+	{
+		process_t* process = pager->sharers[i];
+		ullong_t frame_number;
+		uchar_t control_bits;
+
+		if (process == mappers[0])
+			continue;
+
+		if (page_table_get(process->page_table, page, &frame_number, &control_bits) == 0
+			&& (control_bits & C_PRESENT) != 0 && frame_number == frame)
+			mappers[count++] = process;
+	}
+
+	return count;
+}
+
+/* Process is about to stop mapping a shared frame, the others keep it [Ownership passes on if it was the owner] */
+static void drop_shared_reference (pager_t* pager, process_t* process, ullong_t frame)
+{
+	if (pager->frame_process[frame] == process)
+	{
+		process_t* mappers[MAX_PROCESSES];
+
+		collect_mappers(pager, frame, mappers);
+		pager_set_owner(pager, frame, mappers[1]);
+	}
+
+	pager->frame_shared[frame]--;
+	pager->shared_mappings--;
+}
+
+/*================================= HUGE PAGES =================================*/
+/* Resident base pages per huge page sized region decide when it's worth promoting */
+static void count_resident (pager_t* pager, process_t* process, ullong_t virtual_page_number, int delta)
+{
+	if (pager->config.huge_order == 0)
+		return;
+
+	ullong_t region = virtual_page_number >> pager->config.huge_order;
+	long long count = page_map_get(process->region_resident, region, 0) + delta;
+
+	if (count > 0)
+		page_map_put(process->region_resident, region, count);
+	else
+		page_map_remove(process->region_resident, region);
+}
+
+/* Split a huge page back into base pages, they stay in place but can be evicted one by one */
+static void demote_huge_page (pager_t* pager, process_t* process, ullong_t virtual_page_number)
+{
+	ullong_t count = 1ULL << pager->config.huge_order;
+	ullong_t first_page = (virtual_page_number >> pager->config.huge_order) << pager->config.huge_order;
+
+	for (ullong_t page = first_page; page < first_page + count; ++page)
+	{
+		uchar_t* control_bits = page_table_control(process->page_table, page);
+
+		if (control_bits)
+			*control_bits &= ~C_HUGE;
+	}
+
+	if (pager->tlb)
+		tlb_invalidate(pager->tlb, process->pid, first_page);
+
+	pager->huge_pages--;
+	pager->demotions++;
+}
+
+/*
+	Collapse the region around virtual_page_number into an aligned run of
+	frames: Resident pages are copied over, swapped ones read back & the
+	rest zero-filled, then every entry is mapped with C_HUGE set.
+*/
+static int promote_huge_page (pager_t* pager, process_t* process, ullong_t virtual_page_number)
+{
+	char* physical_memory = pager->physical_memory;
+	page_table_t* page_table = process->page_table;
+	ullong_t page_size = geometry.page_size;
+	ullong_t count = 1ULL << pager->config.huge_order;
+	ullong_t region = virtual_page_number >> pager->config.huge_order;
+	ullong_t first_page = region << pager->config.huge_order;
+	ullong_t frame_number;
+	uchar_t control_bits;
+
+	/* A huge mapping has one memory type, a region the uncached range cuts through stays in base pages */
+	for (ullong_t page = first_page + 1; page < first_page + count; ++page)
+	{
+		if (page_attributes(pager, page) != page_attributes(pager, first_page))
+			return -1;
+	}
+
+	/* Promoting past the frame limit would only force evictions straight away */
+	if (limited_frames(pager) - page_map_get(process->region_resident, region, 0) + count > (ullong_t) pager->config.frame_limit)
+	{
+		pager->promotion_failures++;
+		return -1;
+	}
+
+	/* Build every table path first, that may take a frame & must not land in the run */
+	for (ullong_t page = first_page; page < first_page + count; ++page)
+	{
+		page_table_get(page_table, page, &frame_number, &control_bits);
+
+		if (page_table_map(page_table, page, frame_number, control_bits) < 0)
+			return -1;
+	}
+
+	long long resident = page_map_get(process->region_resident, region, 0);
+	long long first_frame = -1;
+
+	/* A buddy block of the huge page's order is exactly an aligned run */
+	if (limited_frames(pager) - resident + count <= (ullong_t) pager->config.frame_limit)
+		first_frame = frame_allocator_allocate_run(pager->frames, count, count);
+
+	if (first_frame < 0)
+	{
+		pager->promotion_failures++;
+		return -1;
+	}
+
+	long long kept = 0;
+
+	pager->tick++;
+
+	for (ullong_t i = 0; i < count; ++i)
+	{
+		ullong_t page = first_page + i;
+		ullong_t frame = first_frame + i;
+		long long slot = page_map_get(process->swap_slots, page, -1);
+		uchar_t keep_bits = 0x00;
+
+		page_table_get(page_table, page, &frame_number, &control_bits);
+
+		if ((control_bits & C_PRESENT) != 0)
+		{
+			memcpy(&physical_memory[frame * page_size], &physical_memory[frame_number * page_size], page_size);
+			keep_bits = control_bits & (C_DIRTY | C_ACCESSED);
+
+			/* Other processes keep a shared frame, this one moves to its own copy */
+			if (pager->frame_page[frame_number] == FRAME_MERGED)
+			{
+				ksm_release(pager->ksm, pager, frame_number);
+				kept++;
+			}
+			else if (pager->frame_shared[frame_number] > 0)
+			{
+				drop_shared_reference(pager, process, frame_number);
+				kept++;
+			}
+			else
+			{
+				pager->frame_page[frame_number] = FRAME_FREE;
+				pager_set_owner(pager, frame_number, NULL);
+				frame_allocator_release(pager->frames, frame_number, 1);
+			}
+
+			if (pager->tlb)
+				tlb_invalidate(pager->tlb, process->pid, page);
+		}
+		else if (slot >= 0)
+		{
+			read_disk_slot(pager, process, page, slot, frame);
+		}
+		else
+		{
+			memset(&physical_memory[frame * page_size], 0x00, page_size);
+		}
+
+		page_table_map(page_table, page, frame, C_PRESENT | C_READWRITE | C_HUGE | keep_bits | page_attributes(pager, page));
+
+		pager->frame_page[frame] = page;
+		pager->loaded_at[frame] = pager->tick;
+		pager->last_used[frame] = pager->tick;
+		pager_set_owner(pager, frame, process);
+	}
+
+	pager->resident_count += count - resident + kept;
+	process->resident_count += count - resident;
+	page_map_put(process->region_resident, region, count);
+
+	pager->huge_pages++;
+	pager->promotions++;
+
+	return 0;
+}
+
+/*
+	Page to evict by the replacement policy, only among owner's own pages
+	unless it's NULL. Candidates come from the resident frame lists, so
+	LRU & FIFO take the oldest, CLOCK turns its ring of resident frames &
+	NRU/OPTIMAL look at resident frames only, never physical memory.
+*/
+static long long select_victim_frame (pager_t* pager, process_t* owner)
+{
+	frame_list_t* list = owner ? &owner->owned_frames : &pager->resident_frames;
+	long long* newer = owner ? pager->newer_owned : pager->newer_frame;
+	long long victim = -1;
+
+	if (list->count == 0)
+		return -1;
+
+	switch (pager->config.policy)
+	{
+		case PR_CLOCK:
+		{
+			/* Second chance: Clear C_ACCESSED until a frame that wasn't referenced comes round [Two turns clear every bit] */
+			for (int step = 0; step <= 2 * list->count; ++step)
+			{
+				long long frame = (list->hand >= 0) ? list->hand : list->oldest;
+				long long page = pager->frame_page[frame];
+				process_t* process = pager->frame_process[frame];
+
+				list->hand = newer[frame];
+
+				uchar_t* control_bits = page_table_control(process->page_table, page);
+
+				if (control_bits && (*control_bits & C_ACCESSED) != 0)
+				{
+					/* Drop the cached translation so the next access walks & sets it again */
+					*control_bits &= ~C_ACCESSED;
+
+					if (pager->tlb)
+						tlb_invalidate(pager->tlb, process->pid, page);
+
+					continue;
+				}
+
+				return frame;
+			}
+
+			return -1;
+		}
+
+		case PR_NRU:
+		{
+			/* Lowest class wins, the oldest of it: 0 = !A!D, 1 = !AD, 2 = A!D, 3 = AD */
+			int victim_class = 4;
+
+			for (long long frame = list->oldest; frame >= 0 && victim_class > 0; frame = newer[frame])
+			{
+				ullong_t frame_number;
+				uchar_t control_bits;
+				page_table_get(pager->frame_process[frame]->page_table, pager->frame_page[frame], &frame_number, &control_bits);
+
+				int class = (((control_bits & C_ACCESSED) != 0) << 1) | ((control_bits & C_DIRTY) != 0);
+
+				if (class < victim_class)
+				{
+					victim_class = class;
+					victim = frame;
+				}
+			}
+
+			return victim;
+		}
+
+		case PR_OPTIMAL:
+		{
+			/*
+				Evict the page referenced furthest in the future. Distance is measured
+				in the owner's own trace, which is exact for a single process and an
+				approximation once the scheduler interleaves several.
+			*/
+			unsigned long furthest = 0;
+
+			for (long long frame = list->oldest; frame >= 0; frame = newer[frame])
+			{
+				long long page = pager->frame_page[frame];
+				process_t* process = pager->frame_process[frame];
+				unsigned long distance = NEVER_USED;
+				long long next_use = process->page_next_use ? page_map_get(process->page_next_use, page, -1) : -1;
+
+				if (next_use >= 0)
+					distance = next_use - process->position;
+
+				if (victim < 0 || distance > furthest)
+				{
+					furthest = distance;
+					victim = frame;
+				}
+			}
+
+			return victim;
+		}
+
+		case PR_LRU:
+		case PR_FIFO:
+		default:
+			/* Oldest use or load, the lists are kept in that order */
+			return list->oldest;
+	}
+}
+
+static long long evict_frame (pager_t* pager, process_t* owner)
+{
+	ullong_t started = metrics ? metrics_clock() : 0;
+	ullong_t event_started = events ? events_clock() : 0;
+	long long frame = select_victim_frame(pager, owner);
+
+	if (frame < 0)
+		return -1;
+
+	long long page = pager->frame_page[frame];
+	process_t* process = pager->frame_process[frame];
+	long long slot = page_map_get(process->swap_slots, page, -1);
+	process_t* mappers[MAX_PROCESSES];
+	int mapper_count = collect_mappers(pager, frame, mappers);
+	ullong_t frame_number;
+	uchar_t control_bits;
+	uchar_t dirty = 0x00;
+
+	page_table_get(process->page_table, page, &frame_number, &control_bits);
+
+	/* Memory pressure reached a huge page, split it rather than evict the whole run */
+	if ((control_bits & C_HUGE) != 0)
+	{
+		demote_huge_page(pager, process, page);
+		control_bits &= ~C_HUGE;
+	}
+
+	/* A shared frame is dirty if any of its mappings wrote it */
+	for (int i = 0; i < mapper_count; ++i)
+	{
+		page_table_get(mappers[i]->page_table, page, &frame_number, &control_bits);
+		dirty |= control_bits & C_DIRTY;
+	}
+
+	if (dirty)
+	{
+		/* A slot still read by processes outside the mappers must not be overwritten */
+		if (slot >= 0 && pager->disk_slot_used[slot] > mapper_count)
+		{
+			pager->disk_slot_used[slot] -= mapper_count;
+			slot = -1;
+		}
+
+		/* Memory is newer than the backing store [Or there is no backing copy yet] */
+		if (slot < 0)
+			slot = allocate_disk_slot(pager);
+
+		if (slot < 0)
+		{
+			printf("%s - Out Of Disk Memory...\n", ERROR_PRINT_TAG);
+			return -1;
+		}
+
+		write_disk_slot(pager, slot, frame);
+		pager->disk_slot_used[slot] = mapper_count;
+		pager->writebacks++;
+
+		if (events)
+			events_record(EVENT_WRITEBACK, process->pid, page, slot, EVENT_WRITE, 0);
+	}
+
+	for (int i = 0; i < mapper_count; ++i)
+	{
+		process_t* mapper = mappers[i];
+
+		page_table_get(mapper->page_table, page, &frame_number, &control_bits);
+
+		/* Clean zero-filled pages are cheaper to zero-fill again on the next fault */
+		if (slot >= 0)
+		{
+			page_map_put(mapper->swap_slots, page, slot);
+			page_table_map(mapper->page_table, page, slot, (control_bits & C_READWRITE) | C_DISK);
+		}
+		else
+		{
+			page_table_unmap(mapper->page_table, page);
+		}
+
+		if (pager->tlb)
+			tlb_invalidate(pager->tlb, mapper->pid, page);
+
+		mapper->resident_count--;
+		count_resident(pager, mapper, page, -1);
+	}
+
+	pager->shared_mappings -= mapper_count - 1;
+	pager->frame_shared[frame] = 0;
+
+	pager->frame_page[frame] = FRAME_FREE;
+	pager_set_owner(pager, frame, NULL);
+	pager->resident_count--;
+	pager->evictions++;
+	frame_allocator_release(pager->frames, frame, 1);
+
+	if (metrics)
+	{
+		metrics_count(METRIC_EVICTIONS, 1);
+		metrics_count(METRIC_WRITEBACKS, dirty ? 1 : 0);
+		metrics_record(METRIC_EVICTION_NS, metrics_clock() - started);
+	}
+
+	if (events)
+		events_record(EVENT_EVICTION, process->pid, page, frame, dirty ? EVENT_WRITE : 0, event_started);
+
+	return frame;
+}
+
+/* Frame for a page of the process, NUMA places it by policy */
+static long long allocate_frame (pager_t* pager, process_t* process, ullong_t virtual_page_number)
+{
+	numa_t* numa = pager->numa;
+	long long frame = -1;
+
+	if (pager->reclaim)
+		reclaim_allocate(pager->reclaim, pager, process);
+
+	if (limited_frames(pager) < pager->config.frame_limit)
+		frame = numa ? numa_allocate(numa, pager->frames, process->pid, virtual_page_number) : frame_allocator_allocate(pager->frames);
+
+	if (frame >= 0 || (frame = evict_frame(pager, NULL)) < 0)
+		return frame;
+
+	/* The evicted page's frame goes straight to the new one, unless the policy finds a better node */
+	if (numa)
+		return numa_allocate(numa, pager->frames, process->pid, virtual_page_number);
+
+	frame_allocator_claim(pager->frames, frame, 1);
+
+	return frame;
+}
+
+/* Frames an allocation can take without evicting */
+ullong_t pager_free_frames (pager_t* pager)
+{
+	int limited = limited_frames(pager);
+	ullong_t below_limit = (limited < pager->config.frame_limit) ? pager->config.frame_limit - limited : 0;
+
+	return (below_limit < pager->frames->free_count) ? below_limit : pager->frames->free_count;
+}
+
+/* Evict up to count pages, only owner's own unless it's NULL, returns how many went */
+int pager_reclaim (pager_t* pager, process_t* owner, int count)
+{
+	int evicted = 0;
+
+	while (evicted < count && evict_frame(pager, owner) >= 0)
+		evicted++;
+
+	return evicted;
+}
+
+/*
+	The page follows its process to the home node. Only a private base page
+	moves: Shared, merged & huge frames stay where they are, like inverted
+	tables' pages [Their frame is their slot].
+*/
+static void migrate_page (pager_t* pager, process_t* process, ullong_t virtual_page_number, ullong_t frame)
+{
+	numa_t* numa = pager->numa;
+	ullong_t page_size = geometry.page_size;
+	ullong_t frame_number;
+	uchar_t control_bits;
+
+	if (pager->frame_process[frame] != process || pager->frame_page[frame] != (long long) virtual_page_number
+		|| pager->frame_shared[frame] > 0 || process->page_table->type == PT_INVERTED)
+		return;
+
+	page_table_get(process->page_table, virtual_page_number, &frame_number, &control_bits);
+
+	if ((control_bits & (C_HUGE | C_COW)) != 0)
+		return;
+
+	long long target = numa_allocate_on(numa, pager->frames, numa_home_node(numa, process->pid));
+
+	if (target < 0)
+	{
+		numa->migration_failures++;
+		numa->remote_hits[frame] = 0;
+		return;
+	}
+
+	memcpy(&pager->physical_memory[target * page_size], &pager->physical_memory[frame * page_size], page_size);
+	page_table_map(process->page_table, virtual_page_number, target, control_bits);
+
+	if (pager->tlb)
+		tlb_invalidate(pager->tlb, process->pid, virtual_page_number);
+
+	/* Replacement sees the same page, only its frame changed */
+	pager->frame_page[target] 		= virtual_page_number;
+	pager->loaded_at[target] 		= pager->loaded_at[frame];
+	pager->last_used[target] 		= pager->last_used[frame];
+	pager->frame_page[frame] 		= FRAME_FREE;
+	move_frame(pager, frame, target);
+	frame_allocator_release(pager->frames, frame, 1);
+	numa_migrated(numa, frame, target);
+}
+
+/* Bookkeeping for every access [C_ACCESSED & C_DIRTY are set by the page table walk] */
+void pager_touch (pager_t* pager, process_t* process, ullong_t virtual_page_number, ullong_t frame_number)
+{
+	pager->tick++;
+	pager->last_used[frame_number] = pager->tick;
+
+	/* Merged frames belong to no one & are never candidates */
+	if (pager->config.policy == PR_LRU && pager->frame_process[frame_number])
+		refresh_frame(pager, frame_number);
+
+	if (pager->swap)
+		pager->swap->now += pager->swap->config.access_ns;
+
+	if (pager->numa && numa_access(pager->numa, process->pid, frame_number))
+		migrate_page(pager, process, virtual_page_number, frame_number);
+
+	if (process->next_use)
+		page_map_put(process->page_next_use, virtual_page_number, process->next_use[process->position]);
+
+	/* NRU: Periodically age every resident page back to "not referenced" */
+	if (pager->config.policy == PR_NRU && pager->tick % pager->config.nru_interval == 0)
+	{
+		for (long long frame = pager->resident_frames.oldest; frame >= 0; frame = pager->newer_frame[frame])
+		{
+			uchar_t* control_bits = page_table_control(pager->frame_process[frame]->page_table, pager->frame_page[frame]);
+
+			if (control_bits)
+				*control_bits &= ~C_ACCESSED;
+		}
+
+		if (pager->tlb)
+			tlb_flush(pager->tlb);
+	}
+}
+
+/* Frame now holds the process' page */
+static void install_page (pager_t* pager, process_t* process, ullong_t virtual_page_number, ullong_t frame)
+{
+	pager->tick++;
+	pager->frame_page[frame] = virtual_page_number;
+	pager->loaded_at[frame] = pager->tick;
+	pager->last_used[frame] = pager->tick;
+	pager->resident_count++;
+	process->resident_count++;
+	pager_set_owner(pager, frame, process);
+	count_resident(pager, process, virtual_page_number, 1);
+}
+
+/* Read of a page nobody wrote yet: The shared zero frame stands in until the first write */
+static long long map_zero_page (pager_t* pager, process_t* process, ullong_t virtual_page_number)
+{
+	ksm_t* ksm = pager->ksm;
+
+	if (ksm->zero_frame < 0)
+	{
+		long long frame = allocate_frame(pager, process, virtual_page_number);
+
+		if (frame < 0)
+			return -1;
+
+		memset(&pager->physical_memory[frame * geometry.page_size], 0x00, geometry.page_size);
+
+		pager->frame_page[frame] 	= FRAME_MERGED;
+		pager_set_owner(pager, frame, NULL);
+		pager->resident_count++;
+		ksm->zero_frame 			= frame;
+		ksm->merged_frames++;
+	}
+
+	page_table_map(process->page_table, virtual_page_number, ksm->zero_frame, C_PRESENT | C_COW | page_attributes(pager, virtual_page_number));
+	ksm_share(ksm, ksm->zero_frame);
+	ksm->zero_maps++;
+
+	pager->zero_fills++;
+	process->resident_count++;
+	count_resident(pager, process, virtual_page_number, 1);
+
+	return ksm->zero_frame;
+}
+
+long long pager_handle_fault (pager_t* pager, process_t* process, ullong_t virtual_page_number, int is_write)
+{
+	char* physical_memory = pager->physical_memory;
+	ullong_t page_size = geometry.page_size;
+	page_table_t* page_table = process->page_table;
+	ullong_t frame_number;
+	uchar_t control_bits;
+
+	page_table_get(page_table, virtual_page_number, &frame_number, &control_bits);
+
+	if ((control_bits & C_PRESENT) != 0)
+		return frame_number;
+
+	pager->faults++;
+
+	/* Build any missing table levels first, that may itself need a frame */
+	if (page_table_map(page_table, virtual_page_number, frame_number, control_bits) < 0)
+	{
+		printf("%s - No Frame Available For Page Table...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	long long slot = page_map_get(process->swap_slots, virtual_page_number, -1);
+
+	/* Inverted tables can't map the zero frame more than once */
+	if (slot < 0 && !is_write && pager->ksm && page_table->type != PT_INVERTED)
+		return map_zero_page(pager, process, virtual_page_number);
+
+	long long frame = allocate_frame(pager, process, virtual_page_number);
+
+	if (frame < 0)
+	{
+		printf("%s - No Frame Available For Page 0x%02llX...\n", ERROR_PRINT_TAG, virtual_page_number);
+		return -1;
+	}
+
+	if (slot >= 0)
+	{
+		read_disk_slot(pager, process, virtual_page_number, slot, frame);
+		pager->major_faults++;
+
+		if (metrics)
+			metrics_count(METRIC_MAJOR_FAULTS, 1);
+	}
+	else
+	{
+		memset(&physical_memory[frame * page_size], 0x00, page_size);
+		pager->zero_fills++;
+	}
+
+	page_table_map(page_table, virtual_page_number, frame, C_PRESENT | C_READWRITE | page_attributes(pager, virtual_page_number));
+	install_page(pager, process, virtual_page_number, frame);
+
+	/* Enough of the region is in use to be worth a huge page */
+	if (pager->config.huge_order > 0
+		&& page_map_get(process->region_resident, virtual_page_number >> pager->config.huge_order, 0) >= pager->config.promote_threshold
+		&& promote_huge_page(pager, process, virtual_page_number) == 0)
+	{
+		page_table_get(page_table, virtual_page_number, &frame_number, &control_bits);
+		frame = frame_number;
+	}
+
+	return frame;
+}
+
+/*================================ COPY-ON-WRITE ===============================*/
+typedef struct page_list
+{
+	ullong_t*	pages;
+	ullong_t	count;
+	ullong_t	capacity;
+} page_list_t;
+
+static void collect_page (void* context, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	page_list_t* list = context;
+	(void) frame_number;
+	(void) control_bits;
+
+	if (list->count == list->capacity)
+	{
+		list->capacity = list->capacity ? list->capacity * 2 : 256;
+		list->pages = realloc(list->pages, list->capacity * sizeof(ullong_t));
+	}
+
+	list->pages[list->count++] = virtual_page_number;
+}
+
+static void add_sharer (pager_t* pager, process_t* process)
+{
+	for (int i = 0; i < pager->sharer_count; ++i)
+	{
+		if (pager->sharers[i] == process)
+			return;
+	}
+
+	pager->sharers = realloc(pager->sharers, (pager->sharer_count + 1) * sizeof(process_t*));
+	pager->sharers[pager->sharer_count++] = process;
+}
+
+/*
+	Give the child every page of the parent. Resident pages share the
+	parent's frame & turn copy-on-write in both if they were writable,
+	swapped ones share the parent's disk slot. Inverted tables hold one
+	mapping per frame, so there resident pages are copied up front.
+*/
+int pager_fork_process (pager_t* pager, process_t* parent, process_t* child)
+{
+	char* physical_memory = pager->physical_memory;
+	ullong_t page_size = geometry.page_size;
+	int share_frames = (parent->page_table->type != PT_INVERTED);
+	page_map_t* parent_slots = parent->swap_slots;
+	page_list_t list = { NULL, 0, 0 };
+
+	add_sharer(pager, parent);
+	add_sharer(pager, child);
+	pager->forks++;
+
+	/* Inverted tables have no entry for swapped pages, the swap map has them all */
+	for (ullong_t i = 0; i < parent_slots->capacity; ++i)
+	{
+		if (!parent_slots->used[i])
+			continue;
+
+		page_map_put(child->swap_slots, parent_slots->keys[i], parent_slots->values[i]);
+		pager->disk_slot_used[parent_slots->values[i]]++;
+	}
+
+	page_table_for_each(parent->page_table, collect_page, &list);
+
+	for (ullong_t i = 0; i < list.count; ++i)
+	{
+		ullong_t page = list.pages[i];
+		ullong_t frame_number;
+		uchar_t control_bits;
+
+		/* Missing table levels of the child first, building them may evict one of the parent's pages */
+		if (share_frames && page_table_map(child->page_table, page, 0, 0x00) < 0)
+		{
+			printf("%s - No Frame Available For Page Table...\n", ERROR_PRINT_TAG);
+			free(list.pages);
+			return -1;
+		}
+
+		page_table_get(parent->page_table, page, &frame_number, &control_bits);
+
+		/* Only base pages are shared */
+		if ((control_bits & C_HUGE) != 0)
+		{
+			demote_huge_page(pager, parent, page);
+			control_bits &= ~C_HUGE;
+		}
+
+		if ((control_bits & C_PRESENT) == 0)
+		{
+			if ((control_bits & C_DISK) != 0)
+				page_table_map(child->page_table, page, frame_number, control_bits & (C_READWRITE | C_DISK));
+
+			continue;
+		}
+
+		if (!share_frames)
+		{
+			long long copy = allocate_frame(pager, child, page);
+
+			if (copy < 0)
+			{
+				printf("%s - No Frame Available For Page 0x%02llX...\n", ERROR_PRINT_TAG, page);
+				free(list.pages);
+				return -1;
+			}
+
+			/* Making room may have swapped the parent's page out */
+			long long slot = page_map_get(parent->swap_slots, page, -1);
+
+			page_table_get(parent->page_table, page, &frame_number, &control_bits);
+
+			if ((control_bits & C_PRESENT) != 0)
+				memcpy(&physical_memory[copy * page_size], &physical_memory[frame_number * page_size], page_size);
+			else if (slot >= 0)
+				read_disk_slot(pager, parent, page, slot, copy);
+			else
+				memset(&physical_memory[copy * page_size], 0x00, page_size);
+
+			/* The copy is newer than any slot the child shares */
+			page_table_map(child->page_table, page, copy, C_PRESENT | C_READWRITE | C_DIRTY | page_attributes(pager, page));
+			install_page(pager, child, page, copy);
+			pager->eager_copies++;
+			continue;
+		}
+
+		uchar_t shared_bits = control_bits & ~C_ACCESSED;
+
+		/* Already read-only & shared, the child is one more page on the merged frame */
+		if (pager->frame_page[frame_number] == FRAME_MERGED)
+		{
+			page_table_map(child->page_table, page, frame_number, shared_bits);
+			ksm_share(pager->ksm, frame_number);
+			child->resident_count++;
+			count_resident(pager, child, page, 1);
+			continue;
+		}
+
+		if ((control_bits & C_READWRITE) != 0)
+		{
+			shared_bits = (shared_bits & ~C_READWRITE) | C_COW;
+			page_table_map(parent->page_table, page, frame_number, (control_bits & ~C_READWRITE) | C_COW);
+
+			/* The parent's cached translation would let it write straight through */
+			if (pager->tlb)
+				tlb_invalidate(pager->tlb, parent->pid, page);
+		}
+
+		page_table_map(child->page_table, page, frame_number, shared_bits);
+
+		pager->frame_shared[frame_number]++;
+		pager->shared_mappings++;
+		pager->cow_shared++;
+		child->resident_count++;
+		count_resident(pager, child, page, 1);
+	}
+
+	if (pager->shared_mappings > pager->peak_shared_mappings)
+		pager->peak_shared_mappings = pager->shared_mappings;
+
+	free(list.pages);
+
+	return 0;
+}
+
+/*
+	First write to a copy-on-write page. The last process still mapping the
+	frame takes it over as it is, every other one gets a copy of its own.
+*/
+long long pager_break_cow (pager_t* pager, process_t* process, ullong_t virtual_page_number)
+{
+	char* physical_memory = pager->physical_memory;
+	ullong_t page_size = geometry.page_size;
+	page_table_t* page_table = process->page_table;
+	ullong_t frame_number;
+	uchar_t control_bits;
+
+	page_table_get(page_table, virtual_page_number, &frame_number, &control_bits);
+
+	if ((control_bits & (C_PRESENT | C_COW)) != (C_PRESENT | C_COW))
+		return frame_number;
+
+	pager->cow_faults++;
+
+	if (pager->tlb)
+		tlb_invalidate(pager->tlb, process->pid, virtual_page_number);
+
+	/* A merged frame is never handed to one of its pages, they all get copies */
+	if (pager->frame_shared[frame_number] == 0 && pager->frame_page[frame_number] != FRAME_MERGED)
+	{
+		page_table_map(page_table, virtual_page_number, frame_number, (control_bits & ~C_COW) | C_READWRITE);
+		pager->cow_reuses++;
+		return frame_number;
+	}
+
+	long long copy = allocate_frame(pager, process, virtual_page_number);
+
+	if (copy < 0)
+	{
+		printf("%s - No Frame Available For Page 0x%02llX...\n", ERROR_PRINT_TAG, virtual_page_number);
+		return -1;
+	}
+
+	/* Making room may have swapped the shared frame out, then the copy comes from disk */
+	long long slot = page_map_get(process->swap_slots, virtual_page_number, -1);
+
+	page_table_get(page_table, virtual_page_number, &frame_number, &control_bits);
+
+	if ((control_bits & C_PRESENT) != 0)
+	{
+		memcpy(&physical_memory[copy * page_size], &physical_memory[frame_number * page_size], page_size);
+
+		if (pager->frame_page[frame_number] == FRAME_MERGED)
+			ksm_release(pager->ksm, pager, frame_number);
+		else
+			drop_shared_reference(pager, process, frame_number);
+
+		/* install_page() counts the page again */
+		process->resident_count--;
+		count_resident(pager, process, virtual_page_number, -1);
+	}
+	else if (slot >= 0)
+	{
+		read_disk_slot(pager, process, virtual_page_number, slot, copy);
+	}
+	else
+	{
+		memset(&physical_memory[copy * page_size], 0x00, page_size);
+	}
+
+	/* The copy is about to differ from whatever is on disk */
+	if (slot >= 0)
+	{
+		release_disk_slot(pager, slot);
+		page_map_remove(process->swap_slots, virtual_page_number);
+	}
+
+	page_table_map(page_table, virtual_page_number, copy, C_PRESENT | C_READWRITE | C_DIRTY | page_attributes(pager, virtual_page_number));
+	install_page(pager, process, virtual_page_number, copy);
+	pager->cow_copies++;
+
+	return copy;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_pager_stats (pager_t* pager)
+{
+	printf("%s", TABLE_PAGER_HEADER);
+	printf("Policy:\t\t\t%s\n", REPLACEMENT_POLICY_NAMES[pager->config.policy]);
+	printf("Frame Limit:\t\t%d (frames)\n", pager->config.frame_limit);
+	printf("Resident:\t\t%d (frames)\n", pager->resident_count);
+	printf("Page Faults:\t\t%'lu\n", pager->faults);
+	printf("Major Faults:\t\t%'lu\n", pager->major_faults);
+	printf("Zero Fills:\t\t%'lu\n", pager->zero_fills);
+	printf("Evictions:\t\t%'lu\n", pager->evictions);
+	printf("Write Backs:\t\t%'lu\n", pager->writebacks);
+	print_frame_allocator_stats(pager->frames);
+
+	if (pager->config.huge_order > 0)
+	{
+		printf("Huge Page Size:\t\t%'llu (bytes)\n", geometry.page_size << pager->config.huge_order);
+		printf("Huge Pages:\t\t%'lu\n", pager->huge_pages);
+		printf("Promotions:\t\t%'lu\n", pager->promotions);
+		printf("Failed Promotions:\t%'lu\n", pager->promotion_failures);
+		printf("Demotions:\t\t%'lu\n", pager->demotions);
+	}
+
+	/* Copying every page at fork would have cost a frame per shared page */
+	if (pager->forks > 0)
+	{
+		ullong_t page_size = geometry.page_size;
+
+		printf("Forks:\t\t\t%'lu\n", pager->forks);
+		printf("COW Shared Pages:\t%'lu\n", pager->cow_shared);
+		printf("COW Faults:\t\t%'lu\n", pager->cow_faults);
+		printf("COW Copies:\t\t%'lu\n", pager->cow_copies);
+		printf("COW Reuses:\t\t%'lu\n", pager->cow_reuses);
+		printf("Eager Copies:\t\t%'lu\n", pager->eager_copies);
+		printf("Bytes Copied:\t\t%'llu (bytes)\n", (pager->cow_copies + pager->eager_copies) * page_size);
+		printf("Eager Fork Bytes:\t%'llu (bytes)\n", (pager->cow_shared + pager->eager_copies) * page_size);
+		printf("Shared Mappings:\t%'lu (frames saved, peak %'lu)\n", pager->shared_mappings, pager->peak_shared_mappings);
+	}
+
+	print_header_end('=', strlen(TABLE_PAGER_HEADER));
+}
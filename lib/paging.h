@@ -0,0 +1,112 @@
+#ifndef PAGINGH
+#define PAGINGH
+
+#include "utils.h"
+#include "tlb.h"
+#include "process.h"
+#include "frame_allocator.h"
+#include "swap_device.h"
+#include "zswap.h"
+#include "ksm.h"
+#include "numa.h"
+#include "cache.h"
+#include "reclaim.h"
+
+/* Page replacement policies */
+#define PR_FIFO             0
+#define PR_LRU              1
+#define PR_CLOCK            2
+#define PR_NRU              3
+#define PR_OPTIMAL          4
+
+/* frame_page values for frames that don't hold a process page */
+#define FRAME_FREE          -1
+#define FRAME_RESERVED      -2
+#define FRAME_MERGED        -3      /* Read-only contents shared by every page that had them [ksm_t] */
+
+typedef struct pager_config
+{
+    int         policy;             /* PR_FIFO, PR_LRU, PR_CLOCK, PR_NRU, PR_OPTIMAL */
+    int         frame_limit;        /* Max resident frames [0 => All available frames] */
+    int         nru_interval;       /* NRU: Accesses between C_ACCESSED resets */
+    int         huge_order;         /* Huge page = 2^huge_order base pages [0 => Disabled] */
+    int         promote_threshold;  /* Resident pages of a region before it's collapsed [0 => HUGE_PROMOTE_PERCENT] */
+} pager_config_t;
+
+typedef struct pager
+{
+    pager_config_t  config;
+    char*           physical_memory;
+    char*           disk_memory;
+    tlb_t*          tlb;
+    swap_device_t*  swap;           /* Times disk reads & write-backs, NULL => Disk is instant */
+    zswap_t*        zswap;          /* Compressed pool in front of the disk, NULL => Straight to disk */
+    ksm_t*          ksm;            /* Same-page merging & the zero frame, NULL => Off */
+    numa_t*         numa;           /* Node placement & migration, NULL => Uniform memory */
+    cache_t*        cache;          /* Data caches fed after translation, NULL => Uncached */
+    reclaim_t*      reclaim;        /* Free frame watermarks & memory limits, NULL => Evict once full */
+
+    long long*      frame_page;     /* Frame -> virtual page number, FRAME_FREE or FRAME_RESERVED */
+    process_t**     frame_process;  /* Frame -> process owning the page */
+    unsigned long*  loaded_at;      /* FIFO: Tick the page was brought in */
+    unsigned long*  last_used;      /* LRU: Tick of the most recent access */
+    uchar_t*        disk_slot_used; /* Processes referring to the slot [Shared after a fork] */
+    uint_t*         frame_shared;   /* Processes mapping the frame besides frame_process [Copy-on-write] */
+    process_t**     sharers;        /* Every process that took part in a fork, searched for a shared frame's mappings */
+    int             sharer_count;
+    int             resident_count;
+    frame_list_t    resident_frames;        /* Frames processes own [Eviction candidates], merged frames aside */
+    long long*      older_frame;    /* Links of resident_frames: LRU by use, CLOCK as a ring, the rest by load */
+    long long*      newer_frame;
+    long long*      older_owned;    /* Links of each owner's owned_frames, same order */
+    long long*      newer_owned;
+    frame_allocator_t* frames;      /* Free frames [Bitmap & buddy blocks], frame_page says who holds the rest */
+    ullong_t        disk_slot_hint; /* No free disk slot below this one */
+    long long       inverted_table_base;    /* Shared inverted page table, -1 until first used */
+    unsigned long   tick;
+
+    unsigned long   faults;
+    unsigned long   major_faults;   /* Page read back from disk */
+    unsigned long   zero_fills;     /* Page never touched before */
+    unsigned long   evictions;
+    unsigned long   writebacks;
+    unsigned long   huge_pages;     /* Currently promoted regions */
+    unsigned long   promotions;
+    unsigned long   promotion_failures;     /* No aligned free run or over the frame limit */
+    unsigned long   demotions;
+    unsigned long   forks;
+    unsigned long   cow_shared;     /* Pages shared instead of copied by fork */
+    unsigned long   cow_faults;     /* Writes to a copy-on-write page */
+    unsigned long   cow_copies;     /* Faults that had to copy the frame */
+    unsigned long   cow_reuses;     /* Faults by the last process sharing the frame, taken over without a copy */
+    unsigned long   eager_copies;   /* Pages fork had to copy [Inverted tables can't share a frame] */
+    unsigned long   shared_mappings;        /* Mappings currently sharing another process' frame */
+    unsigned long   peak_shared_mappings;
+} pager_t;
+
+// Initialization
+void init_pager_config (pager_config_t* config);
+pager_t* create_pager (pager_config_t* config, char* physical_memory, char* disk_memory, tlb_t* tlb);
+void free_pager (pager_t* pager);
+int parse_replacement_policy (const char* name);
+int pager_reserve_frames (pager_t* pager, ullong_t first_frame, ullong_t count);
+long long pager_allocate_table_frames (pager_t* pager, ullong_t count);
+void pager_release_frames (pager_t* pager, ullong_t first_frame, ullong_t count);
+int pager_adopt_linear_table (pager_t* pager, process_t* process, int type, long long base);
+void pager_prepare_optimal (pager_t* pager, process_t* process);
+void pager_enforce_frame_limit (pager_t* pager);
+void pager_order_frames (pager_t* pager, unsigned long* ranks, long long clock_hand);
+
+// Operational
+void pager_touch (pager_t* pager, process_t* process, ullong_t virtual_page_number, ullong_t frame_number);
+long long pager_handle_fault (pager_t* pager, process_t* process, ullong_t virtual_page_number, int is_write);
+int pager_fork_process (pager_t* pager, process_t* parent, process_t* child);
+long long pager_break_cow (pager_t* pager, process_t* process, ullong_t virtual_page_number);
+ullong_t pager_free_frames (pager_t* pager);
+int pager_reclaim (pager_t* pager, process_t* owner, int count);
+void pager_set_owner (pager_t* pager, ullong_t frame, process_t* process);
+
+// Debugging
+void print_pager_stats (pager_t* pager);
+
+#endif
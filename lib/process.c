@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "trace.h"
+#include "page_table.h"
+#include "page_map.h"
+#include "process.h"
+
+/*=============================== INITIALIZATION ===============================*/
+process_t* create_process (int pid, trace_t* trace)
+{
+	printf("%s - Creating Process %d...\n", INIT_PRINT_TAG, pid);
+
+	process_t* process = calloc(1, sizeof(process_t));
+	process->pid 				= pid;
+	process->trace 				= trace;
+	process->swap_slots 		= create_page_map(0);
+	process->region_resident 	= create_page_map(0);
+	process->owned_frames.oldest 	= -1;
+	process->owned_frames.newest 	= -1;
+	process->owned_frames.hand 		= -1;
+
+	return process;
+}
+
+void free_process (process_t* process)
+{
+	if (!process)
+		return;
+
+	free_page_table(process->page_table);
+	free_page_map(process->swap_slots);
+	free_page_map(process->region_resident);
+	free(process->next_use);
+	free_page_map(process->page_next_use);
+
+	if (process->owns_trace)
+		free_trace(process->trace);
+
+	free(process);
+}
+
+/*================================= OPERATIONAL ================================*/
+int process_has_work (process_t* process)
+{
+	return process->trace && process->position < process->trace->length;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_process_stats (process_t* process)
+{
+	trace_stats_t* stats = &process->stats;
+
+	page_table_t* page_table = process->page_table;
+	double walks = (page_table && page_table->walks > 0) ? (double) page_table->walks : 1.0;
+
+	printf("[PID %d]\tAccesses: %'lu\tFaults: %'lu\tDisk Reads: %'lu\tResident: %d (frames)\n",
+		process->pid, stats->accesses, stats->faults, stats->disk_reads, process->resident_count);
+
+	if (page_table)
+		printf("\t\t%s Table: %'lu (bytes)\tWalks: %'lu\tAvg. References/Walk: %.2f\n",
+			get_page_table_name(page_table->type), page_table->table_bytes, page_table->walks, page_table->references / walks);
+}
@@ -0,0 +1,48 @@
+#ifndef PROCESSH
+#define PROCESSH
+
+#include "utils.h"
+#include "trace.h"
+#include "page_table.h"
+#include "page_map.h"
+
+/* Frames in replacement order, linked through the pager's per-frame links */
+typedef struct frame_list
+{
+    long long       oldest;             /* -1 => Empty */
+    long long       newest;
+    long long       hand;               /* CLOCK: Next frame to look at, -1 => The oldest */
+    int             count;
+} frame_list_t;
+
+/* Simulated process [Own page table in physical memory, own trace & swap slots] */
+typedef struct process
+{
+    int             pid;
+    page_table_t*   page_table;
+    trace_t*        trace;
+    int             owns_trace;         /* Forked child replaying a reseeded copy of its parent's stream */
+    unsigned long   position;           /* Next trace entry to replay */
+    page_map_t*     swap_slots;         /* Virtual page -> disk frame, absent if none */
+    int             resident_count;
+    int             owned_count;        /* Frames it owns, shared & merged mappings aside [Memory limits charge these] */
+    frame_list_t    owned_frames;       /* The same frames, a memory limit evicts from these */
+    page_map_t*     region_resident;    /* Huge page region -> resident base pages */
+
+    long long*      next_use;           /* OPTIMAL: Trace index of the next access to the same page, -1 if none */
+    page_map_t*     page_next_use;      /* OPTIMAL: Next use of each virtual page from the current position */
+
+    trace_stats_t   stats;
+} process_t;
+
+// Initialization
+process_t* create_process (int pid, trace_t* trace);
+void free_process (process_t* process);
+
+// Operational
+int process_has_work (process_t* process);
+
+// Debugging
+void print_process_stats (process_t* process);
+
+#endif
@@ -0,0 +1,71 @@
+#include "utils.h"
+#include "random.h"
+
+/*=============================== INITIALIZATION ===============================*/
+// Source: https://prng.di.unimi.it/splitmix64.c
+static ullong_t splitmix64 (ullong_t* x)
+{
+	ullong_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+	return z ^ (z >> 31);
+}
+
+/* Any seed [0 included] expands into a non-zero state */
+void rng_seed (rng_t* rng, ullong_t seed)
+{
+	for (int i = 0; i < 4; ++i)
+		rng->state[i] = splitmix64(&seed);
+}
+
+/*================================= OPERATIONAL ================================*/
+static inline ullong_t rotate_left (ullong_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+// Source: https://prng.di.unimi.it/xoshiro256starstar.c
+ullong_t rng_next (rng_t* rng)
+{
+	ullong_t* s = rng->state;
+	ullong_t result = rotate_left(s[1] * 5, 7) * 9;
+	ullong_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotate_left(s[3], 45);
+
+	return result;
+}
+
+/* Uniform in [0, bound) without modulo bias [Multiply & reject, bound > 0] */
+// Source: https://arxiv.org/abs/1805.10941 [Lemire]
+ullong_t rng_below (rng_t* rng, ullong_t bound)
+{
+	unsigned __int128 product = (unsigned __int128) rng_next(rng) * bound;
+	ullong_t low = (ullong_t) product;
+
+	if (low < bound)
+	{
+		ullong_t threshold = -bound % bound;
+
+		while (low < threshold)
+		{
+			product = (unsigned __int128) rng_next(rng) * bound;
+			low = (ullong_t) product;
+		}
+	}
+
+	return product >> 64;
+}
+
+/* Uniform in [0, 1) with 53 bits of precision */
+double rng_double (rng_t* rng)
+{
+	return (rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,24 @@
+#ifndef RANDOMH
+#define RANDOMH
+
+#include "utils.h"
+
+/*
+    Small PRNG whose whole state lives in the struct, so every generator
+    [or thread] owns its stream & the same seed always replays the same
+    numbers, unlike the global rand().
+*/
+typedef struct rng
+{
+    ullong_t    state[4];
+} rng_t;
+
+// Initialization
+void rng_seed (rng_t* rng, ullong_t seed);
+
+// Operational
+ullong_t rng_next (rng_t* rng);
+ullong_t rng_below (rng_t* rng, ullong_t bound);
+double rng_double (rng_t* rng);
+
+#endif
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "process.h"
+#include "paging.h"
+#include "reclaim.h"
+
+/*=============================== INITIALIZATION ===============================*/
+void init_reclaim_config (reclaim_config_t* config)
+{
+	config->min 			= 0;
+	config->low 			= 0;
+	config->high 			= 0;
+	config->interval 		= RECLAIM_INTERVAL;
+	config->batch 			= RECLAIM_BATCH;
+	config->page_ns 		= RECLAIM_PAGE_NS;
+	config->limits 			= NULL;
+	config->limit_count 	= 0;
+}
+
+/* Resident pages per pid: 256:512, 0 => Unlimited */
+static int parse_limit_list (char* list, reclaim_config_t* config)
+{
+	config->limits = calloc(MAX_PROCESSES, sizeof(ullong_t));
+	config->limit_count = 0;
+
+	for (char* limit = strtok(list, ":"); limit; limit = strtok(NULL, ":"))
+	{
+		if (config->limit_count == MAX_PROCESSES)
+			return -1;
+
+		config->limits[config->limit_count++] = strtoull(limit, NULL, 0);
+	}
+
+	return 0;
+}
+
+/* min=<frames>,low=<frames>,high=<frames>,interval=<accesses>,batch=<pages>,cost=<ns>,limit=<pages>:<pages>... */
+int parse_reclaim_config (const char* spec, reclaim_config_t* config)
+{
+	char* buffer = strdup(spec);
+	char* limit_list = NULL;
+	char* save;
+
+	for (char* option = strtok_r(buffer, ",", &save); option; option = strtok_r(NULL, ",", &save))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - Reclaim Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "min") == 0)
+			config->min = strtoull(value, NULL, 0);
+		else if (strcmp(option, "low") == 0)
+			config->low = strtoull(value, NULL, 0);
+		else if (strcmp(option, "high") == 0)
+			config->high = strtoull(value, NULL, 0);
+		else if (strcmp(option, "interval") == 0)
+			config->interval = strtoul(value, NULL, 0);
+		else if (strcmp(option, "batch") == 0)
+			config->batch = atoi(value);
+		else if (strcmp(option, "cost") == 0)
+			config->page_ns = strtoull(value, NULL, 0);
+		else if (strcmp(option, "limit") == 0)
+			limit_list = value;
+		else
+		{
+			printf("%s - Unknown Reclaim Option: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+	}
+
+	if (limit_list && parse_limit_list(limit_list, config) < 0)
+	{
+		printf("%s - Memory Limits For At Most %d Processes...\n", ERROR_PRINT_TAG, MAX_PROCESSES);
+		free(buffer);
+		return -1;
+	}
+
+	free(buffer);
+
+	if (config->interval == 0 || config->batch <= 0)
+	{
+		printf("%s - Background Reclaim Needs An Interval & A Batch Above 0...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	return 0;
+}
+
+reclaim_t* create_reclaim (reclaim_config_t* config, ullong_t frame_limit)
+{
+	printf("%s - Initializing Page Reclaim...\n", INIT_PRINT_TAG);
+
+	reclaim_t* reclaim = calloc(1, sizeof(reclaim_t));
+	reclaim_config_t* watermarks = &reclaim->config;
+
+	*watermarks = *config;
+
+	/* Watermarks left out follow min, which follows the frame limit */
+	if (watermarks->min == 0)
+		watermarks->min = (frame_limit * RECLAIM_MIN_PERCENT + 99) / 100;
+
+	if (watermarks->low == 0)
+		watermarks->low = 2 * watermarks->min;
+
+	if (watermarks->high == 0)
+		watermarks->high = 3 * watermarks->min;
+
+	if (watermarks->min > watermarks->low || watermarks->low > watermarks->high || watermarks->high >= frame_limit)
+	{
+		printf("%s - Watermarks Must Hold min <= low <= high < %'llu Frames...\n", ERROR_PRINT_TAG, frame_limit);
+		free(reclaim);
+		return NULL;
+	}
+
+	reclaim->next_run 			= config->interval;
+	reclaim->min_free 			= frame_limit;
+	reclaim->process_stall_ns 	= calloc(MAX_PROCESSES, sizeof(ullong_t));
+	reclaim->process_stalls 	= calloc(MAX_PROCESSES, sizeof(unsigned long));
+	reclaim->process_limit_pages = calloc(MAX_PROCESSES, sizeof(unsigned long));
+	reclaim->process_peak 		= calloc(MAX_PROCESSES, sizeof(int));
+
+	return reclaim;
+}
+
+void free_reclaim (reclaim_t* reclaim)
+{
+	if (!reclaim)
+		return;
+
+	free(reclaim->config.limits);
+	free(reclaim->process_stall_ns);
+	free(reclaim->process_stalls);
+	free(reclaim->process_limit_pages);
+	free(reclaim->process_peak);
+	free(reclaim);
+}
+
+/*================================= OPERATIONAL ================================*/
+ullong_t reclaim_limit_of (reclaim_t* reclaim, int pid)
+{
+	reclaim_config_t* config = &reclaim->config;
+
+	if (config->limit_count == 0)
+		return 0;
+
+	return config->limits[(pid < config->limit_count) ? pid : config->limit_count - 1];
+}
+
+/* Reclaim the allocating process waits for, the replay's clock moves on with it */
+static void stall (reclaim_t* reclaim, pager_t* pager, process_t* process, int pages)
+{
+	ullong_t time = pages * reclaim->config.page_ns;
+
+	if (pages == 0)
+		return;
+
+	reclaim->stalls++;
+	reclaim->stall_ns += time;
+	reclaim->process_stalls[process->pid]++;
+	reclaim->process_stall_ns[process->pid] += time;
+
+	if (time > reclaim->max_stall_ns)
+		reclaim->max_stall_ns = time;
+
+	if (pager->swap)
+		pager->swap->now += time;
+}
+
+/* Ahead of every page the pager allocates for the process */
+void reclaim_allocate (reclaim_t* reclaim, pager_t* pager, process_t* process)
+{
+	reclaim_config_t* config = &reclaim->config;
+	ullong_t limit = reclaim_limit_of(reclaim, process->pid);
+	int pages = 0;
+
+	reclaim->allocations++;
+
+	/* A process at its limit makes room among its own pages, however much memory is free */
+	if (limit > 0 && (ullong_t) process->owned_count >= limit)
+	{
+		int evicted = pager_reclaim(pager, process, process->owned_count - limit + 1);
+
+		reclaim->limit_reclaims++;
+		reclaim->limit_pages += evicted;
+		reclaim->process_limit_pages[process->pid] += evicted;
+		pages += evicted;
+	}
+
+	ullong_t free_frames = pager_free_frames(pager);
+
+	if (free_frames < reclaim->min_free)
+		reclaim->min_free = free_frames;
+
+	/* The background reclaimer fell behind, the allocation does its work */
+	if (free_frames <= config->min)
+	{
+		int evicted = pager_reclaim(pager, NULL, config->min - free_frames + 1);
+
+		reclaim->direct_reclaims++;
+		reclaim->direct_pages += evicted;
+		pages += evicted;
+		free_frames = pager_free_frames(pager);
+	}
+
+	stall(reclaim, pager, process, pages);
+
+	/* What the allocation leaves free decides whether the background reclaimer has to wake */
+	if (!reclaim->awake && free_frames <= config->low)
+	{
+		reclaim->awake = 1;
+		reclaim->wakeups++;
+	}
+
+	if (process->owned_count + 1 > reclaim->process_peak[process->pid])
+		reclaim->process_peak[process->pid] = process->owned_count + 1;
+}
+
+/* One pass of the background reclaimer, between two accesses of the replay */
+void reclaim_run (reclaim_t* reclaim, pager_t* pager, unsigned long replayed)
+{
+	reclaim_config_t* config = &reclaim->config;
+
+	reclaim->next_run = replayed + config->interval;
+
+	if (!reclaim->awake)
+		return;
+
+	ullong_t free_frames = pager_free_frames(pager);
+	int wanted = (free_frames < config->high) ? config->high - free_frames : 0;
+	int target = (wanted < config->batch) ? wanted : config->batch;
+	int evicted = pager_reclaim(pager, NULL, target);
+
+	if (evicted > 0)
+	{
+		reclaim->passes++;
+		reclaim->background_pages += evicted;
+		reclaim->background_ns += evicted * config->page_ns;
+	}
+
+	/* Asleep again once high is reached [Or nothing is left to evict] */
+	if (pager_free_frames(pager) >= config->high || evicted < target)
+		reclaim->awake = 0;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_reclaim_stats (reclaim_t* reclaim)
+{
+	reclaim_config_t* config = &reclaim->config;
+	unsigned long reclaimed = reclaim->background_pages + reclaim->direct_pages + reclaim->limit_pages;
+
+	printf("%s", TABLE_RECLAIM_HEADER);
+	printf("Watermarks:\t\t%'llu / %'llu / %'llu (min / low / high free frames, fewest seen %'llu)\n", config->min, config->low, config->high, reclaim->min_free);
+	printf("Allocations:\t\t%'lu\n", reclaim->allocations);
+	printf("Background Reclaim:\t%'lu (pages over %'lu passes, %'lu wakeups, %.3f ms)\n", reclaim->background_pages, reclaim->passes, reclaim->wakeups, reclaim->background_ns / 1e6);
+	printf("Direct Reclaim:\t\t%'lu (pages over %'lu allocations below min)\n", reclaim->direct_pages, reclaim->direct_reclaims);
+	printf("Limit Reclaim:\t\t%'lu (pages over %'lu allocations at a limit)\n", reclaim->limit_pages, reclaim->limit_reclaims);
+	printf("Background Share:\t%.2f%% (of reclaimed pages)\n", reclaimed ? 100.0 * reclaim->background_pages / reclaimed : 0.0);
+	printf("Allocation Stalls:\t%'lu (%.2f%% of allocations)\n", reclaim->stalls, reclaim->allocations ? 100.0 * reclaim->stalls / reclaim->allocations : 0.0);
+	printf("Stall Time:\t\t%.3f (ms, %.1f us avg., %.1f us max)\n", reclaim->stall_ns / 1e6, reclaim->stalls ? reclaim->stall_ns / 1e3 / reclaim->stalls : 0.0, reclaim->max_stall_ns / 1e3);
+
+	for (int pid = 0; pid < MAX_PROCESSES; ++pid)
+	{
+		ullong_t limit = reclaim_limit_of(reclaim, pid);
+
+		if (reclaim->process_peak[pid] == 0)
+			continue;
+
+		if (limit > 0)
+			printf("[PID %d]\t\t\tLimit: %'llu\tPeak: %'d\tOwn Reclaim: %'lu\tStalls: %'lu (%.3f ms)\n", pid, limit, reclaim->process_peak[pid], reclaim->process_limit_pages[pid], reclaim->process_stalls[pid], reclaim->process_stall_ns[pid] / 1e6);
+		else
+			printf("[PID %d]\t\t\tLimit: None\tPeak: %'d\tStalls: %'lu (%.3f ms)\n", pid, reclaim->process_peak[pid], reclaim->process_stalls[pid], reclaim->process_stall_ns[pid] / 1e6);
+	}
+
+	print_header_end('=', strlen(TABLE_RECLAIM_HEADER));
+}
@@ -0,0 +1,72 @@
+#ifndef RECLAIMH
+#define RECLAIMH
+
+#include "utils.h"
+#include "process.h"
+
+struct pager;
+
+typedef struct reclaim_config
+{
+    ullong_t        min;                /* Free frames, 0 => RECLAIM_MIN_PERCENT of the frame limit */
+    ullong_t        low;                /* 0 => 2 x min */
+    ullong_t        high;               /* 0 => 3 x min */
+    unsigned long   interval;           /* Accesses between two background passes */
+    int             batch;              /* Pages a background pass reclaims at most */
+    ullong_t        page_ns;            /* Modeled CPU time to reclaim one page */
+    ullong_t*       limits;             /* Pid -> Frames it may own [0 => Unlimited], NULL => None */
+    int             limit_count;        /* Pids past the list take the last limit */
+} reclaim_config_t;
+
+/*
+    Free frame watermarks in front of the pager. An allocation that finds
+    low frames or fewer free wakes the background reclaimer, which then
+    evicts up to batch pages every interval accesses until high frames are
+    free again & goes back to sleep. An allocation that finds min frames
+    or fewer free reclaims on its own [direct reclaim] & stalls until more
+    than min are. A process with a memory limit evicts its own pages once
+    it owns that many frames, whatever is free [Frames it shares after a
+    fork or maps merged aren't charged to it]. Reclaim time is modeled at
+    page_ns per page, only direct & limit reclaim stall the replay.
+*/
+typedef struct reclaim
+{
+    reclaim_config_t config;
+    unsigned long   next_run;           /* Access count of the next background pass */
+    int             awake;              /* Woken below low, asleep again at high */
+
+    unsigned long   allocations;
+    unsigned long   wakeups;
+    unsigned long   passes;             /* Background passes that reclaimed something */
+    unsigned long   background_pages;
+    ullong_t        background_ns;      /* Modeled time the background reclaimer spent, off the replay */
+    unsigned long   direct_reclaims;    /* Allocations that found min frames or fewer free */
+    unsigned long   direct_pages;
+    unsigned long   limit_reclaims;     /* Allocations of a process at its limit */
+    unsigned long   limit_pages;
+    unsigned long   stalls;             /* Allocations that waited for reclaim */
+    ullong_t        stall_ns;
+    ullong_t        max_stall_ns;
+    ullong_t        min_free;           /* Fewest free frames any allocation saw */
+
+    ullong_t*       process_stall_ns;   /* Pid -> Time its allocations waited */
+    unsigned long*  process_stalls;
+    unsigned long*  process_limit_pages;    /* Pid -> Own pages reclaimed at its limit */
+    int*            process_peak;       /* Pid -> Most frames owned at once */
+} reclaim_t;
+
+// Initialization
+void init_reclaim_config (reclaim_config_t* config);
+int parse_reclaim_config (const char* spec, reclaim_config_t* config);
+reclaim_t* create_reclaim (reclaim_config_t* config, ullong_t frame_limit);
+void free_reclaim (reclaim_t* reclaim);
+
+// Operational
+ullong_t reclaim_limit_of (reclaim_t* reclaim, int pid);
+void reclaim_allocate (reclaim_t* reclaim, struct pager* pager, process_t* process);
+void reclaim_run (reclaim_t* reclaim, struct pager* pager, unsigned long replayed);
+
+// Debugging
+void print_reclaim_stats (reclaim_t* reclaim);
+
+#endif
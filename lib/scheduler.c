@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_map.h"
+#include "trace.h"
+#include "tlb.h"
+#include "process.h"
+#include "page_table.h"
+#include "paging.h"
+#include "scheduler.h"
+#include "checkpoint.h"
+#include "workload.h"
+#include "metrics.h"
+#include "events.h"
+
+/*=============================== INITIALIZATION ===============================*/
+scheduler_t* create_scheduler (pager_t* pager, tlb_t* tlb, int quantum)
+{
+	scheduler_t* scheduler = calloc(1, sizeof(scheduler_t));
+	scheduler->pager 	= pager;
+	scheduler->tlb 		= tlb;
+	scheduler->quantum 	= (quantum > 0) ? quantum : SCHEDULER_QUANTUM;
+	scheduler->current_pid = -1;
+
+	return scheduler;
+}
+
+/* Scheduler owns its processes, traces are owned by the caller as they may be shared */
+void free_scheduler (scheduler_t* scheduler)
+{
+	if (!scheduler)
+		return;
+
+	for (int i = 0; i < scheduler->process_count; ++i)
+		free_process(scheduler->processes[i]);
+
+	free(scheduler->processes);
+	free(scheduler);
+}
+
+void scheduler_add_process (scheduler_t* scheduler, process_t* process)
+{
+	scheduler->processes = realloc(scheduler->processes, (scheduler->process_count + 1) * sizeof(process_t*));
+	scheduler->processes[scheduler->process_count++] = process;
+}
+
+/*================================= OPERATIONAL ================================*/
+/*
+	Copy the parent into children new processes that carry on from the
+	parent's position. A loaded trace is shared, a generated stream is
+	reseeded with the child's pid so the children diverge, as -n does.
+*/
+int scheduler_fork (scheduler_t* scheduler, process_t* parent, int children)
+{
+	pager_t* pager = scheduler->pager;
+
+	for (int i = 0; i < children; ++i)
+	{
+		int pid = scheduler->process_count;
+		trace_t* trace = parent->trace;
+
+		if (pid == MAX_PROCESSES)
+		{
+			printf("%s - At Most %d Processes Supported, Fork Stopped...\n", ERROR_PRINT_TAG, MAX_PROCESSES);
+			return -1;
+		}
+
+		if (trace->workload)
+		{
+			workload_config_t workload_config = trace->workload->config;
+			workload_config.seed += pid;
+
+			trace = create_workload_trace(&workload_config);
+
+			if (!trace)
+				return -1;
+		}
+		else if (trace->binary && !(trace = reopen_trace(trace)))
+		{
+			return -1;
+		}
+
+		process_t* child = create_process(pid, trace);
+		child->owns_trace 	= (trace != parent->trace);
+		child->position 	= parent->position;
+		child->page_table 	= create_page_table(parent->page_table->type, pager, pid);
+
+		if (!child->page_table || pager_fork_process(pager, parent, child) < 0)
+		{
+			free_process(child);
+			return -1;
+		}
+
+		pager_prepare_optimal(pager, child);
+		scheduler_add_process(scheduler, child);
+
+		printf("%s - Process %d Forked Into Process %d At Access %'lu...\n", TRACE_PRINT_TAG, parent->pid, pid, scheduler->replayed);
+	}
+
+	return 0;
+}
+
+/* Data access after translation, pages mapped C_CACHEDISABLED skip the caches */
+static inline void access_data_cache (cache_t* cache, paddr_t address, int is_write, uchar_t control_bits)
+{
+	if ((control_bits & C_CACHEDISABLED) != 0)
+		cache_access_uncached(cache, is_write);
+	else
+		cache_access(cache, address, is_write, CACHE_DATA);
+}
+
+/* Replay up to count accesses of a process, returns how many were replayed */
+unsigned long run_process (scheduler_t* scheduler, process_t* process, unsigned long count)
+{
+	pager_t* pager = scheduler->pager;
+	tlb_t* tlb = scheduler->tlb;
+	cache_t* cache = pager->cache;
+	char* physical_memory = pager->physical_memory;
+	page_table_t* page_table = process->page_table;
+	stack_distance_t* stack_distance = scheduler->stack_distance;
+	trace_stats_t* stats = &process->stats;
+
+	/* Generated traces may hand back fewer entries than asked for, the rest come next call */
+	unsigned long start = process->position;
+	trace_entry_t* entries = trace_window(process->trace, start, &count);
+	unsigned long end = start + count;
+	unsigned long faults = stats->faults;
+	unsigned long tlb_hits = 0;
+	unsigned long cow_traps = 0;
+
+	/* Hot loop: No I/O, results are only accumulated into stats [& the calling thread's metrics shard] */
+	translation_t translation;
+
+	for (; process->position < end; ++process->position)
+	{
+		vaddr_t address = entries[process->position - start].address;
+		uchar_t is_write = entries[process->position - start].is_write;
+		ullong_t virtual_page_number = address >> GEO_PAGE_SHIFT;
+		ullong_t frame_number;
+		uchar_t* entry_bits;
+
+		stats->writes += is_write;
+
+		if (stack_distance)
+			stack_distance_reference(stack_distance, process->pid, virtual_page_number);
+
+		int tlb_hit = tlb && tlb_lookup(tlb, virtual_page_number, &frame_number, &entry_bits);
+
+		/* TLB hit skips the page table walk entirely, copy-on-write pages trap on their first write, cached or not */
+		if (tlb_hit && (!is_write || (*entry_bits & C_COW) == 0))
+		{
+			stats->hits++;
+			stats->checksum += (uchar_t) physical_memory[(frame_number << GEO_PAGE_SHIFT) | (address & GEO_OFFSET_MASK)];
+			tlb_hits++;
+
+			if (metrics)
+				metrics_record(METRIC_TRANSLATION_CYCLES, tlb->config.hit_latency);
+
+			/* First write through a clean entry dirties the page table entry, later ones find C_DIRTY cached */
+			if (is_write && (*entry_bits & C_DIRTY) == 0)
+			{
+				uchar_t* control_bits = page_table_control(page_table, virtual_page_number);
+
+				if (control_bits)
+					*control_bits |= C_DIRTY;
+
+				/* A huge entry covers pages dirtied one by one */
+				if ((*entry_bits & C_HUGE) == 0)
+					*entry_bits |= C_DIRTY;
+			}
+
+			if (cache)
+				access_data_cache(cache, (frame_number << GEO_PAGE_SHIFT) | (address & GEO_OFFSET_MASK), is_write, *entry_bits);
+
+			pager_touch(pager, process, virtual_page_number, frame_number);
+			continue;
+		}
+
+		/* Still a TLB hit, the write only traps to the walk */
+		cow_traps += tlb_hit;
+
+		int result = page_table_translate(page_table, address, is_write, &translation);
+
+		if (tlb)
+			tlb_charge_walk(tlb, translation.memory_references);
+
+		if (events && tlb_hit)
+			events_record(EVENT_COW_TRAP, process->pid, virtual_page_number, frame_number, EVENT_WRITE, 0);
+		else if (events && tlb)
+			events_record(EVENT_TLB_MISS, process->pid, virtual_page_number, 0, is_write ? EVENT_WRITE : 0, 0);
+
+		if (events)
+			events_record(EVENT_WALK, process->pid, virtual_page_number, translation.memory_references, is_write ? EVENT_WRITE : 0, 0);
+
+		/* Same cycles the TLB charges, a walk without one at MEMORY_LATENCY a reference */
+		if (metrics)
+			metrics_record(METRIC_TRANSLATION_CYCLES, tlb ? tlb->config.hit_latency + translation.memory_references * tlb->config.memory_latency
+				: translation.memory_references * MEMORY_LATENCY);
+
+		if (result == T_MAPPED)
+		{
+			stats->hits++;
+
+			if (is_write && (translation.control_bits & C_COW) != 0)
+			{
+				if (pager_break_cow(pager, process, virtual_page_number) < 0)
+					continue;
+
+				page_table_translate(page_table, address, is_write, &translation);
+			}
+		}
+		else
+		{
+			stats->faults++;
+
+			/* Inverted tables keep no entry for swapped pages, so ask the swap map */
+			int is_major = page_map_get(process->swap_slots, virtual_page_number, -1) >= 0;
+
+			if (is_major)
+				stats->disk_reads++;
+
+			ullong_t fault_started = metrics ? metrics_clock() : 0;
+			ullong_t event_started = events ? events_clock() : 0;
+			long long frame = pager_handle_fault(pager, process, virtual_page_number, is_write);
+
+			if (frame < 0)
+				continue;
+
+			if (metrics)
+				metrics_record(METRIC_FAULT_NS, metrics_clock() - fault_started);
+
+			if (events)
+				events_record(EVENT_FAULT, process->pid, virtual_page_number, frame, (is_write ? EVENT_WRITE : 0) | (is_major ? EVENT_MAJOR : 0), event_started);
+
+			page_table_translate(page_table, address, is_write, &translation);
+		}
+
+		stats->checksum += (uchar_t) physical_memory[translation.physical_address];
+
+		/* One entry covers the whole huge page [The walk has just dirtied a written page] */
+		uchar_t inserted_bits = translation.control_bits | (is_write ? C_DIRTY : 0x00);
+
+		if (tlb && (translation.control_bits & C_HUGE) != 0)
+			tlb_insert_huge(tlb, virtual_page_number, translation.physical_frame_number, inserted_bits);
+		else if (tlb)
+			tlb_insert(tlb, virtual_page_number, translation.physical_frame_number, inserted_bits);
+
+		if (cache)
+			access_data_cache(cache, translation.physical_address, is_write, translation.control_bits);
+
+		pager_touch(pager, process, translation.virtual_page_number, translation.physical_frame_number);
+	}
+
+	stats->accesses += end - start;
+	stats->reads = stats->accesses - stats->writes;
+
+	/* Counters once per call, only the histograms are fed per access */
+	if (metrics)
+	{
+		metrics_count(METRIC_ACCESSES, end - start);
+		metrics_count(METRIC_TLB_HITS, tlb_hits + cow_traps);
+		metrics_count(METRIC_TLB_MISSES, tlb ? end - start - tlb_hits - cow_traps : 0);
+		metrics_count(METRIC_COW_TRAPS, cow_traps);
+		metrics_count(METRIC_FAULTS, stats->faults - faults);
+	}
+
+	return end - start;
+}
+
+static int scheduler_has_work (scheduler_t* scheduler)
+{
+	for (int i = 0; i < scheduler->process_count; ++i)
+	{
+		if (process_has_work(scheduler->processes[i]))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+	Round-robin over every process with work left. The position inside the
+	rotation is kept in the scheduler, so a run stopped for a checkpoint
+	mid-quantum resumes exactly where it left off once restored.
+*/
+void run_scheduler (scheduler_t* scheduler)
+{
+	printf("%s - Scheduling %d Process(es), Quantum %d (accesses)...\n", TRACE_PRINT_TAG, scheduler->process_count, scheduler->quantum);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (scheduler->process_count > 0 && scheduler_has_work(scheduler))
+	{
+		process_t* process = scheduler->processes[scheduler->current];
+
+		if (process_has_work(process) && scheduler->slice_used < scheduler->quantum)
+		{
+			unsigned long count = scheduler->quantum - scheduler->slice_used;
+			int checkpoint_pending = scheduler->checkpoint_path && scheduler->replayed <= scheduler->checkpoint_at;
+			int fork_pending = scheduler->fork_children > 0 && scheduler->replayed <= scheduler->fork_at;
+			working_set_t* working_set = scheduler->working_set;
+			ksm_t* ksm = scheduler->pager->ksm;
+			reclaim_t* reclaim = scheduler->pager->reclaim;
+
+			if (process->pid != scheduler->current_pid)
+			{
+				if (scheduler->current_pid >= 0)
+					scheduler->context_switches++;
+
+				if (scheduler->tlb)
+					tlb_context_switch(scheduler->tlb, process->pid);
+
+				if (scheduler->stack_distance)
+					stack_distance_context_switch(scheduler->stack_distance, process->pid);
+
+				scheduler->current_pid = process->pid;
+			}
+
+			/* Stop short of the quantum if the checkpoint falls inside it */
+			if (checkpoint_pending && scheduler->replayed + count > scheduler->checkpoint_at)
+				count = scheduler->checkpoint_at - scheduler->replayed;
+
+			/* Same for the fork */
+			if (fork_pending && scheduler->replayed + count > scheduler->fork_at)
+				count = scheduler->fork_at - scheduler->replayed;
+
+			/* And for the next working set sample */
+			if (working_set && scheduler->replayed + count > working_set->next_sample)
+				count = working_set->next_sample - scheduler->replayed;
+
+			/* And for the next dedup scan pass */
+			if (ksm && scheduler->replayed + count > ksm->next_scan)
+				count = ksm->next_scan - scheduler->replayed;
+
+			/* And for the background reclaimer */
+			if (reclaim && scheduler->replayed + count > reclaim->next_run)
+				count = reclaim->next_run - scheduler->replayed;
+
+			unsigned long replayed = run_process(scheduler, process, count);
+
+			scheduler->slice_used += replayed;
+			scheduler->replayed += replayed;
+
+			if (checkpoint_pending && scheduler->replayed == scheduler->checkpoint_at)
+			{
+				save_checkpoint(scheduler->checkpoint_path, scheduler);
+				scheduler->checkpoint_path = NULL;
+			}
+
+			if (working_set && scheduler->replayed == working_set->next_sample)
+				working_set_sample(working_set, scheduler->pager, scheduler->replayed);
+
+			if (ksm && scheduler->replayed == ksm->next_scan)
+				ksm_scan(ksm, scheduler->pager, scheduler->replayed);
+
+			if (reclaim && scheduler->replayed == reclaim->next_run)
+				reclaim_run(reclaim, scheduler->pager, scheduler->replayed);
+
+			if (fork_pending && scheduler->replayed == scheduler->fork_at)
+			{
+				scheduler_fork(scheduler, process, scheduler->fork_children);
+				scheduler->fork_children = 0;
+			}
+
+			if (scheduler->slice_used < scheduler->quantum && process_has_work(process))
+				continue;
+		}
+
+		scheduler->slice_used = 0;
+		scheduler->current = (scheduler->current + 1) % scheduler->process_count;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	/* Fold per-process results into the totals */
+	trace_stats_t* totals = &scheduler->stats;
+	memset(totals, 0, sizeof(trace_stats_t));
+
+	for (int i = 0; i < scheduler->process_count; ++i)
+	{
+		trace_stats_t* stats = &scheduler->processes[i]->stats;
+
+		totals->accesses 	+= stats->accesses;
+		totals->reads 		+= stats->reads;
+		totals->writes 		+= stats->writes;
+		totals->hits 		+= stats->hits;
+		totals->faults 		+= stats->faults;
+		totals->disk_reads 	+= stats->disk_reads;
+		totals->checksum 	+= stats->checksum;
+	}
+
+	totals->elapsed_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_scheduler_stats (scheduler_t* scheduler)
+{
+	print_trace_stats(&scheduler->stats);
+
+	printf("%s", TABLE_SCHEDULER_HEADER);
+	printf("Processes:\t\t%d\n", scheduler->process_count);
+	printf("Quantum:\t\t%d (accesses)\n", scheduler->quantum);
+	printf("Context Switches:\t%'lu\n", scheduler->context_switches);
+
+	for (int i = 0; i < scheduler->process_count; ++i)
+		print_process_stats(scheduler->processes[i]);
+
+	print_header_end('=', strlen(TABLE_SCHEDULER_HEADER));
+}
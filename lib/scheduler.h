@@ -0,0 +1,50 @@
+#ifndef SCHEDULERH
+#define SCHEDULERH
+
+#include "utils.h"
+#include "trace.h"
+#include "tlb.h"
+#include "process.h"
+#include "paging.h"
+#include "stack_distance.h"
+#include "working_set.h"
+
+/* Round-robin scheduler interleaving every process' trace on one simulated CPU */
+typedef struct scheduler
+{
+    process_t**     processes;
+    int             process_count;
+    int             quantum;            /* Accesses replayed before switching process */
+    pager_t*        pager;
+    tlb_t*          tlb;
+
+    int             current;            /* Index of the process holding the CPU */
+    int             current_pid;        /* Address space loaded in the TLB, -1 before the first slice */
+    int             slice_used;         /* Accesses of the current quantum already replayed */
+    unsigned long   replayed;           /* Accesses replayed across every process */
+
+    unsigned long   checkpoint_at;      /* Save a checkpoint once this many accesses were replayed */
+    const char*     checkpoint_path;    /* NULL => No checkpoint */
+    stack_distance_t* stack_distance;   /* Every page reference is fed to it, NULL => No miss ratio curve */
+    unsigned long   fork_at;            /* Fork the running process once this many accesses were replayed */
+    int             fork_children;      /* 0 => No fork */
+    working_set_t*  working_set;        /* Sampled every interval of accesses, NULL => No sampling */
+
+    unsigned long   context_switches;
+    trace_stats_t   stats;              /* Totals across every process */
+} scheduler_t;
+
+// Initialization
+scheduler_t* create_scheduler (pager_t* pager, tlb_t* tlb, int quantum);
+void free_scheduler (scheduler_t* scheduler);
+void scheduler_add_process (scheduler_t* scheduler, process_t* process);
+
+// Operational
+unsigned long run_process (scheduler_t* scheduler, process_t* process, unsigned long count);
+void run_scheduler (scheduler_t* scheduler);
+int scheduler_fork (scheduler_t* scheduler, process_t* parent, int children);
+
+// Debugging
+void print_scheduler_stats (scheduler_t* scheduler);
+
+#endif
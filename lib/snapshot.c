@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_table.h"
+#include "process.h"
+#include "paging.h"
+#include "snapshot.h"
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+static inline ullong_t align_up (ullong_t value, ullong_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static int is_zero_block (const char* data, ullong_t size)
+{
+	return data[0] == 0 && memcmp(data, data + 1, size - 1) == 0;
+}
+
+/* Blocks of zeros are skipped, the destination is already zero [ftruncate or calloc] */
+static void copy_sparse (char* destination, const char* source, ullong_t size)
+{
+	for (ullong_t offset = 0; offset < size; offset += SNAPSHOT_ALIGNMENT)
+	{
+		ullong_t block = (size - offset < (ullong_t) SNAPSHOT_ALIGNMENT) ? size - offset : (ullong_t) SNAPSHOT_ALIGNMENT;
+
+		if (!is_zero_block(source + offset, block))
+			memcpy(destination + offset, source + offset, block);
+	}
+}
+
+/* Header, table records & frame bitmap, everything in front of the memory image */
+static char* build_metadata (pager_t* pager, process_t** processes, int process_count, ullong_t state_size, snapshot_header_t* header)
+{
+	ullong_t alignment = (geometry.page_size > (ullong_t) SNAPSHOT_ALIGNMENT) ? geometry.page_size : (ullong_t) SNAPSHOT_ALIGNMENT;
+	int table_count = 0;
+
+	for (int i = 0; i < process_count; ++i)
+	{
+		if (processes[i] && processes[i]->page_table)
+			table_count++;
+	}
+
+	memset(header, 0x00, sizeof(snapshot_header_t));
+	memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+	header->version 				= SNAPSHOT_VERSION;
+	header->header_size 			= sizeof(snapshot_header_t);
+	header->va_bits 				= geometry.va_bits;
+	header->pa_bits 				= geometry.pa_bits;
+	header->page_shift 				= geometry.page_shift;
+	header->pte_size 				= geometry.pte_size;
+	header->table_count 			= table_count;
+	header->physical_memory_size 	= geometry.physical_memory_size;
+	header->frame_count 			= geometry.frame_count;
+	header->disk_memory_size 		= geometry.disk_memory_size;
+	header->disk_frame_count 		= geometry.disk_frame_count;
+	header->table_offset 			= sizeof(snapshot_header_t);
+	header->bitmap_offset 			= header->table_offset + (table_count * sizeof(snapshot_table_t));
+	header->bitmap_size 			= (geometry.frame_count + 7) / 8;
+	header->memory_offset 			= align_up(header->bitmap_offset + header->bitmap_size, alignment);
+	header->disk_offset 			= align_up(header->memory_offset + geometry.physical_memory_size, alignment);
+	header->state_offset 			= align_up(header->disk_offset + geometry.disk_memory_size, sizeof(ullong_t));
+	header->state_size 				= state_size;
+	header->file_size 				= header->state_offset + state_size;
+
+	char* metadata = calloc(1, header->memory_offset);
+
+	if (!metadata)
+		return NULL;
+
+	memcpy(metadata, header, sizeof(snapshot_header_t));
+
+	snapshot_table_t* tables = (snapshot_table_t*) (metadata + header->table_offset);
+
+	for (int i = 0, t = 0; i < process_count; ++i)
+	{
+		page_table_t* page_table = processes[i] ? processes[i]->page_table : NULL;
+
+		if (!page_table)
+			continue;
+
+		tables[t].pid 				= page_table->pid;
+		tables[t].type 				= page_table->type;
+		tables[t].levels 			= page_table->levels;
+		tables[t].bits_per_level 	= page_table->bits_per_level;
+		tables[t].entry_size 		= page_table->entry_size;
+		tables[t].base 				= page_table->base;
+		tables[t].table_bytes 		= page_table->table_bytes;
+		t++;
+	}
+
+	uchar_t* bitmap = (uchar_t*) (metadata + header->bitmap_offset);
+
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		if (pager->frame_page[frame] != FRAME_FREE)
+			bitmap[frame >> 3] |= 1 << (frame & 7);
+	}
+
+	return metadata;
+}
+
+/*=============================== INITIALIZATION ===============================*/
+snapshot_t* map_snapshot (const char* file_path)
+{
+	char* mapping = NULL;
+	ullong_t mapping_size = 0;
+
+#ifdef __linux__
+	struct stat status;
+	int fd = open(file_path, O_RDONLY);
+
+	if (fd >= 0 && fstat(fd, &status) == 0 && status.st_size >= (off_t) sizeof(snapshot_header_t))
+	{
+		mapping_size = status.st_size;
+
+		/* Private & writable so a restored machine can run on the mapping [Copy on write] */
+		mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+		if (mapping == MAP_FAILED)
+			mapping = NULL;
+	}
+
+	if (fd >= 0)
+		close(fd);
+#else
+	FILE *fp = fopen(file_path, "rb");
+
+	if (fp != NULL)
+	{
+		fseek(fp, 0, SEEK_END);
+		mapping_size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		mapping = (mapping_size >= sizeof(snapshot_header_t)) ? malloc(mapping_size) : NULL;
+
+		if (mapping && fread(mapping, 1, mapping_size, fp) != mapping_size)
+		{
+			free(mapping);
+			mapping = NULL;
+		}
+
+		fclose(fp);
+	}
+#endif
+
+	if (!mapping)
+	{
+		printf("%s - Failed To Map Snapshot: %s\n", ERROR_PRINT_TAG, file_path);
+		return NULL;
+	}
+
+	snapshot_t* snapshot = calloc(1, sizeof(snapshot_t));
+	snapshot->mapping 		= mapping;
+	snapshot->mapping_size 	= mapping_size;
+	snapshot->header 		= (snapshot_header_t*) mapping;
+
+	snapshot_header_t* header = snapshot->header;
+
+	if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+	{
+		printf("%s - Not A Snapshot File: %s\n", ERROR_PRINT_TAG, file_path);
+		unmap_snapshot(snapshot);
+		return NULL;
+	}
+
+	if (header->version != (uint_t) SNAPSHOT_VERSION || header->header_size != sizeof(snapshot_header_t))
+	{
+		printf("%s - Unsupported Snapshot Version %u [Expected %d]...\n", ERROR_PRINT_TAG, header->version, SNAPSHOT_VERSION);
+		unmap_snapshot(snapshot);
+		return NULL;
+	}
+
+	if (header->file_size != mapping_size
+		|| header->bitmap_offset + header->bitmap_size > header->memory_offset
+		|| header->memory_offset + header->physical_memory_size > header->disk_offset
+		|| header->disk_offset + header->disk_memory_size > header->state_offset
+		|| header->state_offset + header->state_size > header->file_size
+		|| header->table_offset + (header->table_count * sizeof(snapshot_table_t)) > header->bitmap_offset)
+	{
+		printf("%s - Truncated Or Corrupt Snapshot: %s\n", ERROR_PRINT_TAG, file_path);
+		unmap_snapshot(snapshot);
+		return NULL;
+	}
+
+	snapshot->tables 			= (snapshot_table_t*) (mapping + header->table_offset);
+	snapshot->frame_bitmap 		= (uchar_t*) (mapping + header->bitmap_offset);
+	snapshot->physical_memory 	= mapping + header->memory_offset;
+	snapshot->disk_memory 		= mapping + header->disk_offset;
+	snapshot->state 			= (header->state_size > 0) ? mapping + header->state_offset : NULL;
+
+	return snapshot;
+}
+
+void unmap_snapshot (snapshot_t* snapshot)
+{
+	if (!snapshot)
+		return;
+
+#ifdef __linux__
+	munmap(snapshot->mapping, snapshot->mapping_size);
+#else
+	free(snapshot->mapping);
+#endif
+
+	free(snapshot);
+}
+
+/* Tables in the image can only be walked with the geometry they were written with */
+int configure_snapshot_geometry (snapshot_t* snapshot, geometry_t* geometry)
+{
+	snapshot_header_t* header = snapshot->header;
+
+	if (configure_geometry(geometry, header->va_bits, header->pa_bits, 1ULL << header->page_shift, header->physical_memory_size, header->disk_memory_size) < 0)
+		return -1;
+
+	if (geometry->pte_size != (int) header->pte_size)
+	{
+		printf("%s - Snapshot Entry Size %u Doesn't Match Geometry [%d]...\n", ERROR_PRINT_TAG, header->pte_size, geometry->pte_size);
+		return -1;
+	}
+
+	return 0;
+}
+
+page_table_t* attach_snapshot_table (snapshot_t* snapshot, int index)
+{
+	snapshot_table_t* table = &snapshot->tables[index];
+
+	return attach_page_table(table->type, snapshot->physical_memory, table->pid, table->base);
+}
+
+/* Zero blocks are skipped so untouched simulated memory stays unbacked */
+void load_snapshot_memory (snapshot_t* snapshot, char* physical_memory, char* disk_memory)
+{
+	copy_sparse(physical_memory, snapshot->physical_memory, snapshot->header->physical_memory_size);
+	copy_sparse(disk_memory, snapshot->disk_memory, snapshot->header->disk_memory_size);
+}
+
+/*================================== FILE I/O ==================================*/
+/*
+	The file is sized up front and filled through one shared mapping, only
+	blocks holding data are touched so untouched memory costs no disk space.
+*/
+int write_snapshot (const char* file_path, pager_t* pager, process_t** processes, int process_count, const char* state, ullong_t state_size)
+{
+	printf("%s - Writing Snapshot: %s\n", SNAPSHOT_PRINT_TAG, file_path);
+
+	if (!pager)
+	{
+		printf("%s - Pager Not Defined...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	snapshot_header_t header;
+	char* metadata = build_metadata(pager, processes, process_count, state_size, &header);
+	int result = -1;
+
+	/* Pages held compressed only reach the disk image on a write back, the snapshot needs them all */
+	if (pager->zswap)
+		zswap_sync(pager->zswap);
+
+	if (!metadata)
+	{
+		printf("%s - Failed To Build Snapshot Header...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+#ifdef __linux__
+	int fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (fd >= 0 && ftruncate(fd, header.file_size) == 0)
+	{
+		char* mapping = mmap(NULL, header.file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		if (mapping != MAP_FAILED)
+		{
+			memcpy(mapping, metadata, header.memory_offset);
+			copy_sparse(mapping + header.memory_offset, pager->physical_memory, header.physical_memory_size);
+			copy_sparse(mapping + header.disk_offset, pager->disk_memory, header.disk_memory_size);
+
+			if (state_size > 0)
+				memcpy(mapping + header.state_offset, state, state_size);
+
+			munmap(mapping, header.file_size);
+			result = 0;
+		}
+	}
+
+	if (fd >= 0)
+		close(fd);
+#else
+	FILE *fp = fopen(file_path, "wb");
+
+	if (fp != NULL)
+	{
+		fwrite(metadata, 1, header.memory_offset, fp);
+		fwrite(pager->physical_memory, 1, header.physical_memory_size, fp);
+		fseek(fp, header.disk_offset, SEEK_SET);
+		fwrite(pager->disk_memory, 1, header.disk_memory_size, fp);
+		fseek(fp, header.state_offset, SEEK_SET);
+		fwrite(state, 1, state_size, fp);
+		result = ferror(fp) ? -1 : 0;
+		fclose(fp);
+	}
+#endif
+
+	free(metadata);
+
+	if (result < 0)
+		printf("%s - Failed To Write Snapshot: %s\n", ERROR_PRINT_TAG, file_path);
+
+	return result;
+}
+
+/*================================= OPERATIONAL ================================*/
+int snapshot_frame_used (snapshot_t* snapshot, ullong_t frame)
+{
+	return (snapshot->frame_bitmap[frame >> 3] >> (frame & 7)) & 1;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_snapshot_header (snapshot_t* snapshot)
+{
+	snapshot_header_t* header = snapshot->header;
+	ullong_t used_frames = 0;
+
+	for (ullong_t frame = 0; frame < header->frame_count; ++frame)
+		used_frames += snapshot_frame_used(snapshot, frame);
+
+	printf("%s", TABLE_SNAPSHOT_HEADER);
+	printf("Version:\t\t%u\n", header->version);
+	printf("Virtual Address:\t%u (bits)\n", header->va_bits);
+	printf("Physical Address:\t%u (bits)\n", header->pa_bits);
+	printf("Page Size:\t\t%'llu (bytes)\n", 1ULL << header->page_shift);
+	printf("Entry Size:\t\t%u (bytes)\n", header->pte_size);
+	printf("Physical Memory:\t%'llu (bytes)\n", header->physical_memory_size);
+	printf("Frames Used:\t\t%'llu / %'llu\n", used_frames, header->frame_count);
+	printf("Disk Memory:\t\t%'llu (bytes)\n", header->disk_memory_size);
+	printf("Page Tables:\t\t%u\n", header->table_count);
+
+	for (uint_t i = 0; i < header->table_count; ++i)
+	{
+		snapshot_table_t* table = &snapshot->tables[i];
+		printf("  PID %d:\t\t%s @ 0x%llX [%'llu bytes]\n", table->pid, get_page_table_name(table->type), table->base, table->table_bytes);
+	}
+
+	printf("Checkpoint State:\t%'llu (bytes)\n", header->state_size);
+	printf("File Size:\t\t%'llu (bytes)\n", header->file_size);
+	print_header_end('=', strlen(TABLE_SNAPSHOT_HEADER));
+}
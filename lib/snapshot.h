@@ -0,0 +1,89 @@
+#ifndef SNAPSHOTH
+#define SNAPSHOTH
+
+#include "utils.h"
+#include "geometry.h"
+#include "page_table.h"
+#include "process.h"
+#include "paging.h"
+
+/*
+    Binary machine snapshot, laid out so it can be mapped straight back in:
+
+    [Header][Page table records][Frame bitmap] ... [Physical memory] ... [Disk memory][State]
+
+    Memory & disk images start on a SNAPSHOT_ALIGNMENT [or page size]
+    boundary and all-zero blocks are never written, so the file stays
+    sparse on disk for mostly empty address spaces. Integers are stored
+    in host byte order. Checkpoints append the simulator state [pager,
+    TLB, processes & scheduler] after the disk image.
+*/
+typedef struct snapshot_header
+{
+    char        magic[8];               /* SNAPSHOT_MAGIC */
+    uint_t      version;                /* SNAPSHOT_VERSION */
+    uint_t      header_size;            /* sizeof(snapshot_header_t) */
+    uint_t      va_bits;
+    uint_t      pa_bits;
+    uint_t      page_shift;
+    uint_t      pte_size;
+    uint_t      table_count;
+    uint_t      reserved;
+    ullong_t    physical_memory_size;
+    ullong_t    frame_count;
+    ullong_t    disk_memory_size;
+    ullong_t    disk_frame_count;
+    ullong_t    table_offset;           /* File offsets of every section */
+    ullong_t    bitmap_offset;
+    ullong_t    bitmap_size;
+    ullong_t    memory_offset;
+    ullong_t    disk_offset;
+    ullong_t    state_offset;
+    ullong_t    state_size;             /* 0 => Plain snapshot, no checkpoint state */
+    ullong_t    file_size;
+} snapshot_header_t;
+
+/* Where a process' page table lives in the physical memory image */
+typedef struct snapshot_table
+{
+    int         pid;
+    int         type;                   /* PT_LINEAR, PT_RADIX_2, PT_RADIX_4, PT_INVERTED */
+    int         levels;
+    int         bits_per_level;
+    int         entry_size;
+    int         reserved;
+    long long   base;
+    ullong_t    table_bytes;
+} snapshot_table_t;
+
+/* A mapped snapshot, every pointer points into the mapping */
+typedef struct snapshot
+{
+    snapshot_header_t*  header;
+    snapshot_table_t*   tables;
+    uchar_t*            frame_bitmap;   /* 1 bit per frame, set if the frame holds a page or a table */
+    char*               physical_memory;
+    char*               disk_memory;
+    char*               state;
+
+    char*               mapping;
+    ullong_t            mapping_size;
+} snapshot_t;
+
+// Initialization
+snapshot_t* map_snapshot (const char* file_path);
+void unmap_snapshot (snapshot_t* snapshot);
+int configure_snapshot_geometry (snapshot_t* snapshot, geometry_t* geometry);
+page_table_t* attach_snapshot_table (snapshot_t* snapshot, int index);
+void load_snapshot_memory (snapshot_t* snapshot, char* physical_memory, char* disk_memory);
+
+// File I/O
+int write_snapshot (const char* file_path, pager_t* pager, process_t** processes, int process_count, const char* state, ullong_t state_size);
+
+// Operational
+int snapshot_frame_used (snapshot_t* snapshot, ullong_t frame);
+
+// Debugging
+void print_snapshot_header (snapshot_t* snapshot);
+
+#endif
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "page_map.h"
+#include "stack_distance.h"
+
+static ullong_t STACK_INITIAL_CAPACITY = 65536;
+static ullong_t STACK_SLOT_EMPTY = ~0ULL;
+
+/*=============================== INITIALIZATION ===============================*/
+stack_distance_t* create_stack_distance (int flush_on_switch)
+{
+	stack_distance_t* analyser = calloc(1, sizeof(stack_distance_t));
+	analyser->last_reference 	= create_page_map(0);
+	analyser->capacity 			= STACK_INITIAL_CAPACITY;
+	analyser->slot_keys 		= malloc(analyser->capacity * sizeof(ullong_t));
+	analyser->tree 				= calloc(analyser->capacity + 1, sizeof(uint_t));
+	analyser->flush_on_switch 	= flush_on_switch;
+	analyser->current_pid 		= -1;
+
+	return analyser;
+}
+
+void free_stack_distance (stack_distance_t* analyser)
+{
+	if (!analyser)
+		return;
+
+	free_page_map(analyser->last_reference);
+	free(analyser->slot_keys);
+	free(analyser->tree);
+	free(analyser->memory_histogram);
+	free(analyser->tlb_histogram);
+	free(analyser);
+}
+
+/*================================= OPERATIONAL ================================*/
+/* Fenwick tree, slot s is node s + 1 */
+static void update_slot (stack_distance_t* analyser, ullong_t slot, int delta)
+{
+	for (ullong_t node = slot + 1; node <= analyser->capacity; node += node & (~node + 1))
+		analyser->tree[node] += delta;
+}
+
+/* Occupied slots up to & including slot */
+static ullong_t count_slots (stack_distance_t* analyser, ullong_t slot)
+{
+	ullong_t count = 0;
+
+	for (ullong_t node = slot + 1; node > 0; node -= node & (~node + 1))
+		count += analyser->tree[node];
+
+	return count;
+}
+
+/*
+	Time slots run out long before a long trace does, so once they do the
+	occupied ones [one per page] are packed down to the front & the tree
+	is rebuilt. Capacity stays at least twice the page count, which keeps
+	the cost of packing constant per reference.
+*/
+static void compact_slots (stack_distance_t* analyser)
+{
+	ullong_t pages = analyser->last_reference->count;
+	ullong_t capacity = analyser->capacity;
+	ullong_t packed = 0;
+	ullong_t flushed_at = 0;
+
+	while (pages * 2 > capacity)
+		capacity <<= 1;
+
+	ullong_t* slot_keys = malloc(capacity * sizeof(ullong_t));
+
+	for (ullong_t slot = 0; slot < analyser->now; ++slot)
+	{
+		if (analyser->slot_keys[slot] == STACK_SLOT_EMPTY)
+			continue;
+
+		if (slot < analyser->flushed_at)
+			flushed_at++;
+
+		slot_keys[packed] = analyser->slot_keys[slot];
+		page_map_put(analyser->last_reference, slot_keys[packed], packed);
+		packed++;
+	}
+
+	free(analyser->slot_keys);
+	free(analyser->tree);
+
+	analyser->slot_keys 	= slot_keys;
+	analyser->tree 			= calloc(capacity + 1, sizeof(uint_t));
+	analyser->capacity 		= capacity;
+	analyser->now 			= packed;
+	analyser->flushed_at 	= flushed_at;
+
+	/* Linear build: Every node passes its count on to its parent */
+	for (ullong_t node = 1; node <= capacity; ++node)
+	{
+		ullong_t parent = node + (node & (~node + 1));
+
+		analyser->tree[node] += (node <= packed);
+
+		if (parent <= capacity)
+			analyser->tree[parent] += analyser->tree[node];
+	}
+}
+
+static void grow_histograms (stack_distance_t* analyser, ullong_t distance)
+{
+	ullong_t size = analyser->histogram_size ? analyser->histogram_size : 64;
+
+	while (size <= distance)
+		size <<= 1;
+
+	analyser->memory_histogram 	= realloc(analyser->memory_histogram, size * sizeof(unsigned long));
+	analyser->tlb_histogram 	= realloc(analyser->tlb_histogram, size * sizeof(unsigned long));
+
+	memset(analyser->memory_histogram + analyser->histogram_size, 0, (size - analyser->histogram_size) * sizeof(unsigned long));
+	memset(analyser->tlb_histogram + analyser->histogram_size, 0, (size - analyser->histogram_size) * sizeof(unsigned long));
+
+	analyser->histogram_size = size;
+}
+
+/* Pages of different processes are different pages, as they are to the pager & an ASID tagged TLB */
+void stack_distance_reference (stack_distance_t* analyser, int pid, ullong_t virtual_page_number)
+{
+	ullong_t key = ((ullong_t) pid << MAX_VPN_BITS) | virtual_page_number;
+
+	if (analyser->now == analyser->capacity)
+		compact_slots(analyser);
+
+	long long previous = page_map_get(analyser->last_reference, key, -1);
+
+	analyser->references++;
+
+	if (previous < 0)
+	{
+		analyser->cold_misses++;
+		analyser->tlb_cold_misses++;
+	}
+	else
+	{
+		/* Distinct pages referenced since this one was, i.e. its depth in the LRU stack */
+		ullong_t distance = analyser->last_reference->count - count_slots(analyser, previous);
+
+		if (distance >= analyser->histogram_size)
+			grow_histograms(analyser, distance);
+
+		analyser->memory_histogram[distance]++;
+
+		/* Everything the TLB held before the last flush is gone, at any size */
+		if ((ullong_t) previous < analyser->flushed_at)
+			analyser->tlb_cold_misses++;
+		else
+			analyser->tlb_histogram[distance]++;
+
+		analyser->slot_keys[previous] = STACK_SLOT_EMPTY;
+		update_slot(analyser, previous, -1);
+	}
+
+	analyser->slot_keys[analyser->now] = key;
+	update_slot(analyser, analyser->now, 1);
+	page_map_put(analyser->last_reference, key, analyser->now);
+	analyser->now++;
+}
+
+void stack_distance_context_switch (stack_distance_t* analyser, int pid)
+{
+	if (analyser->flush_on_switch && analyser->current_pid >= 0 && pid != analyser->current_pid)
+		analyser->flushed_at = analyser->now;
+
+	analyser->current_pid = pid;
+}
+
+static unsigned long count_misses (unsigned long* histogram, ullong_t histogram_size, unsigned long cold_misses, ullong_t size)
+{
+	unsigned long misses = cold_misses;
+
+	for (ullong_t distance = size; distance < histogram_size; ++distance)
+		misses += histogram[distance];
+
+	return misses;
+}
+
+unsigned long get_memory_misses (stack_distance_t* analyser, ullong_t frames)
+{
+	return count_misses(analyser->memory_histogram, analyser->histogram_size, analyser->cold_misses, frames);
+}
+
+unsigned long get_tlb_misses (stack_distance_t* analyser, ullong_t entries)
+{
+	return count_misses(analyser->tlb_histogram, analyser->histogram_size, analyser->tlb_cold_misses, entries);
+}
+
+/*================================== DEBUGGING =================================*/
+/* One row per memory size: <size>,<memory misses>,<memory miss ratio>,<tlb misses>,<tlb miss ratio> */
+int write_miss_ratio_curve (const char* file_path, stack_distance_t* analyser)
+{
+	FILE* fp = fopen(file_path, "w");
+
+	if (fp == NULL)
+	{
+		printf("%s - Failed To Open Miss Ratio Curve File: %s\n", ERROR_PRINT_TAG, file_path);
+		return -1;
+	}
+
+	unsigned long references = analyser->references ? analyser->references : 1;
+	unsigned long memory_misses = analyser->references;
+	unsigned long tlb_misses = analyser->references;
+
+	fprintf(fp, "size,memory_misses,memory_miss_ratio,tlb_misses,tlb_miss_ratio\n");
+
+	/* Growing by one frame turns every reference at the old size's distance into a hit, past the page count nothing changes */
+	for (ullong_t size = 1; size <= analyser->last_reference->count; ++size)
+	{
+		if (size - 1 < analyser->histogram_size)
+		{
+			memory_misses 	-= analyser->memory_histogram[size - 1];
+			tlb_misses 		-= analyser->tlb_histogram[size - 1];
+		}
+
+		fprintf(fp, "%llu,%lu,%.6f,%lu,%.6f\n", size, memory_misses, (double) memory_misses / references,
+			tlb_misses, (double) tlb_misses / references);
+	}
+
+	fclose(fp);
+
+	printf("%s - Miss Ratio Curve Written To: %s\n", FILEIO_PRINT_TAG, file_path);
+
+	return 0;
+}
+
+void print_miss_ratio_curve (stack_distance_t* analyser)
+{
+	ullong_t curve_size = analyser->last_reference->count;
+	double references = analyser->references ? analyser->references : 1;
+
+	printf("%s", TABLE_MRC_HEADER);
+	printf("References:\t\t%'lu\n", analyser->references);
+	printf("Distinct Pages:\t\t%'llu\n", curve_size);
+	printf("TLB Flushes:\t\t%s\n", analyser->flush_on_switch ? "On Context Switch" : "None [ASID]");
+	printf("\n%-16s %16s %10s %16s %10s\n", "Frames/Entries", "Memory Misses", "Miss %", "TLB Misses", "Miss %");
+
+	/* Powers of 2 up to the page count, the file has every size */
+	for (ullong_t size = 1; curve_size > 0; size <<= 1)
+	{
+		if (size > curve_size)
+			size = curve_size;
+
+		unsigned long memory_misses = get_memory_misses(analyser, size);
+		unsigned long tlb_misses = get_tlb_misses(analyser, size);
+
+		printf("%'-16llu %'16lu %9.2f%% %'16lu %9.2f%%\n", size, memory_misses, 100.0 * memory_misses / references,
+			tlb_misses, 100.0 * tlb_misses / references);
+
+		if (size == curve_size)
+			break;
+	}
+
+	print_header_end('=', strlen(TABLE_MRC_HEADER));
+}
@@ -0,0 +1,50 @@
+#ifndef STACKDISTANCEH
+#define STACKDISTANCEH
+
+#include "utils.h"
+#include "page_map.h"
+
+/*
+    Mattson LRU stack distances of the page reference stream. Every page
+    keeps the time of its last reference & a Fenwick tree over those times
+    counts the pages referenced since, so a reference costs O(log n) rather
+    than a walk down the LRU stack. A memory of C frames [or a TLB of C
+    entries] hits exactly the references with a distance below C, so one
+    pass gives the miss ratio of every size.
+*/
+typedef struct stack_distance
+{
+    page_map_t*     last_reference;     /* [pid][vpn] -> Time slot of its latest reference */
+    ullong_t*       slot_keys;          /* Time slot -> Page referenced then, STACK_SLOT_EMPTY once referenced again */
+    uint_t*         tree;               /* Fenwick tree over occupied time slots */
+    ullong_t        capacity;           /* Time slots before they're compacted */
+    ullong_t        now;                /* Next time slot */
+
+    int             flush_on_switch;    /* TLB without ASIDs: Nothing survives a context switch */
+    int             current_pid;
+    ullong_t        flushed_at;         /* TLB: References before this slot were flushed */
+
+    unsigned long*  memory_histogram;   /* Distance -> References */
+    unsigned long*  tlb_histogram;
+    ullong_t        histogram_size;
+
+    unsigned long   references;
+    unsigned long   cold_misses;        /* First reference to a page */
+    unsigned long   tlb_cold_misses;    /* First reference or first since a flush */
+} stack_distance_t;
+
+// Initialization
+stack_distance_t* create_stack_distance (int flush_on_switch);
+void free_stack_distance (stack_distance_t* analyser);
+
+// Operational
+void stack_distance_reference (stack_distance_t* analyser, int pid, ullong_t virtual_page_number);
+void stack_distance_context_switch (stack_distance_t* analyser, int pid);
+unsigned long get_memory_misses (stack_distance_t* analyser, ullong_t frames);
+unsigned long get_tlb_misses (stack_distance_t* analyser, ullong_t entries);
+
+// Debugging
+int write_miss_ratio_curve (const char* file_path, stack_distance_t* analyser);
+void print_miss_ratio_curve (stack_distance_t* analyser);
+
+#endif
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_map.h"
+#include "page_table.h"
+#include "process.h"
+#include "swap_device.h"
+#include "events.h"
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+/*=============================== INITIALIZATION ===============================*/
+void init_swap_device_config (swap_device_config_t* config)
+{
+	config->latency_ns 		= SWAP_LATENCY_NS;
+	config->bandwidth 		= SWAP_BANDWIDTH;
+	config->queue_depth 	= SWAP_QUEUE_DEPTH;
+	config->readahead 		= SWAP_READAHEAD;
+	config->batch 			= SWAP_WRITEBACK_BATCH;
+	config->access_ns 		= SWAP_ACCESS_NS;
+	config->file_path 		= NULL;
+}
+
+/* latency=<us>,bandwidth=<bytes/s>,depth=<requests>,readahead=<pages>,batch=<pages>,access=<ns>,file=<path> */
+int parse_swap_device_config (const char* spec, swap_device_config_t* config)
+{
+	char* buffer = strdup(spec);
+
+	for (char* option = strtok(buffer, ","); option; option = strtok(NULL, ","))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - Swap Device Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "latency") == 0)
+			config->latency_ns = strtoull(value, NULL, 0) * 1000;
+		else if (strcmp(option, "bandwidth") == 0)
+			config->bandwidth = parse_size(value);
+		else if (strcmp(option, "depth") == 0)
+			config->queue_depth = atoi(value);
+		else if (strcmp(option, "readahead") == 0)
+			config->readahead = atoi(value);
+		else if (strcmp(option, "batch") == 0)
+			config->batch = atoi(value);
+		else if (strcmp(option, "access") == 0)
+			config->access_ns = strtoull(value, NULL, 0);
+		else if (strcmp(option, "file") == 0)
+			config->file_path = strdup(value);
+		else
+		{
+			printf("%s - Unknown Swap Device Option: %s\n", ERROR_PRINT_TAG, option);
+			free(buffer);
+			return -1;
+		}
+	}
+
+	free(buffer);
+
+	if (config->bandwidth == 0 || config->queue_depth <= 0 || config->readahead < 0 || config->batch <= 0)
+	{
+		printf("%s - Swap Device Needs Bandwidth, A Queue Depth & A Write-Back Batch...\n", ERROR_PRINT_TAG);
+		return -1;
+	}
+
+	return 0;
+}
+
+swap_device_t* create_swap_device (swap_device_config_t* config)
+{
+	printf("%s - Initializing Swap Device...\n", INIT_PRINT_TAG);
+
+	swap_device_t* device = calloc(1, sizeof(swap_device_t));
+	device->config 			= *config;
+	device->busy_until 		= calloc(config->queue_depth, sizeof(ullong_t));
+	device->pending_writes 	= create_page_map(0);
+	device->prefetched 		= create_page_map(0);
+	device->last_fault 		= calloc(MAX_PROCESSES, sizeof(ullong_t));
+	device->stride 			= calloc(MAX_PROCESSES, sizeof(long long));
+
+	return device;
+}
+
+void free_swap_device (swap_device_t* device)
+{
+	if (!device)
+		return;
+
+	free(device->busy_until);
+	free_page_map(device->pending_writes);
+	free_page_map(device->prefetched);
+	free(device->last_fault);
+	free(device->stride);
+	free(device->config.file_path);
+	free(device);
+}
+
+/*
+	Disk image backed by a real file. Pages the pager writes go to the
+	host's page cache & reach the file through the kernel's own write-back,
+	the image is released with free_simulated_memory().
+*/
+char* map_swap_file (const char* file_path, ullong_t size)
+{
+#ifdef __linux__
+	int fd = open(file_path, O_RDWR | O_CREAT, 0644);
+
+	/* Start from an empty device, stale slots from an earlier run mean nothing */
+	if (fd < 0 || ftruncate(fd, 0) < 0 || ftruncate(fd, size) < 0)
+	{
+		printf("%s - Failed To Create Swap File: %s\n", ERROR_PRINT_TAG, file_path);
+
+		if (fd >= 0)
+			close(fd);
+
+		return NULL;
+	}
+
+	char* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (memory == MAP_FAILED)
+	{
+		printf("%s - Failed To Map Swap File: %s\n", ERROR_PRINT_TAG, file_path);
+		return NULL;
+	}
+
+	return memory;
+#else
+	printf("%s - Swap Files Need Linux...\n", ERROR_PRINT_TAG);
+	return NULL;
+#endif
+}
+
+/*================================= OPERATIONAL ================================*/
+/* Queue a request on the channel that frees up first, returns when it completes */
+static ullong_t submit_request (swap_device_t* device, ullong_t bytes)
+{
+	int channel = 0;
+
+	for (int i = 1; i < device->config.queue_depth; ++i)
+	{
+		if (device->busy_until[i] < device->busy_until[channel])
+			channel = i;
+	}
+
+	ullong_t start = (device->busy_until[channel] > device->now) ? device->busy_until[channel] : device->now;
+	ullong_t service = device->config.latency_ns + (bytes * 1000000000ULL) / device->config.bandwidth;
+
+	device->busy_until[channel] = start + service;
+	device->io_ns += service;
+
+	return device->busy_until[channel];
+}
+
+static void stall_until (swap_device_t* device, ullong_t time)
+{
+	if (time <= device->now)
+		return;
+
+	device->stall_ns += time - device->now;
+	device->now = time;
+}
+
+/* Two faults the same distance apart make a stream, the next pages along it are read ahead */
+static void read_ahead (swap_device_t* device, process_t* process, ullong_t virtual_page_number)
+{
+	int pid = process->pid % MAX_PROCESSES;
+	long long delta = (long long) (virtual_page_number - device->last_fault[pid]);
+	int is_stream = (delta != 0 && delta == device->stride[pid]);
+
+	device->stride[pid] = delta;
+	device->last_fault[pid] = virtual_page_number;
+
+	if (!is_stream)
+		return;
+
+	for (int i = 1; i <= device->config.readahead; ++i)
+	{
+		long long page = (long long) virtual_page_number + delta * i;
+		ullong_t frame_number;
+		uchar_t control_bits;
+
+		if (page < 0 || (ullong_t) page >= geometry.virtual_page_count)
+			break;
+
+		long long slot = page_map_get(process->swap_slots, page, -1);
+
+		if (slot < 0 || page_map_get(device->pending_writes, slot, 0) || page_map_get(device->prefetched, slot, -1) >= 0)
+			continue;
+
+		/* Resident pages keep their slot as a clean copy, there is nothing to read */
+		page_table_get(process->page_table, page, &frame_number, &control_bits);
+
+		if ((control_bits & C_PRESENT) != 0)
+			continue;
+
+		page_map_put(device->prefetched, slot, submit_request(device, geometry.page_size));
+		device->prefetches++;
+
+		if (events)
+			events_record(EVENT_PREFETCH, process->pid, page, slot, 0x00, 0);
+	}
+}
+
+/* Major fault: The replay waits until the page is in */
+void swap_device_read (swap_device_t* device, process_t* process, ullong_t virtual_page_number, ullong_t slot)
+{
+	long long ready = page_map_get(device->prefetched, slot, -1);
+
+	if (page_map_get(device->pending_writes, slot, 0))
+	{
+		/* Never left memory, the write-back queue still holds it */
+		device->queue_hits++;
+	}
+	else if (ready >= 0)
+	{
+		page_map_remove(device->prefetched, slot);
+		device->prefetch_hits++;
+		device->prefetch_late += ((ullong_t) ready > device->now);
+		stall_until(device, ready);
+	}
+	else
+	{
+		device->reads++;
+		stall_until(device, submit_request(device, geometry.page_size));
+	}
+
+	if (device->config.readahead > 0)
+		read_ahead(device, process, virtual_page_number);
+}
+
+static void flush_writes (swap_device_t* device)
+{
+	if (device->queued == 0)
+		return;
+
+	submit_request(device, device->queued * geometry.page_size);
+
+	device->writes += device->queued;
+	device->flushes++;
+	device->queued = 0;
+
+	free_page_map(device->pending_writes);
+	device->pending_writes = create_page_map(0);
+}
+
+/* Dirty page evicted: Queued, the replay only notices the flush through busier channels */
+void swap_device_write (swap_device_t* device, ullong_t slot)
+{
+	/* A read ahead of the old contents is useless now */
+	page_map_remove(device->prefetched, slot);
+
+	if (page_map_get(device->pending_writes, slot, 0))
+		return;
+
+	page_map_put(device->pending_writes, slot, 1);
+	device->queued++;
+
+	if (device->queued >= device->config.batch)
+		flush_writes(device);
+}
+
+/* Flush what's left once the replay is over */
+void swap_device_drain (swap_device_t* device)
+{
+	flush_writes(device);
+}
+
+/*================================== DEBUGGING =================================*/
+void print_swap_device_stats (swap_device_t* device)
+{
+	unsigned long faults = device->reads + device->queue_hits + device->prefetch_hits;
+	double prefetches = device->prefetches ? (double) device->prefetches : 1.0;
+	double now = device->now ? (double) device->now : 1.0;
+	ullong_t overlapped = (device->io_ns > device->stall_ns) ? device->io_ns - device->stall_ns : 0;
+
+	printf("%s", TABLE_SWAP_HEADER);
+	printf("Swap File:\t\t%s\n", device->config.file_path ? device->config.file_path : "None [Anonymous Memory]");
+	printf("Latency:\t\t%'llu (ns)\n", device->config.latency_ns);
+	printf("Bandwidth:\t\t%'llu (bytes/s)\n", device->config.bandwidth);
+	printf("Queue Depth:\t\t%d\n", device->config.queue_depth);
+	printf("Demand Reads:\t\t%'lu (pages)\n", device->reads);
+	printf("Write Backs:\t\t%'lu (pages in %'lu batches)\n", device->writes, device->flushes);
+	printf("Write Queue Hits:\t%'lu\n", device->queue_hits);
+	printf("Readahead:\t\t%'lu (pages, window %d)\n", device->prefetches, device->config.readahead);
+	printf("Readahead Hits:\t\t%'lu (%.2f%%, %'lu late)\n", device->prefetch_hits, 100.0 * device->prefetch_hits / prefetches, device->prefetch_late);
+	printf("Simulated Time:\t\t%.3f (ms)\n", device->now / 1e6);
+	printf("Fault Stalls:\t\t%.3f (ms, %.2f%% of the run)\n", device->stall_ns / 1e6, 100.0 * device->stall_ns / now);
+	printf("Avg. Stall/Fault:\t%.1f (us)\n", faults ? device->stall_ns / 1e3 / faults : 0.0);
+	printf("Overlapped I/O:\t\t%.3f (ms)\n", overlapped / 1e6);
+	print_header_end('=', strlen(TABLE_SWAP_HEADER));
+}
@@ -0,0 +1,67 @@
+#ifndef SWAPDEVICEH
+#define SWAPDEVICEH
+
+#include "utils.h"
+#include "page_map.h"
+#include "process.h"
+
+typedef struct swap_device_config
+{
+    ullong_t        latency_ns;         /* Per request, before the transfer starts */
+    ullong_t        bandwidth;          /* Bytes per second */
+    int             queue_depth;        /* Requests in service at once */
+    int             readahead;          /* Pages prefetched once a sequential or strided fault stream is seen [0 => Off] */
+    int             batch;              /* Dirty pages written back per flush */
+    ullong_t        access_ns;          /* Modeled CPU time between two accesses */
+    char*           file_path;          /* Swap file backing the disk image, NULL => Anonymous memory */
+} swap_device_config_t;
+
+/*
+    Backing store model in simulated time. Requests queue for one of
+    queue_depth channels & complete after the latency plus the transfer
+    time, while the replay keeps going: Only a fault waiting for its page
+    stalls it. Evicted dirty pages wait in a write-back queue until a
+    whole batch is flushed as one request, readahead issues reads for the
+    next pages of a stream before they fault. Data moves when the pager
+    asks for it, the model only decides how long that took.
+*/
+typedef struct swap_device
+{
+    swap_device_config_t config;
+    ullong_t*       busy_until;         /* Channel -> Time its last request completes */
+    ullong_t        now;                /* Simulated time of the replay [ns] */
+
+    page_map_t*     pending_writes;     /* Slot -> Queued for write-back, not yet flushed */
+    page_map_t*     prefetched;         /* Slot -> Completion time of its readahead */
+    int             queued;             /* Pages in the write-back queue */
+
+    ullong_t*       last_fault;         /* Pid -> Page of its last major fault */
+    long long*      stride;             /* Pid -> Distance between its last two major faults */
+
+    unsigned long   reads;              /* Pages read on demand */
+    unsigned long   writes;             /* Pages written back */
+    unsigned long   flushes;            /* Write-back batches */
+    unsigned long   queue_hits;         /* Faults served from the write-back queue */
+    unsigned long   prefetches;
+    unsigned long   prefetch_hits;      /* Faults on a page readahead already asked for */
+    unsigned long   prefetch_late;      /* Of those, the ones still waiting for the read */
+    ullong_t        stall_ns;           /* Replay waiting on a fault's read */
+    ullong_t        io_ns;              /* Service time of every request */
+} swap_device_t;
+
+// Initialization
+void init_swap_device_config (swap_device_config_t* config);
+int parse_swap_device_config (const char* spec, swap_device_config_t* config);
+swap_device_t* create_swap_device (swap_device_config_t* config);
+void free_swap_device (swap_device_t* device);
+char* map_swap_file (const char* file_path, ullong_t size);
+
+// Operational
+void swap_device_read (swap_device_t* device, process_t* process, ullong_t virtual_page_number, ullong_t slot);
+void swap_device_write (swap_device_t* device, ullong_t slot);
+void swap_device_drain (swap_device_t* device);
+
+// Debugging
+void print_swap_device_stats (swap_device_t* device);
+
+#endif
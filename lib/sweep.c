@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "workload.h"
+#include "page_table.h"
+#include "process.h"
+#include "scheduler.h"
+#include "checkpoint.h"
+#include "sweep.h"
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <pthread.h>
+#endif
+
+/*================================ INITIALIZATION ==============================*/
+/*
+	Overrides the configuration it's given, which starts out as the command
+	line settings: e [TLB entries], w [ways], p [TLB policy], a [ASID 0/1],
+	r [replacement], f [frame limit] & q [quantum], i.e. e=128,w=8,r=clock.
+*/
+int parse_sweep_config (const char* spec, sweep_config_t* config)
+{
+	char buffer[256];
+
+	strncpy(config->label, spec, sizeof(config->label) - 1);
+	config->label[sizeof(config->label) - 1] = '\0';
+
+	strncpy(buffer, spec, sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = '\0';
+
+	for (char* option = strtok(buffer, ","); option; option = strtok(NULL, ","))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - Sweep Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "e") == 0)
+			config->tlb.entry_count = atoi(value);
+		else if (strcmp(option, "w") == 0)
+			config->tlb.ways = atoi(value);
+		else if (strcmp(option, "p") == 0)
+			config->tlb.policy = parse_tlb_policy(value);
+		else if (strcmp(option, "a") == 0)
+			config->tlb.use_asid = atoi(value);
+		else if (strcmp(option, "r") == 0)
+			config->pager.policy = parse_replacement_policy(value);
+		else if (strcmp(option, "f") == 0)
+			config->pager.frame_limit = atoi(value);
+		else if (strcmp(option, "q") == 0)
+			config->quantum = atoi(value);
+		else
+		{
+			printf("%s - Unknown Sweep Option: %s\n", ERROR_PRINT_TAG, option);
+			return -1;
+		}
+
+		if (config->tlb.policy < 0 || config->pager.policy < 0)
+		{
+			printf("%s - Unknown Policy: %s\n", ERROR_PRINT_TAG, value);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int get_online_cpu_count ()
+{
+#ifdef __linux__
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (count > 0) ? (int) count : 1;
+#else
+	return 1;
+#endif
+}
+
+/*================================= OPERATIONAL ================================*/
+/* Builds the configuration's machine, replays every trace on it & keeps the totals */
+static void run_sweep_config (sweep_t* sweep, int index)
+{
+	sweep_config_t* config = &sweep->configs[index];
+	sweep_result_t* result = &sweep->results[index];
+	trace_t* traces[MAX_PROCESSES];
+
+	result->failed = 1;
+
+	/* Loaded traces are only ever read, a generated or binary stream's window moves as it's replayed */
+	for (int i = 0; i < sweep->trace_count; ++i)
+	{
+		traces[i] = sweep->traces[i]->workload ? create_workload_trace(&sweep->traces[i]->workload->config) : reopen_trace(sweep->traces[i]);
+
+		if (!traces[i])
+		{
+			for (int j = 0; j < i; ++j)
+			{
+				if (traces[j] != sweep->traces[j])
+					free_trace(traces[j]);
+			}
+
+			return;
+		}
+	}
+
+	char* physical_memory = allocate_simulated_memory(geometry.physical_memory_size);
+	char* disk_memory = allocate_simulated_memory(geometry.disk_memory_size);
+	tlb_config_t* tlb_config = (config->tlb.entry_count > 0) ? &config->tlb : NULL;
+	scheduler_t* scheduler = NULL;
+
+	if (physical_memory && disk_memory && sweep->checkpoint)
+	{
+		scheduler = restore_checkpoint(sweep->checkpoint, &config->pager, tlb_config, config->quantum,
+			traces, sweep->trace_count, physical_memory, disk_memory);
+	}
+	else if (physical_memory && disk_memory)
+	{
+		tlb_t* tlb = tlb_config ? create_tlb(tlb_config) : NULL;
+		pager_t* pager = (tlb || !tlb_config) ? create_pager(&config->pager, physical_memory, disk_memory, tlb) : NULL;
+
+		scheduler = create_scheduler(pager, tlb, config->quantum);
+
+		for (int pid = 0; pager && pid < sweep->process_count; ++pid)
+		{
+			process_t* process = create_process(pid, traces[pid % sweep->trace_count]);
+			process->page_table = create_page_table(sweep->page_table_type, pager, pid);
+
+			if (!process->page_table)
+			{
+				free_process(process);
+				break;
+			}
+
+			pager_prepare_optimal(pager, process);
+			scheduler_add_process(scheduler, process);
+		}
+	}
+
+	if (scheduler && scheduler->pager && scheduler->process_count > 0)
+	{
+		run_scheduler(scheduler);
+
+		result->failed 				= 0;
+		result->stats 				= scheduler->stats;
+		result->context_switches 	= scheduler->context_switches;
+		result->evictions 			= scheduler->pager->evictions;
+		result->writebacks 			= scheduler->pager->writebacks;
+		result->major_faults 		= scheduler->pager->major_faults;
+
+		if (scheduler->tlb)
+		{
+			result->tlb_lookups = scheduler->tlb->lookups;
+			result->tlb_hits 	= scheduler->tlb->hits;
+		}
+	}
+
+	if (scheduler)
+	{
+		pager_t* pager = scheduler->pager;
+		tlb_t* tlb = scheduler->tlb;
+
+		free_scheduler(scheduler);
+		free_pager(pager);
+		free_tlb(tlb);
+	}
+
+	for (int i = 0; i < sweep->trace_count; ++i)
+	{
+		if (traces[i] != sweep->traces[i])
+			free_trace(traces[i]);
+	}
+
+	free_simulated_memory(disk_memory, geometry.disk_memory_size);
+	free_simulated_memory(physical_memory, geometry.physical_memory_size);
+}
+
+/* Workers take the next configuration until none are left, so a slow one doesn't hold up the rest */
+static void* sweep_worker (void* context)
+{
+	sweep_t* sweep = context;
+	int index;
+
+	while ((index = __atomic_fetch_add(&sweep->next, 1, __ATOMIC_RELAXED)) < sweep->count)
+		run_sweep_config(sweep, index);
+
+	return NULL;
+}
+
+void run_sweep (sweep_t* sweep)
+{
+	int threads = (sweep->threads > 0) ? sweep->threads : get_online_cpu_count();
+
+	if (threads > sweep->count)
+		threads = sweep->count;
+
+	sweep->threads = threads;
+	sweep->next = 0;
+
+	printf("%s - Sweeping %d Configuration(s) On %d Thread(s)...\n", TRACE_PRINT_TAG, sweep->count, threads);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+#ifdef __linux__
+	pthread_t* workers = malloc(threads * sizeof(pthread_t));
+	int started = 0;
+
+	/* The calling thread works too, any worker that fails to start just leaves it more to do */
+	while (started < threads - 1 && pthread_create(&workers[started], NULL, sweep_worker, sweep) == 0)
+		started++;
+
+	sweep_worker(sweep);
+
+	for (int i = 0; i < started; ++i)
+		pthread_join(workers[i], NULL);
+
+	free(workers);
+#else
+	sweep_worker(sweep);
+#endif
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sweep->elapsed_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_sweep_report (sweep_t* sweep)
+{
+	unsigned long accesses = 0;
+
+	printf("%s", TABLE_SWEEP_HEADER);
+	printf("%-24s %14s %14s %9s %12s %12s %12s %10s\n", "Configuration", "Accesses", "Faults", "TLB Hit%", "Major", "Evictions", "Write Backs", "Seconds");
+
+	for (int i = 0; i < sweep->count; ++i)
+	{
+		sweep_result_t* result = &sweep->results[i];
+
+		if (result->failed)
+		{
+			printf("%-24s %14s\n", sweep->configs[i].label, "Failed");
+			continue;
+		}
+
+		double hit_percent = (result->tlb_lookups > 0) ? 100.0 * result->tlb_hits / result->tlb_lookups : 0;
+
+		printf("%-24s %'14lu %'14lu %8.2f%% %'12lu %'12lu %'12lu %10.3f\n", sweep->configs[i].label, result->stats.accesses,
+			result->stats.faults, hit_percent, result->major_faults, result->evictions, result->writebacks, result->stats.elapsed_seconds);
+
+		accesses += result->stats.accesses;
+	}
+
+	printf("\nThreads:\t\t%d\n", sweep->threads);
+	printf("Elapsed:\t\t%.6f (seconds)\n", sweep->elapsed_seconds);
+
+	if (sweep->elapsed_seconds > 0)
+		printf("Throughput:\t\t%'.0f (translations/sec)\n", accesses / sweep->elapsed_seconds);
+
+	print_header_end('=', strlen(TABLE_SWEEP_HEADER));
+}
@@ -0,0 +1,63 @@
+#ifndef SWEEPH
+#define SWEEPH
+
+#include "utils.h"
+#include "trace.h"
+#include "tlb.h"
+#include "paging.h"
+#include "snapshot.h"
+
+/* One machine configuration of a sweep [Everything else is shared by the whole sweep] */
+typedef struct sweep_config
+{
+    char            label[64];          /* Spec it was parsed from */
+    tlb_config_t    tlb;                /* entry_count 0 => No TLB */
+    pager_config_t  pager;
+    int             quantum;
+} sweep_config_t;
+
+typedef struct sweep_result
+{
+    int             failed;
+    trace_stats_t   stats;
+    unsigned long   context_switches;
+    unsigned long   tlb_lookups;
+    unsigned long   tlb_hits;
+    unsigned long   evictions;
+    unsigned long   writebacks;
+    unsigned long   major_faults;
+} sweep_result_t;
+
+/*
+    Every configuration replays the same traces on its own machine
+    [memory, pager, TLB, processes], workers only share what's read-only:
+    the geometry, loaded traces & an optional checkpoint to start from.
+*/
+typedef struct sweep
+{
+    sweep_config_t* configs;
+    sweep_result_t* results;
+    int             count;
+    int             threads;
+
+    trace_t**       traces;
+    int             trace_count;
+    int             process_count;
+    int             page_table_type;
+    snapshot_t*     checkpoint;         /* NULL => Every machine starts empty */
+
+    int             next;               /* Next configuration to hand out */
+    double          elapsed_seconds;
+} sweep_t;
+
+// Initialization
+int parse_sweep_config (const char* spec, sweep_config_t* config);
+int get_online_cpu_count ();
+
+// Operational
+void run_sweep (sweep_t* sweep);
+
+// Debugging
+void print_sweep_report (sweep_t* sweep);
+
+#endif
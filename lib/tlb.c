@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "tlb.h"
+
+#define TLB_INVALID_TAG		0xFFFFFFFFFFFFFFFFULL
+#define TLB_HUGE_TAG		(1ULL << 63)
+
+static const char* TLB_POLICY_NAMES[] = { "LRU", "FIFO", "RANDOM", "CLOCK" };
+
+/*=============================== INITIALIZATION ===============================*/
+void init_tlb_config (tlb_config_t* config)
+{
+	config->entry_count 	= TLB_DEFAULT_ENTRIES;
+	config->ways 			= TLB_DEFAULT_WAYS;
+	config->policy 			= TLB_LRU;
+	config->use_asid 		= 0;
+	config->hit_latency 	= TLB_HIT_LATENCY;
+	config->memory_latency 	= MEMORY_LATENCY;
+	config->huge_order 		= 0;
+}
+
+tlb_t* create_tlb (tlb_config_t* config)
+{
+	printf("%s - Initializing TLB...\n", INIT_PRINT_TAG);
+
+	int ways = (config->ways <= 0 || config->ways > config->entry_count) ? config->entry_count : config->ways;
+
+	if (config->entry_count <= 0 || config->entry_count % ways != 0)
+	{
+		printf("%s - TLB Entry Count Must Be A Multiple Of Ways...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	int set_count = config->entry_count / ways;
+
+	/* Set index is taken from the low VPN bits */
+	if ((set_count & (set_count - 1)) != 0)
+	{
+		printf("%s - TLB Set Count Must Be A Power Of 2...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	tlb_t* tlb = calloc(1, sizeof(tlb_t));
+	tlb->config 		= *config;
+	tlb->config.ways 	= ways;
+	tlb->set_count 		= set_count;
+	tlb->set_mask 		= set_count - 1;
+	tlb->tags 			= malloc(config->entry_count * sizeof(ullong_t));
+	tlb->frames 		= calloc(config->entry_count, sizeof(ullong_t));
+	tlb->control_bits 	= calloc(config->entry_count, sizeof(uchar_t));
+	tlb->stamps 		= calloc(config->entry_count, sizeof(ullong_t));
+	tlb->referenced 	= calloc(config->entry_count, sizeof(uchar_t));
+	tlb->clock_hands 	= calloc(set_count, sizeof(int));
+	tlb->random_state 	= 0x9E3779B9;
+
+	for (int i = 0; i < config->entry_count; ++i)
+		tlb->tags[i] = TLB_INVALID_TAG;
+
+	/* Same TLB fed the same accesses but only ever holding base pages */
+	if (config->huge_order > 0)
+	{
+		tlb_config_t base_config = tlb->config;
+		base_config.huge_order = 0;
+
+		tlb->base_only = create_tlb(&base_config);
+	}
+
+	return tlb;
+}
+
+void free_tlb (tlb_t* tlb)
+{
+	if (!tlb)
+		return;
+
+	free(tlb->tags);
+	free(tlb->frames);
+	free(tlb->control_bits);
+	free(tlb->stamps);
+	free(tlb->referenced);
+	free(tlb->clock_hands);
+	free_tlb(tlb->base_only);
+	free(tlb);
+}
+
+int parse_tlb_policy (const char* name)
+{
+	for (int i = 0; i < (int) (sizeof(TLB_POLICY_NAMES) / sizeof(TLB_POLICY_NAMES[0])); ++i)
+	{
+		if (strcasecmp(name, TLB_POLICY_NAMES[i]) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/*================================= OPERATIONAL ================================*/
+static inline ullong_t make_tag (uint_t asid, ullong_t virtual_page_number)
+{
+	return ((ullong_t) asid << MAX_VPN_BITS) | virtual_page_number;
+}
+
+/* Returns the matching way or -1, a hit updates the replacement state */
+static inline int probe_set (tlb_t* tlb, ullong_t tag, int base)
+{
+	ullong_t* tags = tlb->tags + base;
+
+	for (int way = 0; way < tlb->config.ways; ++way)
+	{
+		if (tags[way] == tag)
+		{
+			if (tlb->config.policy == TLB_LRU)
+				tlb->stamps[base + way] = tlb->tick;
+			else if (tlb->config.policy == TLB_CLOCK)
+				tlb->referenced[base + way] = 1;
+
+			return way;
+		}
+	}
+
+	return -1;
+}
+
+// Source: https://en.wikipedia.org/wiki/Xorshift
+static inline uint_t next_random (tlb_t* tlb)
+{
+	uint_t x = tlb->random_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	tlb->random_state = x;
+
+	return x;
+}
+
+/* A hit hands back the entry's cached control bits too, the caller may add C_DIRTY to them */
+int tlb_lookup (tlb_t* tlb, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t** control_bits)
+{
+	int ways 		= tlb->config.ways;
+	int base 		= (virtual_page_number & tlb->set_mask) * ways;
+	int way 		= -1;
+
+	tlb->lookups++;
+	tlb->tick++;
+	tlb->cycles += tlb->config.hit_latency;
+
+	way = probe_set(tlb, make_tag(tlb->current_asid, virtual_page_number), base);
+
+	if (way >= 0)
+	{
+		*frame_number = tlb->frames[base + way];
+		*control_bits = &tlb->control_bits[base + way];
+	}
+	else if (tlb->config.huge_order > 0)
+	{
+		/* Huge entries are indexed by their own page number & hold the first frame of the run */
+		ullong_t huge_page_number = virtual_page_number >> tlb->config.huge_order;
+
+		base = (huge_page_number & tlb->set_mask) * ways;
+		way = probe_set(tlb, TLB_HUGE_TAG | make_tag(tlb->current_asid, huge_page_number), base);
+
+		if (way >= 0)
+		{
+			*frame_number = tlb->frames[base + way] + (virtual_page_number & ((1ULL << tlb->config.huge_order) - 1));
+			*control_bits = &tlb->control_bits[base + way];
+			tlb->huge_hits++;
+		}
+	}
+
+	if (tlb->base_only)
+	{
+		ullong_t base_frame;
+		uchar_t* base_bits;
+
+		tlb->base_only_missed = !tlb_lookup(tlb->base_only, virtual_page_number, &base_frame, &base_bits);
+
+		/* The shadow can only learn the frame from this TLB's hit or the walk that follows a miss */
+		if (tlb->base_only_missed && way >= 0)
+		{
+			tlb_insert(tlb->base_only, virtual_page_number, *frame_number, **control_bits);
+			tlb->base_only_missed = 0;
+		}
+	}
+
+	if (way < 0)
+	{
+		tlb->misses++;
+		return 0;
+	}
+
+	tlb->hits++;
+
+	return 1;
+}
+
+static int select_victim_way (tlb_t* tlb, int set, int base)
+{
+	int ways = tlb->config.ways;
+
+	/* Prefer an empty way before evicting */
+	for (int way = 0; way < ways; ++way)
+	{
+		if (tlb->tags[base + way] == TLB_INVALID_TAG)
+			return way;
+	}
+
+	tlb->evictions++;
+
+	switch (tlb->config.policy)
+	{
+		case TLB_RANDOM:
+			return next_random(tlb) % ways;
+
+		case TLB_CLOCK:
+		{
+			/* Second chance: Clear reference bits until an unreferenced way is found */
+			int hand = tlb->clock_hands[set];
+
+			while (tlb->referenced[base + hand])
+			{
+				tlb->referenced[base + hand] = 0;
+				hand = (hand + 1) % ways;
+			}
+
+			tlb->clock_hands[set] = (hand + 1) % ways;
+
+			return hand;
+		}
+
+		default:
+		{
+			/* LRU & FIFO both evict the oldest stamp, they differ in when it's updated */
+			int victim = 0;
+
+			for (int way = 1; way < ways; ++way)
+			{
+				if (tlb->stamps[base + way] < tlb->stamps[base + victim])
+					victim = way;
+			}
+
+			return victim;
+		}
+	}
+}
+
+static void insert_entry (tlb_t* tlb, ullong_t tag, ullong_t index, ullong_t frame_number, uchar_t control_bits)
+{
+	int set 	= index & tlb->set_mask;
+	int base 	= set * tlb->config.ways;
+	int way 	= select_victim_way(tlb, set, base);
+
+	tlb->tags[base + way] 		= tag;
+	tlb->frames[base + way] 	= frame_number;
+	tlb->control_bits[base + way] = control_bits;
+	tlb->stamps[base + way] 	= tlb->tick;
+	tlb->referenced[base + way] = 1;
+}
+
+static void insert_base_only (tlb_t* tlb, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	if (tlb->base_only && tlb->base_only_missed)
+	{
+		tlb_insert(tlb->base_only, virtual_page_number, frame_number, control_bits);
+		tlb->base_only_missed = 0;
+	}
+}
+
+void tlb_insert (tlb_t* tlb, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	insert_entry(tlb, make_tag(tlb->current_asid, virtual_page_number), virtual_page_number, frame_number, control_bits);
+	insert_base_only(tlb, virtual_page_number, frame_number, control_bits);
+}
+
+/* Cache the whole huge page containing virtual_page_number [frame_number is that page's frame] */
+void tlb_insert_huge (tlb_t* tlb, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	/* Every base page of the run keeps its own C_DIRTY, so one entry can't vouch for them all */
+	control_bits &= ~C_DIRTY;
+
+	if (tlb->config.huge_order == 0)
+	{
+		tlb_insert(tlb, virtual_page_number, frame_number, control_bits);
+		return;
+	}
+
+	ullong_t huge_page_number = virtual_page_number >> tlb->config.huge_order;
+	ullong_t first_frame = frame_number - (virtual_page_number & ((1ULL << tlb->config.huge_order) - 1));
+
+	insert_entry(tlb, TLB_HUGE_TAG | make_tag(tlb->current_asid, huge_page_number), huge_page_number, first_frame, control_bits);
+	insert_base_only(tlb, virtual_page_number, frame_number, control_bits);
+}
+
+void tlb_charge_walk (tlb_t* tlb, int memory_references)
+{
+	tlb->cycles += memory_references * tlb->config.memory_latency;
+}
+
+static void invalidate_entry (tlb_t* tlb, ullong_t tag, ullong_t index)
+{
+	int base = (index & tlb->set_mask) * tlb->config.ways;
+
+	for (int way = 0; way < tlb->config.ways; ++way)
+	{
+		if (tlb->tags[base + way] == tag)
+			tlb->tags[base + way] = TLB_INVALID_TAG;
+	}
+}
+
+/* Drops the page's own entry & any huge entry covering it */
+void tlb_invalidate (tlb_t* tlb, uint_t asid, ullong_t virtual_page_number)
+{
+	invalidate_entry(tlb, make_tag(asid, virtual_page_number), virtual_page_number);
+
+	if (tlb->config.huge_order > 0)
+	{
+		ullong_t huge_page_number = virtual_page_number >> tlb->config.huge_order;
+
+		invalidate_entry(tlb, TLB_HUGE_TAG | make_tag(asid, huge_page_number), huge_page_number);
+	}
+
+	if (tlb->base_only)
+		tlb_invalidate(tlb->base_only, asid, virtual_page_number);
+}
+
+void tlb_flush (tlb_t* tlb)
+{
+	for (int i = 0; i < tlb->config.entry_count; ++i)
+		tlb->tags[i] = TLB_INVALID_TAG;
+
+	tlb->flushes++;
+
+	if (tlb->base_only)
+		tlb_flush(tlb->base_only);
+}
+
+void tlb_context_switch (tlb_t* tlb, uint_t asid)
+{
+	if (asid == tlb->current_asid)
+		return;
+
+	/* Without ASID tags every entry belongs to the previous address space */
+	if (!tlb->config.use_asid)
+		tlb_flush(tlb);
+
+	tlb->current_asid = asid;
+
+	if (tlb->base_only)
+		tlb->base_only->current_asid = asid;
+}
+
+/*================================== DEBUGGING =================================*/
+/* Bytes of address space the valid entries currently translate */
+ullong_t get_tlb_reach (tlb_t* tlb)
+{
+	ullong_t reach = 0;
+
+	for (int i = 0; i < tlb->config.entry_count; ++i)
+	{
+		if (tlb->tags[i] == TLB_INVALID_TAG)
+			continue;
+
+		reach += (tlb->tags[i] & TLB_HUGE_TAG) ? (geometry.page_size << tlb->config.huge_order) : geometry.page_size;
+	}
+
+	return reach;
+}
+
+void print_tlb_stats (tlb_t* tlb)
+{
+	double lookups = tlb->lookups > 0 ? (double) tlb->lookups : 1.0;
+
+	printf("%s", TABLE_TLB_HEADER);
+	printf("Entries:\t\t%d (%d sets x %d ways)\n", tlb->config.entry_count, tlb->set_count, tlb->config.ways);
+	printf("Policy:\t\t\t%s\n", TLB_POLICY_NAMES[tlb->config.policy]);
+	printf("Context Switch:\t\t%s\n", tlb->config.use_asid ? "ASID Tagged" : "Flush");
+	printf("Lookups:\t\t%'lu\n", tlb->lookups);
+	printf("Hits:\t\t\t%'lu\n", tlb->hits);
+	printf("Misses:\t\t\t%'lu\n", tlb->misses);
+	printf("Evictions:\t\t%'lu\n", tlb->evictions);
+	printf("Flushes:\t\t%'lu\n", tlb->flushes);
+	printf("Hit Rate:\t\t%.4f\n", tlb->hits / lookups);
+	printf("Miss Rate:\t\t%.4f\n", tlb->misses / lookups);
+	printf("Avg. Latency:\t\t%.2f (cycles)\n", tlb->cycles / lookups);
+	printf("Reach:\t\t\t%'llu (bytes)\n", get_tlb_reach(tlb));
+
+	if (tlb->base_only)
+	{
+		double base_lookups = tlb->base_only->lookups > 0 ? (double) tlb->base_only->lookups : 1.0;
+
+		printf("Huge Hits:\t\t%'lu\n", tlb->huge_hits);
+		printf("Base-Only Miss Rate:\t%.4f\n", tlb->base_only->misses / base_lookups);
+		printf("Base-Only Reach:\t%'llu (bytes)\n", get_tlb_reach(tlb->base_only));
+	}
+
+	print_header_end('=', strlen(TABLE_TLB_HEADER));
+}
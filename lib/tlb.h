@@ -0,0 +1,74 @@
+#ifndef TLBH
+#define TLBH
+
+#include "utils.h"
+
+/* Replacement policies */
+#define TLB_LRU             0
+#define TLB_FIFO            1
+#define TLB_RANDOM          2
+#define TLB_CLOCK           3
+
+typedef struct tlb_config
+{
+    int         entry_count;        /* Total entries */
+    int         ways;               /* Entries per set [0 or entry_count => Fully-associative] */
+    int         policy;             /* TLB_LRU, TLB_FIFO, TLB_RANDOM, TLB_CLOCK */
+    int         use_asid;           /* 1 => Tag entries with ASID, 0 => Flush on context switch */
+    int         hit_latency;        /* Modeled cycles for a TLB lookup */
+    int         memory_latency;     /* Modeled cycles per page table memory reference on a miss */
+    int         huge_order;         /* Base pages per huge entry = 2^huge_order [0 => Base pages only] */
+} tlb_config_t;
+
+/*
+    Entries are kept as parallel arrays indexed [set * ways + way] so a
+    lookup is a linear scan over a handful of contiguous tags.
+*/
+typedef struct tlb tlb_t;
+
+struct tlb
+{
+    tlb_config_t    config;
+    int             set_count;
+    ullong_t        set_mask;
+    ullong_t*       tags;           /* [Huge bit][asid << MAX_VPN_BITS][vpn], TLB_INVALID_TAG if empty */
+    ullong_t*       frames;
+    uchar_t*        control_bits;   /* Page table entry bits cached with the translation [C_COW writes trap, C_DIRTY skips the table] */
+    ullong_t*       stamps;         /* LRU: last use, FIFO: insertion tick */
+    uchar_t*        referenced;     /* CLOCK: reference bit */
+    int*            clock_hands;    /* CLOCK: per set hand */
+    ullong_t        tick;
+    uint_t          random_state;
+    uint_t          current_asid;
+    tlb_t*          base_only;      /* Shadow TLB without huge entries for comparison */
+    int             base_only_missed;
+
+    unsigned long   lookups;
+    unsigned long   hits;
+    unsigned long   huge_hits;
+    unsigned long   misses;
+    unsigned long   evictions;
+    unsigned long   flushes;
+    unsigned long   cycles;
+};
+
+// Initialization
+void init_tlb_config (tlb_config_t* config);
+tlb_t* create_tlb (tlb_config_t* config);
+void free_tlb (tlb_t* tlb);
+int parse_tlb_policy (const char* name);
+
+// Operational
+int tlb_lookup (tlb_t* tlb, ullong_t virtual_page_number, ullong_t* frame_number, uchar_t** control_bits);
+void tlb_insert (tlb_t* tlb, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits);
+void tlb_insert_huge (tlb_t* tlb, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits);
+void tlb_charge_walk (tlb_t* tlb, int memory_references);
+void tlb_invalidate (tlb_t* tlb, uint_t asid, ullong_t virtual_page_number);
+void tlb_flush (tlb_t* tlb);
+void tlb_context_switch (tlb_t* tlb, uint_t asid);
+
+// Debugging
+ullong_t get_tlb_reach (tlb_t* tlb);
+void print_tlb_stats (tlb_t* tlb);
+
+#endif
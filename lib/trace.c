@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "trace.h"
+#include "workload.h"
+#include "binary_trace.h"
+
+static int TRACE_INITIAL_CAPACITY = 4096;
+
+/*=================================== LOADING ==================================*/
+static int append_trace_entry (trace_t* trace, vaddr_t address, uchar_t is_write)
+{
+	/* Grow entries geometrically so loading stays linear in trace length */
+	if (trace->length == trace->capacity)
+	{
+		unsigned long new_capacity = trace->capacity * 2;
+		trace_entry_t* entries = realloc(trace->entries, new_capacity * sizeof(trace_entry_t));
+
+		if (!entries)
+			return -1;
+
+		trace->entries = entries;
+		trace->capacity = new_capacity;
+	}
+
+	trace->entries[trace->length].address = address;
+	trace->entries[trace->length].is_write = is_write;
+	trace->length++;
+
+	return 0;
+}
+
+/* Blocks are decoded as the replay reaches them, the file is never held in memory */
+static trace_t* load_binary_trace (const char* file_path)
+{
+	binary_trace_t* binary = open_binary_trace(file_path);
+
+	if (!binary)
+		return NULL;
+
+	binary_trace_header_t* header = &binary->header;
+
+	/* Checked once here instead of for every access */
+	if (geometry.va_bits < 64 && (header->max_address >> geometry.va_bits) != 0)
+	{
+		printf("%s - Trace Address 0x%llX Doesn't Fit %d Virtual Address Bits...\n", ERROR_PRINT_TAG, header->max_address, geometry.va_bits);
+		free_binary_trace(binary);
+		return NULL;
+	}
+
+	trace_t* trace = calloc(1, sizeof(trace_t));
+	trace->binary = binary;
+	trace->length = header->entry_count;
+	trace->capacity = header->block_entries;
+	trace->entries = malloc(trace->capacity * sizeof(trace_entry_t));
+
+	printf("%s - Streaming %'lu Accesses In %'llu Blocks...\n", TRACE_PRINT_TAG, trace->length, header->block_count);
+
+	return trace;
+}
+
+/*
+	Trace file format [One access per line]:
+		<hex address> [R|W]
+	Lines starting with '#' and blank lines are ignored. Missing flag => Read.
+	Addresses must fit the configured virtual address width. Files starting
+	with TRACE_MAGIC are binary traces [binary_trace.h] & are streamed.
+*/
+trace_t* load_trace_file (const char* file_path)
+{
+	printf("%s - Loading Trace: %s\n", TRACE_PRINT_TAG, file_path);
+
+	if (is_binary_trace_file(file_path))
+		return load_binary_trace(file_path);
+
+	FILE *fp = fopen(file_path, "rb");
+
+	if (fp == NULL)
+	{
+		printf("%s - Failed To Open Trace File...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	trace_t* trace = calloc(1, sizeof(trace_t));
+	trace->length = 0;
+	trace->capacity = TRACE_INITIAL_CAPACITY;
+	trace->entries = malloc(trace->capacity * sizeof(trace_entry_t));
+
+	char line[128];
+	unsigned long line_number = 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		line_number++;
+
+		char* cursor = line;
+		while (isspace((unsigned char) *cursor))
+			cursor++;
+
+		if (*cursor == '\0' || *cursor == '#')
+			continue;
+
+		char* end;
+		vaddr_t address = strtoull(cursor, &end, 16);
+
+		if (end == cursor || (geometry.va_bits < 64 && (address >> geometry.va_bits) != 0))
+		{
+			printf("%s - Invalid Trace Entry On Line %lu...\n", ERROR_PRINT_TAG, line_number);
+			continue;
+		}
+
+		while (isspace((unsigned char) *end))
+			end++;
+
+		uchar_t is_write = (*end == 'W' || *end == 'w') ? 1 : 0;
+
+		if (append_trace_entry(trace, address, is_write) != 0)
+		{
+			printf("%s - Out Of Memory Loading Trace...\n", ERROR_PRINT_TAG);
+			break;
+		}
+	}
+
+	/* Close stream */
+	fclose(fp);
+
+	printf("%s - Loaded %'lu Accesses...\n", TRACE_PRINT_TAG, trace->length);
+
+	return trace;
+}
+
+/* Accesses are generated as the replay reaches them, so the stream can be far larger than memory */
+trace_t* create_workload_trace (workload_config_t* config)
+{
+	workload_t* workload = create_workload(config);
+
+	if (!workload)
+		return NULL;
+
+	workload_config_t* settings = &workload->config;
+
+	printf("%s - Generating %s Workload: %'lu Accesses Over %'llu Pages, Seed %llu\n", TRACE_PRINT_TAG,
+		get_workload_name(settings->pattern), settings->length, settings->pages, settings->seed);
+
+	trace_t* trace = calloc(1, sizeof(trace_t));
+	trace->workload = workload;
+	trace->length = settings->length;
+	trace->capacity = (settings->length < (unsigned long) WORKLOAD_WINDOW) ? settings->length : (unsigned long) WORKLOAD_WINDOW;
+	trace->entries = malloc(trace->capacity * sizeof(trace_entry_t));
+
+	return trace;
+}
+
+/* A streamed trace has one read position, every process replaying the same file needs its own reader */
+trace_t* reopen_trace (trace_t* trace)
+{
+	return trace->binary ? load_trace_file(trace->binary->path) : trace;
+}
+
+void free_trace (trace_t* trace)
+{
+	if (!trace)
+		return;
+
+	free_workload(trace->workload);
+	free_binary_trace(trace->binary);
+	free(trace->entries);
+	free(trace);
+}
+
+/*================================= OPERATIONAL ================================*/
+/*
+	Entries from position on, count is trimmed to what's available. Loaded
+	traces are returned as they are, generated ones slide their window
+	forward [or regenerate from the seed when asked to go back] & binary
+	ones decode the block holding position.
+*/
+trace_entry_t* trace_window (trace_t* trace, unsigned long position, unsigned long* count)
+{
+	if (position >= trace->length)
+		*count = 0;
+	else if (*count > trace->length - position)
+		*count = trace->length - position;
+
+	if (!trace->workload && !trace->binary)
+		return &trace->entries[position];
+
+	if (*count == 0)
+		return trace->entries;
+
+	if (trace->binary && (position < trace->first || position >= trace->first + trace->buffered))
+	{
+		ullong_t block = position / trace->capacity;
+		unsigned long expected = (trace->length - block * trace->capacity < trace->capacity) ? trace->length - block * trace->capacity : trace->capacity;
+
+		trace->first = block * trace->capacity;
+		trace->buffered = binary_trace_read_block(trace->binary, block, trace->entries);
+
+		/* A damaged block ends the trace right there */
+		if (trace->buffered != expected)
+		{
+			trace->length = position;
+			trace->buffered = 0;
+			*count = 0;
+			return trace->entries;
+		}
+	}
+	else if (position < trace->first || position >= trace->first + trace->buffered)
+	{
+		workload_t* workload = trace->workload;
+		unsigned long remaining = trace->length - position;
+
+		if (position < workload->generated)
+			reset_workload(workload);
+
+		workload_skip(workload, position - workload->generated);
+
+		trace->first = position;
+		trace->buffered = (remaining < trace->capacity) ? remaining : trace->capacity;
+		workload_next(workload, trace->entries, trace->buffered);
+	}
+
+	if (*count > trace->first + trace->buffered - position)
+		*count = trace->first + trace->buffered - position;
+
+	return &trace->entries[position - trace->first];
+}
+
+/*================================== DEBUGGING =================================*/
+void print_trace_stats (trace_stats_t* stats)
+{
+	printf("%s", TABLE_TRACE_HEADER);
+	printf("Accesses:\t\t%'lu\n", stats->accesses);
+	printf("Reads:\t\t\t%'lu\n", stats->reads);
+	printf("Writes:\t\t\t%'lu\n", stats->writes);
+	printf("Hits:\t\t\t%'lu\n", stats->hits);
+	printf("Page Faults:\t\t%'lu\n", stats->faults);
+	printf("Disk Reads:\t\t%'lu\n", stats->disk_reads);
+	printf("Data Checksum:\t\t0x%08lX\n", stats->checksum);
+	printf("Elapsed:\t\t%.6f (seconds)\n", stats->elapsed_seconds);
+
+	if (stats->elapsed_seconds > 0)
+		printf("Throughput:\t\t%'.0f (translations/sec)\n", stats->accesses / stats->elapsed_seconds);
+
+	print_header_end('=', strlen(TABLE_TRACE_HEADER));
+}
@@ -0,0 +1,58 @@
+#ifndef TRACEH
+#define TRACEH
+
+#include "utils.h"
+
+struct workload;
+struct workload_config;
+struct binary_trace;
+
+/* Single trace record [Virtual address & Read/Write flag] */
+typedef struct trace_entry
+{
+    vaddr_t     address;
+    uchar_t     is_write;
+} trace_entry_t;
+
+/*
+    A loaded trace holds every entry, a generated or binary one only a
+    window of capacity entries starting at first that is refilled as it's
+    replayed [Binary ones a block at a time].
+*/
+typedef struct trace
+{
+    trace_entry_t*  entries;
+    unsigned long   length;
+    unsigned long   capacity;
+    struct workload* workload;      /* NULL => Loaded from a file */
+    struct binary_trace* binary;    /* NULL => Text file or generated */
+    unsigned long   first;          /* Generated & binary: Position of entries[0] */
+    unsigned long   buffered;       /* Generated & binary: Valid entries in the window */
+} trace_t;
+
+/* Aggregate results of a replay [Replaces per-access printf] */
+typedef struct trace_stats
+{
+    unsigned long   accesses;
+    unsigned long   reads;
+    unsigned long   writes;
+    unsigned long   hits;
+    unsigned long   faults;
+    unsigned long   disk_reads;
+    unsigned long   checksum;
+    double          elapsed_seconds;
+} trace_stats_t;
+
+// Loading
+trace_t* load_trace_file (const char* file_path);
+trace_t* create_workload_trace (struct workload_config* config);
+trace_t* reopen_trace (trace_t* trace);
+void free_trace (trace_t* trace);
+
+// Operational
+trace_entry_t* trace_window (trace_t* trace, unsigned long position, unsigned long* count);
+
+// Debugging
+void print_trace_stats (trace_stats_t* stats);
+
+#endif
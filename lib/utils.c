@@ -9,18 +9,24 @@
 #include <time.h>
 #include "constants.h"
 #include "utils.h"
+#include "random.h"
+#include "events.h"
 
 int page_table_page_counter 	= 0;
 int physical_frame_counter		= 0;
 int disk_frame_counter			= 0;
+rng_t payload_rng;
 
 /*=============================== INITIALIZATION ===============================*/
-void init_random_seed ()
+/* Seed 0 => Time of day, any other seed replays the same payload */
+void init_random_seed (ullong_t seed)
 {
 	printf("%s - Initializing Random Generator Seed...\n", INIT_PRINT_TAG);
-	srand(time(NULL));
-	time_t t;
-	srand((unsigned) time(&t));
+
+	if (seed == 0)
+		seed = (ullong_t) time(NULL);
+
+	rng_seed(&payload_rng, seed);
 }
 
 // Source: https://www.tutorialspoint.com/c_standard_library/c_function_rand.htm
@@ -32,7 +38,7 @@ int get_random_int (int min, int max)
 		return PAYLOAD_LOWER_BOUNDS;
 
 	/* Generate a random integer */
-	int random_int = rand() % (max + 1 - min) + min;
+	int random_int = rng_below(&payload_rng, max + 1 - min) + min;
 
 	return random_int;
 }
@@ -78,113 +84,13 @@ void init_disk_entries (char* disk_memory)
 		return;
 	}
 
-	for(int i = 0; i < PAGE_TABLE_SIZE; ++i)
+	for(int i = 0; i < DISK_MEMORY_SIZE; ++i)
 	{
 		disk_memory[i] = 0x00;		// Data
 	}
 }
 
 /*================================== FILE I/O ==================================*/
-void write_physical_memory_to_file (char* physical_memory, const char *file_path)
-{
-	printf("%s - Writing Physical Memory: %s\n", FILEIO_PRINT_TAG, file_path);
-
-	if (!physical_memory)
-	{
-		printf("%s - Physical Memory Not Defined...\n", ERROR_PRINT_TAG);
-		return;
-	}
-
-	/* Open file for writing [Creates file if doesn't exist, deletes & overwrites the file] */
-    FILE *fp = fopen(file_path, "wb");
-
-	if (fp != NULL)
-	{
-		fprintf(fp, TABLE_PHYSICAL_HEADER, "Address", "Frame", "Content");
-		fprintf(fp, "%s|%s|%s\r\n", "----------------", "---------------", "----------------");
-
-		for(int i = 0; i < PHYSICAL_MEMORY_SIZE; ++i)
-		{
-			fprintf(fp, TABLE_PHYSICAL_MEMORY, i, physical_address_to_frame(i), physical_memory[i]);			
-		}
-	}
-
-	/* Close stream */
-	fclose(fp);
-}
-
-void write_page_table_to_file (char* physical_memory, const char *file_path)
-{
-	printf("%s - Writing Page Table: %s\n", FILEIO_PRINT_TAG, file_path);
-
-	if (!physical_memory)
-	{
-		printf("%s - Physical Memory Not Defined...\n", ERROR_PRINT_TAG);
-		return;
-	}
-
-	int page_count = 0;
-
-	FILE *fp = fopen(file_path, "wb");
-
-	if (fp != NULL)
-	{
-		fprintf(fp, TABLE_PAGE_HEADER, "Page", "Physical Frame", "Is Present?", "Can RW?", "Is Dirty?", "On Disk?");
-		fprintf(fp, "%s|%s|%s|%s|%s|%s\r\n", "--------", "-----------------------", "---------------", "---------------", "---------------", "---------");
-		
-		/* Loop every 2 bytes */
-		for(int i = 0; i < PAGE_TABLE_SIZE; i += 2)
-		{
-			uchar_t physical_frame_number = physical_memory[i];
-			uchar_t control_bits = physical_memory[i + 1];
-
-			uint_t present_flag 	= ((control_bits & C_PRESENT) != 0) ? 1 : 0;
-			uint_t rw_flag 		= ((control_bits & C_READWRITE) != 0) ? 1 : 0;
-			uint_t dirty_flag 	= ((control_bits & C_DIRTY) != 0) ? 1 : 0;
-			uint_t disk_flag 		= ((control_bits & C_DISK) != 0) ? 1 : 0;
-
-			fprintf(fp, TABLE_PAGE_TABLE, page_count, physical_frame_number, present_flag, rw_flag, dirty_flag, disk_flag);
-			page_count++;
-		}
-	}
-
-	/* Close stream */
-	fclose(fp);
-}
-
-void write_disk_memory_to_file (char* disk_memory, const char *file_path)
-{
-	printf("%s - Writing Disk Memory: %s\n", FILEIO_PRINT_TAG, file_path);
-
-	int disk_frame_counter = 0;
-
-	if (!disk_memory)
-	{
-		printf("%s - Disk Memory Not Defined...\n", ERROR_PRINT_TAG);
-		return;
-	}
-
-	/* Open file for writing [Creates file if doesn't exist, deletes & overwrites the file] */
-    FILE *fp = fopen(file_path, "wb");
-
-	if (fp != NULL)
-	{
-		fprintf(fp, "%-3s\t\t| %-3s\r\n", "Page", "Content");
-		fprintf(fp, "%s|%s\r\n", "----------------", "----------------");
-
-		for(int i = 0; i < DISK_MEMORY_SIZE; ++i)
-		{
-			fprintf(fp, "0x%02X\t\t| %-3c\r\n", disk_frame_counter, disk_memory[i]);
-
-			if (i > 0 && i % PAGE_SIZE == 0)
-				disk_frame_counter++;	
-		}
-	}
-
-	/* Close stream */
-	fclose(fp);
-}
-
 // Source: http://www.codebind.com/cprogramming/get-current-directory-using-c-program/
 // Author: CodeBind Administrator (Name unknown)
 char* get_current_working_directory ()
@@ -271,7 +177,7 @@ void write_random_payload (char* physical_memory, char* disk_memory, int payload
 				control_bits |= C_READWRITE | C_DISK;
 
 				write_page_table_entry(physical_memory, disk_frame_counter, control_bits);
-				write_disk_entry(physical_memory, disk_memory);
+				write_disk_entry(physical_memory, disk_memory, disk_frame_counter);
 
 				/* Skip a frame of data if DISK*/
 				i += PAGE_SIZE;
@@ -306,18 +212,20 @@ void write_page_table_entry (char* physical_memory, uchar_t frame_number, uchar_
 	page_table_page_counter += 2;
 }
 
-void write_disk_entry (char* physical_memory, char* disk_memory)
+void write_disk_entry (char* physical_memory, char* disk_memory, int disk_frame)
 {
-	printf("%s - Writing To DISK...\n", DISK_PRINT_TAG);
-
 	if (!physical_memory)
 	{
 		printf("%s - Physical Memory Not Defined...\n", ERROR_PRINT_TAG);
 		return;
 	}
 
-	/* Write pseudo-random data for DISK memory */
-	for (int i = 0; i < PAGE_TABLE_SIZE; ++i)
+	/* The payload's pages on disk are the entries' own, page & slot are the same */
+	if (events)
+		events_record(EVENT_WRITEBACK, 0, disk_frame, disk_frame, EVENT_WRITE, 0);
+
+	/* Write a page of pseudo-random data into the given DISK frame */
+	for (int i = disk_frame * PAGE_SIZE; i < (disk_frame + 1) * PAGE_SIZE; ++i)
 	{
 		disk_memory[i] = (char) get_random_ascii_index();
 	}
@@ -384,48 +292,63 @@ int physical_address_to_frame (int physical_address)
 	return floor(physical_address / PAGE_SIZE);
 }
 
-int page_to_physical_frame (char* physical_memory, ushort_t input_address, int virtual_page_number, int offset)
+int translate_address (char* physical_memory, int page_table_base, ushort_t input_address, translation_t* translation)
 {
-	if (!physical_memory)
-	{
-		printf("%s - Physical Memory Not Defined...\n", ERROR_PRINT_TAG);
-		return -1;
-	}
-
-	uchar_t virtual_address 			= virtual_page_number * 2;
-	uchar_t control_bits 				= physical_memory[(virtual_page_number * 2) + 1];
-	uchar_t physical_frame_number 		= physical_memory[virtual_address];
+	ushort_t virtual_page_number 		= input_address >> BIT_SHIFT_BY;
+	ushort_t page_offset 				= input_address & OFFSET_MASK;
+	uchar_t physical_frame_number 		= physical_memory[page_table_base + (virtual_page_number * 2)];
+	uchar_t control_bits 				= physical_memory[page_table_base + (virtual_page_number * 2) + 1];
+
+	translation->input_address 			= input_address;
+	translation->virtual_page_number 	= virtual_page_number;
+	translation->page_offset 			= page_offset;
+	translation->control_bits 			= control_bits;
+	translation->physical_frame_number 	= physical_frame_number;
 	// Source: https://www.anintegratedworld.com/masking-bit-shifting-and-0xff00/
 	// Author: [CLOUDNTHINGS] - https://www.anintegratedworld.com/author/sean/
-	ushort_t l_shifted_page_number 		= (physical_frame_number & OFFSET_MASK) << 8;
-	ushort_t masked_page_number 		= l_shifted_page_number | offset;
+	translation->physical_address 		= ((physical_frame_number & OFFSET_MASK) << BIT_SHIFT_BY) | page_offset;
+	translation->memory_references 		= 1;
 
-	/* If on disk, retrieve into any available frame */
-	if ((control_bits & C_DISK) != 0)
-	{
-		int pte_index = get_available_pte_slot_for_disk (physical_memory);
-	}
+	if ((control_bits & C_PRESENT) != 0)
+		return T_MAPPED;
 
-	print_translation_data(physical_memory, input_address,
-		virtual_page_number, virtual_address, control_bits,
-		physical_frame_number, l_shifted_page_number, offset,
-		masked_page_number
-	);
+	if ((control_bits & C_DISK) != 0)
+		return T_ON_DISK;
 
-	return masked_page_number;
+	return T_UNMAPPED;
 }
 
-int get_available_pte_slot_for_disk (char* physical_memory)
+int page_to_physical_frame (char* physical_memory, ushort_t input_address)
 {
-	printf("%s - Segmentation Fault. Retrieving Available PTE...\n\n", DISK_PRINT_TAG);
-
 	if (!physical_memory)
 	{
 		printf("%s - Physical Memory Not Defined...\n", ERROR_PRINT_TAG);
 		return -1;
 	}
 
-	return get_available_random_pte(physical_memory);
+	translation_t translation;
+	int result = translate_address(physical_memory, 0, input_address, &translation);
+
+	if (events)
+		events_record(EVENT_WALK, 0, translation.virtual_page_number, translation.memory_references, 0x00, 0);
+
+	/* The caller faults the page in first, one that still isn't mapped means that failed */
+	if (result != T_MAPPED)
+	{
+		printf("%s - Page 0x%02llX Wasn't Faulted In...\n", ERROR_PRINT_TAG, translation.virtual_page_number);
+		return -1;
+	}
+
+	/* A lookup is an access like any other, the working set & replacement see it through C_ACCESSED */
+	physical_memory[(translation.virtual_page_number * 2) + 1] |= C_ACCESSED;
+
+	print_translation_data(physical_memory, input_address,
+		translation.virtual_page_number, translation.virtual_page_number * 2, translation.control_bits,
+		translation.physical_frame_number, translation.physical_frame_number << BIT_SHIFT_BY, translation.page_offset,
+		translation.physical_address
+	);
+
+	return translation.physical_address;
 }
 
 /*================================== DEBUGGING =================================*/
@@ -447,7 +370,6 @@ void print_translation_data (char* physical_memory, ushort_t input_address,
 	ushort_t masked_page_number)
 {
 	printf("%s", TABLE_TRSLT_HEADER);
-	printf("%s - Beginning Address Translation...\n", TRANSLATION_PRINT_TAG);
 
 	if (!physical_memory)
 	{
@@ -505,9 +427,11 @@ void print_physical_frame_contents (char* physical_memory, ushort_t input_addres
 		return;
 	}
 
-	ushort_t virtual_page_number 	= input_address >> BIT_SHIFT_BY;
-	ushort_t page_offset 			= input_address & OFFSET_MASK;
-	ushort_t physical_frame 		= page_to_physical_frame (physical_memory, input_address, virtual_page_number, page_offset);
+	int physical_frame 				= page_to_physical_frame (physical_memory, input_address);
+
+	if (physical_frame < 0)
+		return;
+
 	uchar_t data 					= physical_memory[physical_frame];
 
 	if (data)
@@ -4,9 +4,24 @@
 typedef unsigned short  ushort_t;
 typedef unsigned char   uchar_t;
 typedef unsigned int    uint_t;
+typedef unsigned long long  ullong_t;
+typedef ullong_t        vaddr_t;    /* Virtual address [Up to 64 bits] */
+typedef ullong_t        paddr_t;    /* Physical address [Up to 64 bits] */
+
+/* Result of a single virtual -> physical translation [No I/O performed] */
+typedef struct translation
+{
+    vaddr_t     input_address;
+    ullong_t    virtual_page_number;
+    ullong_t    page_offset;
+    uchar_t     control_bits;
+    ullong_t    physical_frame_number;
+    paddr_t     physical_address;
+    uchar_t     memory_references;
+} translation_t;
 
 // Initialization
-void init_random_seed ();
+void init_random_seed (ullong_t seed);
 int get_random_int (int min, int max);
 int get_random_payload_size ();
 int get_random_ascii_index ();
@@ -14,22 +29,19 @@ void init_page_table_entries (char* physical_memory);
 void init_disk_entries (char* disk_memory);
 
 // File I/O
-void write_physical_memory_to_file (char* physical_memory, const char *file_path);
-void write_page_table_to_file (char* physical_memory, const char *file_path);
-void write_disk_memory_to_file (char* disk_memory, const char *file_path);
 char* get_current_working_directory ();
 
 // Operational
 void write_random_payload (char* physical_memory, char* disk_memory, int payload_size, int start_address);
 void write_page_table_entry (char* physical_memory, uchar_t frame_number, uchar_t control_bits);
-void write_disk_entry (char* physical_memory, char* disk_memory);
+void write_disk_entry (char* physical_memory, char* disk_memory, int disk_frame);
 int get_available_random_pte (char* physical_memory);
 int get_random_physical_frame ();
 int get_available_physical_frame_count();
 int frame_to_physical_address (int frame_number);
 int physical_address_to_frame (int physical_address);
-int page_to_physical_frame (char* physical_memory, ushort_t input_address, int virtual_page_number, int offset);
-int get_available_pte_slot_for_disk (char* physical_memory);
+int translate_address (char* physical_memory, int page_table_base, ushort_t input_address, translation_t* translation);
+int page_to_physical_frame (char* physical_memory, ushort_t input_address);
 
 // Debugging
 void print_mem_config (int payload_size, int frame);
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "page_map.h"
+#include "page_table.h"
+#include "process.h"
+#include "paging.h"
+#include "working_set.h"
+
+/*=============================== INITIALIZATION ===============================*/
+working_set_t* create_working_set (unsigned long interval, const char* heatmap_path)
+{
+	FILE* heatmap = NULL;
+
+	if (heatmap_path && (heatmap = fopen(heatmap_path, "w")) == NULL)
+	{
+		printf("%s - Failed To Open Heatmap File: %s\n", ERROR_PRINT_TAG, heatmap_path);
+		return NULL;
+	}
+
+	working_set_t* sampler = calloc(1, sizeof(working_set_t));
+	sampler->interval 		= interval;
+	sampler->next_sample 	= interval;
+	sampler->dirty_seen 	= calloc(geometry.frame_count, sizeof(uchar_t));
+	sampler->page_samples 	= create_page_map(0);
+	sampler->cells 			= create_page_map(0);
+	sampler->heatmap 		= heatmap;
+
+	/* Long format, one row per non-empty cell: Any plotting tool pivots it into time x page */
+	if (heatmap)
+		fprintf(heatmap, "sample,accesses,pid,first_page,referenced,dirtied\n");
+
+	return sampler;
+}
+
+void free_working_set (working_set_t* sampler)
+{
+	if (!sampler)
+		return;
+
+	if (sampler->heatmap)
+		fclose(sampler->heatmap);
+
+	free(sampler->dirty_seen);
+	free_page_map(sampler->page_samples);
+	free_page_map(sampler->cells);
+	free(sampler);
+}
+
+/*================================= OPERATIONAL ================================*/
+static int compare_keys (const void* a, const void* b)
+{
+	ullong_t left = *(const ullong_t*) a;
+	ullong_t right = *(const ullong_t*) b;
+
+	return (left > right) - (left < right);
+}
+
+/* Cells of the current sample in page order, then they start over */
+static void write_heatmap_row (working_set_t* sampler, unsigned long replayed)
+{
+	page_map_t* cells = sampler->cells;
+	ullong_t* keys = malloc((cells->count + 1) * sizeof(ullong_t));
+	ullong_t page_mask = (1ULL << MAX_VPN_BITS) - 1;
+	ullong_t count = 0;
+
+	for (ullong_t i = 0; i < cells->capacity; ++i)
+	{
+		if (cells->used[i])
+			keys[count++] = cells->keys[i];
+	}
+
+	qsort(keys, count, sizeof(ullong_t), compare_keys);
+
+	for (ullong_t i = 0; i < count; ++i)
+	{
+		long long value = page_map_get(cells, keys[i], 0);
+
+		fprintf(sampler->heatmap, "%lu,%lu,%llu,0x%llX,%lld,%lld\n", sampler->samples, replayed, keys[i] >> MAX_VPN_BITS,
+			(keys[i] & page_mask) << HEATMAP_BUCKET_SHIFT, value & 0xFFFFFFFF, value >> 32);
+	}
+
+	free(keys);
+	free_page_map(cells);
+	sampler->cells = create_page_map(0);
+}
+
+/*
+	A frame was referenced since the last scan if its LRU stamp is newer.
+	Pages are C_DIRTY until they're evicted, so a page counts as dirtied
+	once: when the bit is first seen, or again after it was reloaded.
+*/
+void working_set_sample (working_set_t* sampler, pager_t* pager, unsigned long replayed)
+{
+	unsigned long referenced = 0;
+	unsigned long dirtied = 0;
+
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		long long page = pager->frame_page[frame];
+		process_t* process = pager->frame_process[frame];
+		ullong_t frame_number;
+		uchar_t control_bits;
+
+		/* Untouched since the last scan, so it can't have turned dirty either */
+		if (page < 0 || pager->last_used[frame] <= sampler->sampled_tick)
+			continue;
+
+		page_table_get(process->page_table, page, &frame_number, &control_bits);
+
+		uchar_t is_dirty = (control_bits & C_DIRTY) != 0;
+		int turned_dirty = is_dirty && (!sampler->dirty_seen[frame] || pager->loaded_at[frame] > sampler->sampled_tick);
+		ullong_t key = ((ullong_t) process->pid << MAX_VPN_BITS) | page;
+
+		sampler->dirty_seen[frame] = is_dirty;
+		referenced++;
+		dirtied += turned_dirty;
+
+		page_map_put(sampler->page_samples, key, page_map_get(sampler->page_samples, key, 0) + 1);
+
+		/* Referenced pages in the low half of the cell, dirtied ones in the high half */
+		if (sampler->heatmap)
+		{
+			ullong_t cell = ((ullong_t) process->pid << MAX_VPN_BITS) | ((ullong_t) page >> HEATMAP_BUCKET_SHIFT);
+
+			page_map_put(sampler->cells, cell, page_map_get(sampler->cells, cell, 0) + 1 + ((long long) turned_dirty << 32));
+		}
+	}
+
+	if (sampler->heatmap)
+		write_heatmap_row(sampler, replayed);
+
+	sampler->samples++;
+	sampler->working_set 		= referenced;
+	sampler->total_working_set 	+= referenced;
+	sampler->dirtied 			+= dirtied;
+	sampler->sampled_tick 		= pager->tick;
+	sampler->next_sample 		= replayed + sampler->interval;
+
+	if (referenced > sampler->peak_working_set)
+		sampler->peak_working_set = referenced;
+
+	if (dirtied > sampler->peak_dirtied)
+		sampler->peak_dirtied = dirtied;
+}
+
+/*================================== DEBUGGING =================================*/
+void print_working_set_stats (working_set_t* sampler)
+{
+	page_map_t* page_samples = sampler->page_samples;
+	ullong_t page_mask = (1ULL << MAX_VPN_BITS) - 1;
+	double samples = sampler->samples ? (double) sampler->samples : 1.0;
+	ullong_t hot_keys[WORKING_SET_HOT_PAGES];
+	long long hot_samples[WORKING_SET_HOT_PAGES];
+	int hot_count = 0;
+
+	/* Insertion into a short sorted list, the page map is only walked once */
+	for (ullong_t i = 0; i < page_samples->capacity; ++i)
+	{
+		if (!page_samples->used[i])
+			continue;
+
+		long long value = page_samples->values[i];
+		int position = hot_count;
+
+		while (position > 0 && (hot_samples[position - 1] < value
+			|| (hot_samples[position - 1] == value && hot_keys[position - 1] > page_samples->keys[i])))
+			position--;
+
+		if (position == WORKING_SET_HOT_PAGES)
+			continue;
+
+		if (hot_count < WORKING_SET_HOT_PAGES)
+			hot_count++;
+
+		memmove(&hot_keys[position + 1], &hot_keys[position], (hot_count - position - 1) * sizeof(ullong_t));
+		memmove(&hot_samples[position + 1], &hot_samples[position], (hot_count - position - 1) * sizeof(long long));
+
+		hot_keys[position] = page_samples->keys[i];
+		hot_samples[position] = value;
+	}
+
+	printf("%s", TABLE_WORKING_SET_HEADER);
+	printf("Interval:\t\t%'lu (accesses)\n", sampler->interval);
+	printf("Samples:\t\t%'lu\n", sampler->samples);
+	printf("Working Set:\t\t%'lu (pages, last sample)\n", sampler->working_set);
+	printf("Avg. Working Set:\t%.1f (pages)\n", sampler->total_working_set / samples);
+	printf("Peak Working Set:\t%'lu (pages)\n", sampler->peak_working_set);
+	printf("Pages Dirtied:\t\t%'lu\n", sampler->dirtied);
+	printf("Dirty Rate:\t\t%.2f (pages/1K accesses)\n", 1000.0 * sampler->dirtied / (samples * sampler->interval));
+	printf("Peak Dirtied:\t\t%'lu (pages/sample)\n", sampler->peak_dirtied);
+	printf("Distinct Pages:\t\t%'llu\n", page_samples->count);
+
+	for (int i = 0; i < hot_count; ++i)
+	{
+		printf("%s[PID %llu] 0x%llX\t%'lld (samples, %.1f%%)\n", i ? "\t\t\t" : "Hottest Pages:\t\t", hot_keys[i] >> MAX_VPN_BITS,
+			hot_keys[i] & page_mask, hot_samples[i], 100.0 * hot_samples[i] / samples);
+	}
+
+	print_header_end('=', strlen(TABLE_WORKING_SET_HEADER));
+}
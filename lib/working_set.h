@@ -0,0 +1,45 @@
+#ifndef WORKINGSETH
+#define WORKINGSETH
+
+#include <stdio.h>
+#include "utils.h"
+#include "page_map.h"
+#include "paging.h"
+
+/*
+    Working set sampler. Every interval accesses the resident frames are
+    scanned for the ones referenced since the last scan [the pager's LRU
+    stamp is the accessed bit, so nothing is cleared & replacement sees
+    exactly what it would without sampling] and for pages that turned
+    C_DIRTY. The replay itself does no extra work per access.
+*/
+typedef struct working_set
+{
+    unsigned long   interval;           /* Accesses between samples */
+    unsigned long   next_sample;        /* Replayed accesses at the next sample */
+    unsigned long   sampled_tick;       /* Pager tick of the last scan */
+    uchar_t*        dirty_seen;         /* Frame -> Page was C_DIRTY at the last scan */
+
+    page_map_t*     page_samples;       /* [pid][vpn] -> Samples the page was referenced in */
+    page_map_t*     cells;              /* [pid][bucket] -> Referenced & dirtied pages of the current sample */
+    FILE*           heatmap;            /* NULL => No heatmap file */
+
+    unsigned long   samples;
+    unsigned long   working_set;        /* Pages referenced in the last sample */
+    unsigned long   peak_working_set;
+    unsigned long   total_working_set;
+    unsigned long   dirtied;            /* Pages that turned dirty across every sample */
+    unsigned long   peak_dirtied;
+} working_set_t;
+
+// Initialization
+working_set_t* create_working_set (unsigned long interval, const char* heatmap_path);
+void free_working_set (working_set_t* sampler);
+
+// Operational
+void working_set_sample (working_set_t* sampler, pager_t* pager, unsigned long replayed);
+
+// Debugging
+void print_working_set_stats (working_set_t* sampler);
+
+#endif
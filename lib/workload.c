@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "random.h"
+#include "trace.h"
+#include "workload.h"
+
+#define WORKLOAD_LINE			64
+#define WORKLOAD_SKIP_BATCH		1024
+
+static const char* WORKLOAD_NAMES[] = { "SEQUENTIAL", "STRIDED", "UNIFORM", "ZIPF", "CHASE", "MIX", "PHASES" };
+static const int PHASE_PATTERNS[] = { WL_SEQUENTIAL, WL_UNIFORM, WL_ZIPF, WL_CHASE };
+
+/*==================================== ZIPF ====================================*/
+/*
+	Rejection-inversion sampling of ranks 1..count with P(k) ~ k^-exponent,
+	no table so a hot set of billions of pages costs nothing to set up.
+*/
+// Source: Hörmann & Derflinger, "Rejection-inversion to generate variates from monotone discrete distributions" [1996]
+// Source: https://commons.apache.org/proper/commons-rng [RejectionInversionZipfSampler]
+static inline double helper1 (double x)
+{
+	return (fabs(x) > 1e-8) ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+static inline double helper2 (double x)
+{
+	return (fabs(x) > 1e-8) ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+static inline double zipf_h (zipf_t* zipf, double x)
+{
+	return exp(-zipf->exponent * log(x));
+}
+
+static inline double zipf_h_integral (zipf_t* zipf, double x)
+{
+	double log_x = log(x);
+
+	return helper2((1.0 - zipf->exponent) * log_x) * log_x;
+}
+
+static inline double zipf_h_integral_inverse (zipf_t* zipf, double x)
+{
+	double t = x * (1.0 - zipf->exponent);
+
+	if (t < -1.0)
+		t = -1.0;
+
+	return exp(helper1(t) * x);
+}
+
+static void init_zipf (zipf_t* zipf, ullong_t count, double exponent)
+{
+	zipf->count 		= count;
+	zipf->exponent 		= exponent;
+	zipf->h_integral_x1 = zipf_h_integral(zipf, 1.5) - 1.0;
+	zipf->h_integral_n 	= zipf_h_integral(zipf, count + 0.5);
+	zipf->s 			= 2.0 - zipf_h_integral_inverse(zipf, zipf_h_integral(zipf, 2.5) - zipf_h(zipf, 2.0));
+}
+
+/* Rank in [0, count), 0 being the hottest */
+static ullong_t next_zipf (zipf_t* zipf, rng_t* rng)
+{
+	while (1)
+	{
+		double u = zipf->h_integral_n + rng_double(rng) * (zipf->h_integral_x1 - zipf->h_integral_n);
+		double x = zipf_h_integral_inverse(zipf, u);
+		double k = floor(x + 0.5);
+
+		if (k < 1.0)
+			k = 1.0;
+		else if (k > (double) zipf->count)
+			k = (double) zipf->count;
+
+		if (k - x <= zipf->s || u >= zipf_h_integral(zipf, k + 0.5) - zipf_h(zipf, k))
+			return (ullong_t) k - 1;
+	}
+}
+
+/*=============================== INITIALIZATION ===============================*/
+void init_workload_config (workload_config_t* config)
+{
+	/* Zeroed as a whole, checkpoints fingerprint the raw bytes */
+	memset(config, 0x00, sizeof(workload_config_t));
+	config->pattern 		= WL_UNIFORM;
+	config->write_percent 	= WORKLOAD_WRITE_PERCENT;
+	config->seed 			= 1;
+	config->length 			= WORKLOAD_DEFAULT_LENGTH;
+	config->zipf_exponent 	= WORKLOAD_ZIPF_EXPONENT;
+	config->phase_length 	= WORKLOAD_PHASE_LENGTH;
+}
+
+/*
+	<pattern>[:key=value,...], i.e. zipf:n=4G,pages=65536,s=1.2,seed=7
+		n		Accesses [Size suffixes allowed]
+		pages	Footprint in pages
+		base	First address [Hex]
+		stride	Bytes between strided accesses
+		s		Zipf exponent
+		w		Percentage of writes
+		phase	Accesses per phase
+		seed	Stream seed
+*/
+int parse_workload (const char* spec, workload_config_t* config)
+{
+	char buffer[256];
+	char* options;
+
+	strncpy(buffer, spec, sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = '\0';
+
+	if ((options = strchr(buffer, ':')) != NULL)
+		*options++ = '\0';
+
+	config->pattern = -1;
+
+	for (int i = 0; i < (int) (sizeof(WORKLOAD_NAMES) / sizeof(WORKLOAD_NAMES[0])); ++i)
+	{
+		if (strcasecmp(buffer, WORKLOAD_NAMES[i]) == 0)
+			config->pattern = i;
+	}
+
+	if (config->pattern < 0)
+	{
+		printf("%s - Unknown Workload: %s\n", ERROR_PRINT_TAG, buffer);
+		return -1;
+	}
+
+	for (char* option = options ? strtok(options, ",") : NULL; option; option = strtok(NULL, ","))
+	{
+		char* value = strchr(option, '=');
+
+		if (!value)
+		{
+			printf("%s - Workload Option Expects key=value: %s\n", ERROR_PRINT_TAG, option);
+			return -1;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(option, "n") == 0)
+			config->length = parse_size(value);
+		else if (strcmp(option, "pages") == 0)
+			config->pages = parse_size(value);
+		else if (strcmp(option, "base") == 0)
+			config->base = strtoull(value, NULL, 16);
+		else if (strcmp(option, "stride") == 0)
+			config->stride = parse_size(value);
+		else if (strcmp(option, "s") == 0)
+			config->zipf_exponent = atof(value);
+		else if (strcmp(option, "w") == 0)
+			config->write_percent = atoi(value);
+		else if (strcmp(option, "phase") == 0)
+			config->phase_length = parse_size(value);
+		else if (strcmp(option, "seed") == 0)
+			config->seed = strtoull(value, NULL, 0);
+		else
+		{
+			printf("%s - Unknown Workload Option: %s\n", ERROR_PRINT_TAG, option);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Fits the footprint into the configured address space, the geometry must be set */
+workload_t* create_workload (workload_config_t* config)
+{
+	ullong_t first_page = config->base >> geometry.page_shift;
+
+	if (first_page >= geometry.virtual_page_count || config->length == 0 || config->zipf_exponent <= 0 || config->phase_length == 0)
+	{
+		printf("%s - Workload Doesn't Fit The Virtual Address Space...\n", ERROR_PRINT_TAG);
+		return NULL;
+	}
+
+	workload_t* workload = calloc(1, sizeof(workload_t));
+	memcpy(&workload->config, config, sizeof(workload_config_t));
+
+	workload_config_t* settings = &workload->config;
+	ullong_t pages = (settings->pages > 0) ? settings->pages : WORKLOAD_DEFAULT_PAGES;
+
+	/* Phases move the footprint, mixes keep the top of the address space for the stack */
+	ullong_t room = geometry.virtual_page_count - first_page;
+
+	if (settings->pattern == WL_MIX || settings->pattern == WL_PHASES)
+		room /= 2;
+
+	if (pages > room)
+		pages = (room > 0) ? room : 1;
+
+	settings->pages 	= pages;
+	settings->base 		= first_page << geometry.page_shift;
+	workload->footprint = pages << geometry.page_shift;
+
+	if (settings->stride == 0)
+		settings->stride = geometry.page_size;
+
+	reset_workload(workload);
+
+	return workload;
+}
+
+void free_workload (workload_t* workload)
+{
+	free(workload);
+}
+
+/* Rewind to the first access of the stream */
+void reset_workload (workload_t* workload)
+{
+	workload_config_t* config = &workload->config;
+	ullong_t lines = workload->footprint / WORKLOAD_LINE;
+
+	rng_seed(&workload->rng, config->seed);
+	workload->generated 	= 0;
+	workload->cursor 		= 0;
+	workload->stack_pointer = workload->footprint / 8;
+
+	/* Full period LCG over the next power of 2, lines past the end are skipped [Hull-Dobell] */
+	workload->chase_lines 		= lines;
+	workload->chase_mask 		= 1;
+
+	while (workload->chase_mask < lines)
+		workload->chase_mask <<= 1;
+
+	workload->chase_mask 		-= 1;
+	workload->chase_increment 	= (rng_next(&workload->rng) | 1) & workload->chase_mask;
+
+	/* The mix only draws heap pages from the zipf sampler */
+	init_zipf(&workload->zipf, (config->pattern == WL_MIX) ? (config->pages + 1) / 2 : config->pages, config->zipf_exponent);
+}
+
+/*================================= OPERATIONAL ================================*/
+static inline ullong_t next_chase_line (workload_t* workload)
+{
+	do
+		workload->cursor = (workload->cursor * 6364136223846793005ULL + workload->chase_increment) & workload->chase_mask;
+	while (workload->cursor >= workload->chase_lines);
+
+	return workload->cursor;
+}
+
+/* Offset into the footprint of one access of a plain pattern */
+static inline ullong_t next_offset (workload_t* workload, int pattern)
+{
+	ullong_t footprint = workload->footprint;
+	ullong_t offset;
+
+	switch (pattern)
+	{
+		case WL_SEQUENTIAL:
+			offset = workload->cursor;
+			workload->cursor = (workload->cursor + WORKLOAD_LINE) % footprint;
+			return offset;
+
+		case WL_STRIDED:
+			offset = workload->cursor;
+			workload->cursor = (workload->cursor + workload->config.stride) % footprint;
+			return offset;
+
+		case WL_ZIPF:
+			return (next_zipf(&workload->zipf, &workload->rng) << geometry.page_shift) | rng_below(&workload->rng, geometry.page_size);
+
+		case WL_CHASE:
+			return next_chase_line(workload) * WORKLOAD_LINE;
+
+		case WL_UNIFORM:
+		default:
+			return rng_below(&workload->rng, footprint);
+	}
+}
+
+/*
+	One process' view of memory: a stack near the top of the address
+	space moving up & down, a zipf distributed heap at the base & a
+	file mapping above it scanned line by line.
+*/
+static inline vaddr_t next_mix_address (workload_t* workload)
+{
+	ullong_t footprint = workload->footprint;
+	ullong_t region = rng_below(&workload->rng, 100);
+
+	if (region < 50)
+	{
+		ullong_t stack_size = footprint / 4;
+		ullong_t top = (geometry.va_bits == 64) ? ~0ULL : (1ULL << geometry.va_bits) - 1;
+		long long step = ((long long) rng_below(&workload->rng, 17) - 8) * 8;
+		long long pointer = (long long) workload->stack_pointer + step;
+
+		if (pointer < 0)
+			pointer = 0;
+		else if ((ullong_t) pointer >= stack_size)
+			pointer = stack_size - 8;
+
+		workload->stack_pointer = pointer;
+
+		return top - workload->stack_pointer;
+	}
+
+	if (region < 85)
+		return workload->config.base + ((next_zipf(&workload->zipf, &workload->rng) << geometry.page_shift) | rng_below(&workload->rng, geometry.page_size));
+
+	vaddr_t mapping = workload->config.base + (footprint / 2);
+
+	workload->cursor = (workload->cursor + WORKLOAD_LINE) % (footprint / 4);
+
+	return mapping + workload->cursor;
+}
+
+void workload_next (workload_t* workload, trace_entry_t* entries, unsigned long count)
+{
+	workload_config_t* config = &workload->config;
+
+	for (unsigned long i = 0; i < count; ++i)
+	{
+		vaddr_t address;
+
+		if (config->pattern == WL_MIX)
+		{
+			address = next_mix_address(workload);
+		}
+		else if (config->pattern == WL_PHASES)
+		{
+			unsigned long phase = workload->generated / config->phase_length;
+
+			/* Each phase starts its own pattern on the next footprint along */
+			if (workload->generated % config->phase_length == 0)
+				workload->cursor = 0;
+
+			address = config->base + ((phase % 2) * workload->footprint) + next_offset(workload, PHASE_PATTERNS[phase % 4]);
+		}
+		else
+		{
+			address = config->base + next_offset(workload, config->pattern);
+		}
+
+		entries[i].address = address;
+		entries[i].is_write = rng_below(&workload->rng, 100) < (ullong_t) config->write_percent;
+		workload->generated++;
+	}
+}
+
+/* Generating is the only way to reach a position, every access depends on the ones before */
+void workload_skip (workload_t* workload, unsigned long count)
+{
+	trace_entry_t scratch[WORKLOAD_SKIP_BATCH];
+
+	while (count > 0)
+	{
+		unsigned long batch = (count < WORKLOAD_SKIP_BATCH) ? count : WORKLOAD_SKIP_BATCH;
+
+		workload_next(workload, scratch, batch);
+		count -= batch;
+	}
+}
+
+/*================================== DEBUGGING =================================*/
+const char* get_workload_name (int pattern)
+{
+	return WORKLOAD_NAMES[pattern];
+}
@@ -0,0 +1,69 @@
+#ifndef WORKLOADH
+#define WORKLOADH
+
+#include "utils.h"
+#include "random.h"
+#include "trace.h"
+
+/* Access patterns */
+#define WL_SEQUENTIAL       0
+#define WL_STRIDED          1
+#define WL_UNIFORM          2
+#define WL_ZIPF             3
+#define WL_CHASE            4       /* Pointer chasing: Every line once per lap in a seeded random order */
+#define WL_MIX              5       /* Stack, heap & mmap regions of one process */
+#define WL_PHASES           6       /* Sequential, uniform, zipf & chase in turn, each over a new working set */
+
+/* Fully describes a stream, the same config always generates the same accesses */
+typedef struct workload_config
+{
+    int         pattern;
+    int         write_percent;
+    ullong_t    seed;
+    unsigned long length;           /* Accesses in the stream */
+    ullong_t    pages;              /* Footprint [0 => WORKLOAD_DEFAULT_PAGES] */
+    vaddr_t     base;               /* First address of the footprint */
+    ullong_t    stride;             /* Bytes between strided accesses */
+    double      zipf_exponent;
+    unsigned long phase_length;     /* Accesses per phase */
+} workload_config_t;
+
+/* Rejection-inversion sampler, constant memory however large the hot set */
+typedef struct zipf
+{
+    ullong_t    count;
+    double      exponent;
+    double      h_integral_x1;
+    double      h_integral_n;
+    double      s;
+} zipf_t;
+
+typedef struct workload
+{
+    workload_config_t config;
+    rng_t       rng;
+    unsigned long generated;        /* Accesses produced since the last reset */
+    ullong_t    footprint;          /* Bytes */
+    ullong_t    cursor;             /* Sequential & strided offset, chase line, mmap scan offset */
+    ullong_t    chase_lines;
+    ullong_t    chase_mask;
+    ullong_t    chase_increment;
+    ullong_t    stack_pointer;
+    zipf_t      zipf;
+} workload_t;
+
+// Initialization
+void init_workload_config (workload_config_t* config);
+int parse_workload (const char* spec, workload_config_t* config);
+workload_t* create_workload (workload_config_t* config);
+void free_workload (workload_t* workload);
+void reset_workload (workload_t* workload);
+
+// Operational
+void workload_next (workload_t* workload, trace_entry_t* entries, unsigned long count);
+void workload_skip (workload_t* workload, unsigned long count);
+
+// Debugging
+const char* get_workload_name (int pattern);
+
+#endif
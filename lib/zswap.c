@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "constants.h"
+#include "utils.h"
+#include "geometry.h"
+#include "frame_allocator.h"
+#include "swap_device.h"
+#include "compress.h"
+#include "zswap.h"
+
+#define ZSWAP_NONE		UINT_MAX	/* No slot, ends the store order */
+
+/*=============================== INITIALIZATION ===============================*/
+zswap_t* create_zswap (ullong_t pool_size, char* disk_memory, swap_device_t* swap)
+{
+	printf("%s - Initializing Compressed Swap Pool...\n", INIT_PRINT_TAG);
+
+	ullong_t unit_count = pool_size / ZSWAP_UNIT;
+
+	if (unit_count == 0 || unit_count > UINT_MAX)
+	{
+		printf("%s - Compressed Swap Pool Must Hold 1 To %'u Units Of %d Bytes...\n", ERROR_PRINT_TAG, UINT_MAX, ZSWAP_UNIT);
+		return NULL;
+	}
+
+	/* Slots link the store order as 32-bit numbers, ZSWAP_NONE included */
+	if (geometry.disk_frame_count > ZSWAP_NONE)
+	{
+		printf("%s - Compressed Swap Pool Supports Disks Of At Most %'u Pages...\n", ERROR_PRINT_TAG, ZSWAP_NONE);
+		return NULL;
+	}
+
+	zswap_t* zswap = calloc(1, sizeof(zswap_t));
+	zswap->pool_size 		= unit_count * ZSWAP_UNIT;
+	zswap->pool 			= malloc(zswap->pool_size);
+	zswap->units 			= create_frame_allocator(unit_count);
+	zswap->disk_memory 		= disk_memory;
+	zswap->swap 			= swap;
+	zswap->buffer 			= malloc(geometry.page_size);
+	zswap->offset 			= calloc(geometry.disk_frame_count, sizeof(uint_t));
+	zswap->length 			= calloc(geometry.disk_frame_count, sizeof(uint_t));
+	zswap->older 			= malloc(geometry.disk_frame_count * sizeof(uint_t));
+	zswap->newer 			= malloc(geometry.disk_frame_count * sizeof(uint_t));
+	zswap->oldest 			= ZSWAP_NONE;
+	zswap->newest 			= ZSWAP_NONE;
+
+	return zswap;
+}
+
+void free_zswap (zswap_t* zswap)
+{
+	if (!zswap)
+		return;
+
+	free(zswap->pool);
+	free_frame_allocator(zswap->units);
+	free(zswap->buffer);
+	free(zswap->offset);
+	free(zswap->length);
+	free(zswap->older);
+	free(zswap->newer);
+	free(zswap);
+}
+
+/*================================= OPERATIONAL ================================*/
+static inline ullong_t units_of (ullong_t length)
+{
+	return (length + ZSWAP_UNIT - 1) / ZSWAP_UNIT;
+}
+
+/* Modeled CPU time to run the codec over one page at the given rate */
+static ullong_t charge_codec (zswap_t* zswap, ullong_t rate)
+{
+	ullong_t time = (geometry.page_size * 1000000000ULL) / rate;
+
+	if (zswap->swap)
+		zswap->swap->now += time;
+
+	return time;
+}
+
+static void remove_entry (zswap_t* zswap, ullong_t slot)
+{
+	ullong_t length = zswap->length[slot];
+	uint_t older = zswap->older[slot];
+	uint_t newer = zswap->newer[slot];
+
+	if (older != ZSWAP_NONE)
+		zswap->newer[older] = newer;
+	else
+		zswap->oldest = newer;
+
+	if (newer != ZSWAP_NONE)
+		zswap->older[newer] = older;
+	else
+		zswap->newest = older;
+
+	frame_allocator_release(zswap->units, zswap->offset[slot], units_of(length));
+
+	zswap->used_units 		-= units_of(length);
+	zswap->stored_bytes 	-= length;
+	zswap->stored_pages--;
+	zswap->length[slot] 	= 0;
+}
+
+/* Newest entry, the last a full pool writes back */
+static void push_entry (zswap_t* zswap, ullong_t slot)
+{
+	zswap->older[slot] 	= zswap->newest;
+	zswap->newer[slot] 	= ZSWAP_NONE;
+
+	if (zswap->newest != ZSWAP_NONE)
+		zswap->newer[zswap->newest] = slot;
+	else
+		zswap->oldest = slot;
+
+	zswap->newest = slot;
+}
+
+/* Oldest entry goes to its disk slot, -1 once the pool is empty */
+static int write_back_oldest (zswap_t* zswap)
+{
+	ullong_t page_size = geometry.page_size;
+	uint_t slot = zswap->oldest;
+
+	if (slot == ZSWAP_NONE)
+		return -1;
+
+	lz_decompress(&zswap->pool[zswap->offset[slot] * ZSWAP_UNIT], zswap->length[slot], &zswap->disk_memory[slot * page_size], page_size);
+	zswap->decompress_ns += charge_codec(zswap, ZSWAP_DECOMPRESS_RATE);
+
+	if (zswap->swap)
+		swap_device_write(zswap->swap, slot);
+
+	remove_entry(zswap, slot);
+	zswap->pool_writebacks++;
+
+	return 0;
+}
+
+/* 0 once the pool holds the page for the slot, -1 if it must go to disk */
+int zswap_store (zswap_t* zswap, ullong_t slot, const char* page)
+{
+	ullong_t page_size = geometry.page_size;
+
+	/* Whatever the slot held is stale now, stored or not */
+	if (zswap->length[slot] != 0)
+		remove_entry(zswap, slot);
+
+	ullong_t length = lz_compress(page, page_size, zswap->buffer, page_size * ZSWAP_ACCEPT_PERCENT / 100);
+	long long first_unit;
+
+	zswap->compress_ns += charge_codec(zswap, ZSWAP_COMPRESS_RATE);
+
+	if (length == 0 || length > zswap->pool_size)
+	{
+		zswap->rejects++;
+		return -1;
+	}
+
+	while ((first_unit = frame_allocator_allocate_run(zswap->units, units_of(length), 1)) < 0)
+	{
+		if (write_back_oldest(zswap) < 0)
+		{
+			zswap->rejects++;
+			return -1;
+		}
+	}
+
+	memcpy(&zswap->pool[first_unit * ZSWAP_UNIT], zswap->buffer, length);
+
+	zswap->offset[slot] 	= first_unit;
+	zswap->length[slot] 	= length;
+	push_entry(zswap, slot);
+
+	zswap->stores++;
+	zswap->stored_pages++;
+	zswap->stored_bytes 	+= length;
+	zswap->used_units 		+= units_of(length);
+	zswap->original_total 	+= page_size;
+	zswap->compressed_total += length;
+
+	if (zswap->used_units > zswap->peak_units)
+		zswap->peak_units = zswap->used_units;
+
+	return 0;
+}
+
+/* 0 if the pool had the slot's page, -1 if it has to come from disk */
+int zswap_load (zswap_t* zswap, ullong_t slot, char* page)
+{
+	if (zswap->length[slot] == 0)
+	{
+		zswap->misses++;
+		return -1;
+	}
+
+	lz_decompress(&zswap->pool[zswap->offset[slot] * ZSWAP_UNIT], zswap->length[slot], page, geometry.page_size);
+	zswap->decompress_ns += charge_codec(zswap, ZSWAP_DECOMPRESS_RATE);
+	zswap->hits++;
+
+	return 0;
+}
+
+/* Slot freed, nobody reads its contents again */
+void zswap_invalidate (zswap_t* zswap, ullong_t slot)
+{
+	if (zswap->length[slot] == 0)
+		return;
+
+	remove_entry(zswap, slot);
+	zswap->invalidations++;
+}
+
+/*
+	Copy every entry to its disk slot, e.g. before the disk image is saved.
+	The entries stay in the pool & nothing is timed, the run carries on as
+	if the copy never happened.
+*/
+void zswap_sync (zswap_t* zswap)
+{
+	ullong_t page_size = geometry.page_size;
+
+	for (uint_t slot = zswap->oldest; slot != ZSWAP_NONE; slot = zswap->newer[slot])
+		lz_decompress(&zswap->pool[zswap->offset[slot] * ZSWAP_UNIT], zswap->length[slot], &zswap->disk_memory[slot * page_size], page_size);
+}
+
+/*================================== DEBUGGING =================================*/
+void print_zswap_stats (zswap_t* zswap)
+{
+	unsigned long swap_ins = zswap->hits + zswap->misses;
+	unsigned long writes_avoided = zswap->stores - zswap->pool_writebacks;
+	double compressed = zswap->compressed_total ? (double) zswap->compressed_total : 1.0;
+
+	printf("%s", TABLE_ZSWAP_HEADER);
+	printf("Pool Size:\t\t%'llu (bytes, %'llu in use, peak %'llu)\n", zswap->pool_size, zswap->used_units * ZSWAP_UNIT, zswap->peak_units * ZSWAP_UNIT);
+	printf("Stored Pages:\t\t%'lu (%'lu held, %'llu bytes compressed)\n", zswap->stores, zswap->stored_pages, zswap->stored_bytes);
+	printf("Rejected:\t\t%'lu (pages above %d%% once compressed)\n", zswap->rejects, ZSWAP_ACCEPT_PERCENT);
+	printf("Compression Ratio:\t%.2f\n", zswap->original_total / compressed);
+	printf("Pool Hits:\t\t%'lu (%.2f%% of swap-ins)\n", zswap->hits, swap_ins ? 100.0 * zswap->hits / swap_ins : 0.0);
+	printf("Pool Misses:\t\t%'lu\n", zswap->misses);
+	printf("Pool Write Backs:\t%'lu (pages pushed to disk by a full pool)\n", zswap->pool_writebacks);
+	printf("Invalidated:\t\t%'lu\n", zswap->invalidations);
+	printf("Compress Time:\t\t%.3f (ms, modeled)\n", zswap->compress_ns / 1e6);
+	printf("Decompress Time:\t%.3f (ms, modeled)\n", zswap->decompress_ns / 1e6);
+	printf("Disk Reads Avoided:\t%'lu (pages)\n", zswap->hits);
+	printf("Disk Writes Avoided:\t%'lu (pages)\n", writes_avoided);
+
+	/* What the same pages would have cost the device, one request each */
+	if (zswap->swap)
+	{
+		swap_device_config_t* config = &zswap->swap->config;
+		ullong_t request_ns = config->latency_ns + (geometry.page_size * 1000000000ULL) / config->bandwidth;
+
+		printf("Est. Disk I/O Avoided:\t%.3f (ms, %.3f of it reads)\n", (zswap->hits + writes_avoided) * request_ns / 1e6, zswap->hits * request_ns / 1e6);
+	}
+
+	print_header_end('=', strlen(TABLE_ZSWAP_HEADER));
+}
@@ -0,0 +1,64 @@
+#ifndef ZSWAPH
+#define ZSWAPH
+
+#include "utils.h"
+#include "frame_allocator.h"
+#include "swap_device.h"
+
+/*
+    Compressed swap tier in front of the disk image. Evicted dirty pages
+    are compressed into a RAM pool of a fixed size instead of being written
+    to their disk slot, a fault on the slot decompresses them again. The
+    pool is carved into ZSWAP_UNIT byte units & every entry takes the run
+    of units the buddy allocator hands out. Pages that don't compress well
+    enough go to disk, and a full pool writes its oldest entries there to
+    make room. An entry stays the slot's copy until the slot is rewritten
+    or freed, so a clean page can be dropped again without a store.
+*/
+typedef struct zswap
+{
+    ullong_t        pool_size;          /* Bytes */
+    char*           pool;
+    frame_allocator_t* units;           /* Free units of the pool */
+    char*           disk_memory;        /* Where a full pool writes its oldest entries */
+    swap_device_t*  swap;               /* Times those writes & the compression, NULL => Untimed */
+    char*           buffer;             /* Compressed page before it's placed */
+
+    uint_t*         offset;             /* Slot -> First unit of its entry */
+    uint_t*         length;             /* Slot -> Compressed bytes, 0 => Not in the pool */
+    uint_t*         older;              /* Slot -> Entry stored before it, UINT_MAX => Oldest */
+    uint_t*         newer;              /* Slot -> Entry stored after it, UINT_MAX => Newest */
+    uint_t          oldest;             /* Next entry a full pool writes back, UINT_MAX => Empty */
+    uint_t          newest;
+
+    ullong_t        stored_bytes;       /* Compressed bytes in the pool */
+    ullong_t        used_units;
+    ullong_t        peak_units;
+    unsigned long   stored_pages;
+
+    unsigned long   stores;
+    unsigned long   rejects;            /* Pages that didn't compress below ZSWAP_ACCEPT_PERCENT */
+    unsigned long   hits;               /* Swap-ins served from the pool */
+    unsigned long   misses;             /* Swap-ins that had to read the disk */
+    unsigned long   pool_writebacks;    /* Entries moved to disk by a full pool */
+    unsigned long   invalidations;      /* Entries dropped with their slot */
+    ullong_t        original_total;     /* Bytes of every stored page, before & after */
+    ullong_t        compressed_total;
+    ullong_t        compress_ns;        /* Modeled CPU time */
+    ullong_t        decompress_ns;
+} zswap_t;
+
+// Initialization
+zswap_t* create_zswap (ullong_t pool_size, char* disk_memory, swap_device_t* swap);
+void free_zswap (zswap_t* zswap);
+
+// Operational
+int zswap_store (zswap_t* zswap, ullong_t slot, const char* page);
+int zswap_load (zswap_t* zswap, ullong_t slot, char* page);
+void zswap_invalidate (zswap_t* zswap, ullong_t slot);
+void zswap_sync (zswap_t* zswap);
+
+// Debugging
+void print_zswap_stats (zswap_t* zswap);
+
+#endif
@@ -3,6 +3,26 @@
 #include <locale.h>
 #include <string.h>
 #include "lib/utils.h"
+#include "lib/geometry.h"
+#include "lib/tlb.h"
+#include "lib/paging.h"
+#include "lib/trace.h"
+#include "lib/workload.h"
+#include "lib/page_table.h"
+#include "lib/process.h"
+#include "lib/scheduler.h"
+#include "lib/snapshot.h"
+#include "lib/checkpoint.h"
+#include "lib/sweep.h"
+#include "lib/working_set.h"
+#include "lib/swap_device.h"
+#include "lib/zswap.h"
+#include "lib/ksm.h"
+#include "lib/numa.h"
+#include "lib/cache.h"
+#include "lib/reclaim.h"
+#include "lib/metrics.h"
+#include "lib/events.h"
 #include "lib/constants.h"
 
 #ifdef _WIN32
@@ -39,6 +59,8 @@
 	[+]	Write file to "/data/physical_memory.txt" which displays the
 			contents of your simulation of physical memory in linear &
 			readable form. (Label which addresses are & are not used.
+			[Now written as the binary "/data/snapshot.bin", make dump
+			renders the text files from it]
 
 	[+]	Write file to "/data/page_table.txt" which displays the
 			contents of your simulated page table in linear, readable
@@ -53,63 +75,898 @@
 
 	[+]	Display prompt which allows the user to enter any virtual
 			memory address in your system, in HEXIDECIMAL form.
+
+	Batch Mode:
+
+		./simulate -t <trace file>... [-W workload]... [-S seed]
+			[-n processes] [-q quantum] [-g table]
+			[-e entries] [-w ways] [-p policy] [-a]
+			[-r replacement] [-f frames] [-o snapshot]
+			[-C accesses:checkpoint] [-R checkpoint]
+			[-x sweep_config]... [-j threads] [-M curve_file]
+			[-F accesses[:children]] [-K interval:heatmap_file]
+			[-I swap_device] [-Z pool_size]
+			[-D interval[:pages]] [-N numa_config]
+			[-L cache_config] [-k reclaim_config]
+			[-O metrics_config] [-E event_config]
+
+		Replays every "<hex address> [R|W]" line of the trace against
+		the page table and prints aggregate results instead of
+		prompting for addresses. Translations are cached by a TLB
+		(-e 0 disables it), -w 0 makes it fully-associative, -p picks
+		lru, fifo, random or clock replacement and -a tags entries
+		with an ASID instead of flushing on context switch.
+
+		Page faults are serviced by the pager: -f caps the number of
+		resident frames and -r picks fifo, lru, clock, nru or optimal
+		page replacement.
+
+		-H <order> enables huge pages of 2^order base pages. Regions
+		that are mostly resident are collapsed into an aligned run of
+		frames & cached by a single TLB entry, they are split again
+		when replacement picks one of their frames. The TLB report
+		then also shows the miss rate of the same TLB without them.
+
+		Each -t starts another simulated process with its own page
+		table in physical memory, -n runs that many processes over
+		the given traces and the round-robin scheduler switches
+		process every -q accesses. Frames are shared between them.
+
+		-g picks the page table structure: linear (default), radix-2,
+		radix-4 or a hashed inverted table shared by all processes.
+		Interactive mode always uses the linear table.
+
+		-V & -P set the virtual & physical address widths in bits (up
+		to 64), -s the page size (256 bytes to 2M), -m the installed
+		memory & -d the swap size, i.e. -V 48 -P 40 -s 4K -m 1G. Page
+		table entries widen to 4 or 8 bytes to fit the frame number.
+		Building with -DSIM_PAGE_SHIFT=<n> fixes the page size at
+		compile time for a faster replay loop. The random payload,
+		snapshot & interactive prompt need the default geometry.
+
+		-o writes a binary snapshot of the machine [memory, page tables,
+		frame bitmap & disk] once the run is over, for any geometry.
+		dist/render_snapshot prints its readable tables on demand.
+
+		-C <accesses>:<file> saves a checkpoint once that many accesses
+		were replayed [the run carries on], -R <file> resumes from one
+		instead of starting over. The checkpoint fixes the geometry,
+		page tables & huge page size, the traces must be the same but
+		the replacement policy, frame limit, TLB & quantum may change,
+		so one warmed-up machine can seed a whole parameter sweep. A
+		TLB of a different shape starts cold.
+
+		-W <pattern>[:key=value,...] replays a generated stream in place
+		of a trace file: sequential, strided, uniform, zipf, chase, mix
+		[stack, heap & mmap regions] or phases. Accesses are generated
+		from the stream's seed as they are replayed, so n=4G costs no
+		more memory than n=1M, i.e. -W zipf:n=4G,pages=65536,s=1.1.
+		Options are n, pages, base, stride, s, w [write %], phase &
+		seed. -S sets the default seed of every stream & the payload,
+		runs with the same seed are identical. Extra processes from -n
+		get their own stream, seeded with seed + pid.
+
+		-x <key=value,...> adds a configuration to a sweep: e [TLB
+		entries], w [ways], p [TLB policy], a [ASID 0/1], r [page
+		replacement], f [frame limit] & q [quantum], anything left out
+		comes from the rest of the command line. Every configuration
+		replays the same traces on a machine of its own, spread over
+		-j threads [default: every online CPU], and the results are
+		merged into one table, i.e. -x e=32 -x e=64,r=clock -x f=512.
+		Loaded traces are shared between threads, generated streams
+		are replayed from the same seed by each. With -R every machine
+		starts from the checkpoint, otherwise from empty memory [no
+		payload]. -C, -o, -I, -Z, -D, -N, -L, -k, -M & -K don't
+		apply to a sweep.
+
+		-M <file> measures the LRU stack distance of every page reference
+		on the way, which gives the misses of every memory size & every
+		fully-associative LRU TLB size in one run. Powers of 2 are
+		printed, <file> gets the whole curve as CSV. Without -a the TLB
+		curve counts the flush on every context switch.
+
+		-F <accesses>[:children] forks the running process once that
+		many accesses were replayed [1 child by default]. A child gets
+		every page of its parent without a copy: Resident frames are
+		shared & writable ones turn copy-on-write in both, the first
+		write to one copies it [or takes it over if nobody else maps it
+		any more], swapped pages share the disk slot. Children carry on
+		from the parent's position, a generated stream is reseeded with
+		the child's pid. Inverted tables can't map a frame twice, so
+		there the pages are copied at the fork. -F & -C don't mix.
+
+		-K <interval>:<file> samples the working set every interval
+		accesses: resident pages referenced since the last sample, the
+		ones that turned dirty & how often each page was referenced.
+		The scan reads the pager's LRU stamps & C_DIRTY, so replacement
+		isn't disturbed. <file> gets a time x page heatmap as CSV, one
+		row per sample & non-empty cell of 16 pages.
+
+		-I <key=value,...> times the backing store: latency [us],
+		bandwidth [bytes/s], depth [requests in service at once],
+		readahead [pages], batch [pages per write-back flush], access
+		[ns of CPU time per access] & file [swap file]. Faults wait for
+		their read, evicted dirty pages are queued & flushed a batch at
+		a time in the background, and two faults the same distance apart
+		start reading the next pages of the stream ahead. The report
+		splits fault stalls from I/O that overlapped the replay, i.e.
+		-I latency=100,bandwidth=1G,readahead=16,file=data/swap.bin.
+
+		-Z <size> puts a compressed pool of that many bytes in front of
+		the disk: evicted dirty pages are LZ compressed into it instead
+		of being written to their slot & decompressed on the next fault.
+		Pages that keep more than 3/4 of their size go to disk, a full
+		pool writes its oldest pages there. Compression & decompression
+		are charged to the -I clock at modeled rates, the report weighs
+		that CPU time against the disk I/O it saved, i.e. -Z 16M.
+
+		-D <interval>[:pages] merges frames with the same contents: every
+		interval accesses a scan pass hashes the next pages frames [100
+		by default]. Frames whose hash held still since their last pass
+		merge into one read-only frame, all-zero ones into a shared zero
+		frame, and each page mapping it turns copy-on-write. Reads of a
+		page that was never written map the zero frame as well. The
+		report weighs the frames saved against the host time & bytes
+		the scanner spent. Inverted tables & huge pages never merge,
+		-D & -C don't mix.
+
+		-N <key=value,...> splits physical memory into NUMA nodes of
+		equal size: nodes [2], local & remote [cycles per access, 100 &
+		180], policy [first-touch on the process' node, interleave pages
+		over the nodes or preferred, i.e. node=1 first], migrate [remote
+		accesses before a private page moves to its process' node, 0 =>
+		never] & bind [home node per pid, 0:1:1, pid % nodes otherwise].
+		A full node spills to the next one. The report splits accesses
+		into local & remote per node & process, with the migration
+		traffic, i.e. -N nodes=2,policy=interleave,migrate=64.
+
+		-L <key=value,...> puts a physically indexed cache hierarchy
+		behind the TLB: l1, l2 & l3 [<size>[:ways[:cycles]], 32K:8:4,
+		256K:8:12 & 8M:16:40 by default, none past the last one given],
+		line [bytes, 64], inclusion [inclusive, exclusive or nine], write
+		[back or through], memory [cycles past the last level, 100] &
+		uncached [<first>-<end> virtual addresses in hex, mapped with
+		C_CACHEDISABLED]. Every access
+		looks up its physical address after translation & every page
+		table entry a walk reads goes through the same caches, uncached
+		pages go straight to memory. The report splits misses per level
+		between data & walks, i.e. -L l1=32K:8,l2=1M:16,inclusion=exclusive.
+
+		-k <key=value,...> reclaims ahead of the frame limit with free
+		frame watermarks: min, low & high [frames, 1% of the limit & 2
+		& 3 times that by default]. An allocation leaving low frames or
+		fewer free wakes a background reclaimer that evicts up to batch
+		pages [32] every interval accesses [64] until high are free, one
+		finding min or fewer evicts on its own & stalls for cost [ns per
+		page, 2000]. limit [frames per pid, 256:512, the last one for
+		the pids past it, 0 => none] caps the frames a process owns, at
+		its limit it evicts its own pages. The report splits reclaim between the
+		background, direct & limit paths with the allocation stall time
+		overall & per process, i.e. -k min=16,low=64,high=128,limit=512.
+
+		-O <key=value,...> records metrics while the replay runs: counters
+		& log-linear histograms of the translation latency [cycles], the
+		fault service time & the eviction cost [host ns]. Each thread
+		records into a shard of its own without a lock, an export thread
+		sums them in Prometheus text format for every connection to
+		socket [a Unix socket, i.e. curl --unix-socket <path>
+		http://localhost/metrics] & rewrites file every interval [ms,
+		1000], i.e. -O socket=/tmp/sim.sock,file=data/metrics.prom. The
+		report prints the percentiles, with -x every sweep thread records
+		into the same totals.
+
+		-E <key=value,...> records every TLB miss, page walk, fault,
+		eviction, write back, readahead & copy-on-write trap with its
+		host timestamp into a ring of ring [65536] events per thread. A
+		drain thread copies the rings to file [binary, fixed size
+		events] while the run goes on, a full ring drops events rather
+		than stall the replay. types [tlb-miss:walk:fault:eviction:
+		writeback:prefetch:cow-trap] keeps only the listed ones, chrome
+		[path] converts the file to Chrome trace JSON for
+		ui.perfetto.dev once the run is over, as dist/export_events
+		does, i.e. -E file=data/events.bin,types=fault:eviction:
+		writeback,chrome=data/events.json. The payload & the
+		interactive prompt record into it as well.
 */
 
-int main()
+int main(int argc, char* argv[])
 {
 	/* Variables */
 	int is_running = 1;
+	char* trace_paths[MAX_PROCESSES];
+	int trace_generated[MAX_PROCESSES];
+	trace_t* traces[MAX_PROCESSES];
+	int trace_owned[MAX_PROCESSES];
+	int trace_count = 0;
+	int source_count = 0;
+	ullong_t random_seed = 0;
+	int va_bits = 0;
+	int pa_bits = 0;
+	ullong_t page_size = 0;
+	ullong_t memory_size = 0;
+	ullong_t disk_size = 0;
+	int process_count = 0;
+	int quantum = SCHEDULER_QUANTUM;
+	int page_table_type = PT_LINEAR;
+	char* snapshot_path = NULL;
+	char* checkpoint_path = NULL;
+	unsigned long checkpoint_at = 0;
+	char* restore_path = NULL;
+	snapshot_t* checkpoint = NULL;
+	char* sweep_specs[MAX_SWEEP_CONFIGS];
+	int sweep_count = 0;
+	int thread_count = 0;
+	char* curve_path = NULL;
+	unsigned long fork_at = 0;
+	int fork_children = 0;
+	char* fork_end;
+	unsigned long sample_interval = 0;
+	char* heatmap_path = NULL;
+	int use_swap_device = 0;
+	swap_device_config_t swap_config;
+	ullong_t zswap_size = 0;
+	unsigned long ksm_interval = 0;
+	ullong_t ksm_pages = KSM_PAGES_TO_SCAN;
+	char* ksm_end;
+	int use_numa = 0;
+	numa_config_t numa_config;
+	int use_cache = 0;
+	cache_config_t cache_config;
+	int use_reclaim = 0;
+	reclaim_config_t reclaim_config;
+	int use_metrics = 0;
+	metrics_config_t metrics_config;
+	int use_events = 0;
+	events_config_t events_config;
+	int option;
+	tlb_config_t tlb_config;
+	pager_config_t pager_config;
+
+	init_tlb_config(&tlb_config);
+	init_pager_config(&pager_config);
+	init_swap_device_config(&swap_config);
+	init_numa_config(&numa_config);
+	init_cache_config(&cache_config);
+	init_reclaim_config(&reclaim_config);
+	init_metrics_config(&metrics_config);
+	init_events_config(&events_config);
+
+	while ((option = getopt(argc, argv, "t:W:S:n:q:g:e:w:p:ar:f:V:P:s:m:d:H:o:C:R:x:j:M:F:K:I:Z:D:N:L:k:O:E:")) != -1)
+	{
+		switch (option)
+		{
+			case 't':
+			case 'W':
+				if (trace_count == MAX_PROCESSES)
+				{
+					printf("%s - At Most %d Traces Supported...\n", ERROR_PRINT_TAG, MAX_PROCESSES);
+					return 1;
+				}
+
+				trace_generated[trace_count] = (option == 'W');
+				trace_paths[trace_count++] = optarg;
+				break;
+			case 'S':
+				random_seed = strtoull(optarg, NULL, 0);
+				break;
+			case 'n':
+				process_count = atoi(optarg);
+
+				if (process_count > MAX_PROCESSES)
+					process_count = MAX_PROCESSES;
+				break;
+			case 'q':
+				quantum = atoi(optarg);
+				break;
+			case 'g':
+				page_table_type = parse_page_table_type(optarg);
+
+				if (page_table_type < 0)
+				{
+					printf("%s - Unknown Page Table Type: %s\n", ERROR_PRINT_TAG, optarg);
+					return 1;
+				}
+				break;
+			case 'e':
+				tlb_config.entry_count = atoi(optarg);
+				break;
+			case 'w':
+				tlb_config.ways = atoi(optarg);
+				break;
+			case 'p':
+				tlb_config.policy = parse_tlb_policy(optarg);
+
+				if (tlb_config.policy < 0)
+				{
+					printf("%s - Unknown TLB Policy: %s\n", ERROR_PRINT_TAG, optarg);
+					return 1;
+				}
+				break;
+			case 'a':
+				tlb_config.use_asid = 1;
+				break;
+			case 'r':
+				pager_config.policy = parse_replacement_policy(optarg);
+
+				if (pager_config.policy < 0)
+				{
+					printf("%s - Unknown Replacement Policy: %s\n", ERROR_PRINT_TAG, optarg);
+					return 1;
+				}
+				break;
+			case 'f':
+				pager_config.frame_limit = atoi(optarg);
+				break;
+			case 'V':
+				va_bits = atoi(optarg);
+				break;
+			case 'P':
+				pa_bits = atoi(optarg);
+				break;
+			case 's':
+				page_size = parse_size(optarg);
+				break;
+			case 'm':
+				memory_size = parse_size(optarg);
+				break;
+			case 'd':
+				disk_size = parse_size(optarg);
+				break;
+			case 'H':
+				pager_config.huge_order = atoi(optarg);
+				tlb_config.huge_order = pager_config.huge_order;
+				break;
+			case 'o':
+				snapshot_path = optarg;
+				break;
+			case 'C':
+				checkpoint_at = strtoul(optarg, &checkpoint_path, 0);
+
+				if (*checkpoint_path != ':' || checkpoint_path[1] == '\0')
+				{
+					printf("%s - Checkpoint Expects <accesses>:<file>...\n", ERROR_PRINT_TAG);
+					return 1;
+				}
+
+				checkpoint_path++;
+				break;
+			case 'R':
+				restore_path = optarg;
+				break;
+			case 'x':
+				if (sweep_count == MAX_SWEEP_CONFIGS)
+				{
+					printf("%s - At Most %d Sweep Configurations Supported...\n", ERROR_PRINT_TAG, MAX_SWEEP_CONFIGS);
+					return 1;
+				}
+
+				sweep_specs[sweep_count++] = optarg;
+				break;
+			case 'j':
+				thread_count = atoi(optarg);
+				break;
+			case 'M':
+				curve_path = optarg;
+				break;
+			case 'F':
+				fork_at = strtoul(optarg, &fork_end, 0);
+				fork_children = (*fork_end == ':') ? atoi(fork_end + 1) : 1;
+
+				if ((*fork_end != '\0' && *fork_end != ':') || fork_children <= 0)
+				{
+					printf("%s - Fork Expects <accesses>[:children]...\n", ERROR_PRINT_TAG);
+					return 1;
+				}
+				break;
+			case 'K':
+				sample_interval = strtoul(optarg, &heatmap_path, 0);
+
+				if (*heatmap_path != ':' || heatmap_path[1] == '\0' || sample_interval == 0)
+				{
+					printf("%s - Working Set Sampling Expects <interval>:<file>...\n", ERROR_PRINT_TAG);
+					return 1;
+				}
+
+				heatmap_path++;
+				break;
+			case 'I':
+				if (parse_swap_device_config(optarg, &swap_config) < 0)
+					return 1;
+
+				use_swap_device = 1;
+				break;
+			case 'Z':
+				zswap_size = parse_size(optarg);
+
+				if (zswap_size == 0)
+				{
+					printf("%s - Compressed Swap Expects A Pool Size...\n", ERROR_PRINT_TAG);
+					return 1;
+				}
+
+				break;
+			case 'D':
+				ksm_interval = strtoul(optarg, &ksm_end, 0);
+
+				if (*ksm_end == ':')
+					ksm_pages = strtoull(ksm_end + 1, &ksm_end, 0);
+
+				if (*ksm_end != '\0' || ksm_interval == 0 || ksm_pages == 0)
+				{
+					printf("%s - Deduplication Expects <interval>[:pages]...\n", ERROR_PRINT_TAG);
+					return 1;
+				}
+
+				break;
+			case 'N':
+				if (parse_numa_config(optarg, &numa_config) < 0)
+					return 1;
+
+				use_numa = 1;
+				break;
+			case 'L':
+				if (parse_cache_config(optarg, &cache_config) < 0)
+					return 1;
+
+				use_cache = 1;
+				break;
+			case 'k':
+				if (parse_reclaim_config(optarg, &reclaim_config) < 0)
+					return 1;
+
+				use_reclaim = 1;
+				break;
+			case 'O':
+				if (parse_metrics_config(optarg, &metrics_config) < 0)
+					return 1;
+
+				use_metrics = 1;
+				break;
+			case 'E':
+				if (parse_events_config(optarg, &events_config) < 0)
+					return 1;
+
+				use_events = 1;
+				break;
+			default:
+				printf("Usage: %s [-t trace_file]... [-W workload[:key=value,...]]... [-S seed] [-n processes] [-q quantum] [-g linear|radix-2|radix-4|inverted] [-e tlb_entries] [-w tlb_ways] [-p lru|fifo|random|clock] [-a]"
+					" [-r fifo|lru|clock|nru|optimal] [-f frames] [-V va_bits] [-P pa_bits] [-s page_size] [-m memory_size] [-d disk_size] [-H huge_order] [-o snapshot] [-C accesses:checkpoint] [-R checkpoint] [-x sweep_config]... [-j threads] [-M curve_file] [-F accesses[:children]] [-K interval:heatmap_file] [-I swap_device] [-Z pool_size] [-D interval[:pages]] [-N numa_config] [-L cache_config] [-k reclaim_config] [-O metrics_config] [-E event_config]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	/* Sweep configurations start from everything else on the command line, whatever the option order */
+	sweep_config_t sweep_configs[MAX_SWEEP_CONFIGS];
+
+	for (int i = 0; i < sweep_count; ++i)
+	{
+		sweep_configs[i].tlb 		= tlb_config;
+		sweep_configs[i].pager 		= pager_config;
+		sweep_configs[i].quantum 	= quantum;
+
+		if (parse_sweep_config(sweep_specs[i], &sweep_configs[i]) < 0)
+			return 1;
+	}
+
+	if (sweep_count > 0 && (trace_count == 0 || checkpoint_path || snapshot_path))
+	{
+		printf("%s - A Sweep Needs A Trace & Can't Save A Checkpoint Or Snapshot...\n", ERROR_PRINT_TAG);
+		return 1;
+	}
+
+	/* Sweep machines are a TLB, a pager & a scheduler, anything else would be left out without a word */
+	if (sweep_count > 0 && (use_swap_device || zswap_size || ksm_interval || use_numa || use_cache || use_reclaim || curve_path || sample_interval))
+	{
+		printf("%s - A Sweep Can't Be Combined With -I, -Z, -D, -N, -L, -k, -M Or -K...\n", ERROR_PRINT_TAG);
+		return 1;
+	}
+
+	/* Checkpoints don't record which frames are shared */
+	if (fork_children > 0 && (trace_count == 0 || sweep_count > 0 || checkpoint_path))
+	{
+		printf("%s - A Fork Needs A Trace & Can't Be Combined With A Sweep Or A Checkpoint...\n", ERROR_PRINT_TAG);
+		return 1;
+	}
+
+	/* Nor which frames were merged */
+	if (ksm_interval > 0 && (trace_count == 0 || checkpoint_path))
+	{
+		printf("%s - Deduplication Needs A Trace & Can't Be Combined With A Checkpoint...\n", ERROR_PRINT_TAG);
+		return 1;
+	}
+
+	/* A checkpoint brings its own geometry */
+	if (restore_path)
+	{
+		checkpoint = map_snapshot(restore_path);
+
+		if (!checkpoint || configure_snapshot_geometry(checkpoint, &geometry) < 0)
+			return 1;
+	}
+	else if (configure_geometry(&geometry, va_bits, pa_bits, page_size, memory_size, disk_size) < 0)
+	{
+		return 1;
+	}
+
+	int is_legacy = is_legacy_geometry(&geometry);
+
+	if (trace_count == 0 && !is_legacy)
+	{
+		printf("%s - Interactive Mode Needs The Default Geometry, Give A Trace With -t...\n", ERROR_PRINT_TAG);
+		return 1;
+	}
+
+	/* Traces are loaded once the address width they're checked against is known */
+	for (int i = 0; i < trace_count; ++i)
+	{
+		workload_config_t workload_config;
+
+		init_workload_config(&workload_config);
+
+		if (random_seed != 0)
+			workload_config.seed = random_seed;
+
+		if (!trace_generated[i])
+			traces[i] = load_trace_file(trace_paths[i]);
+		else if (parse_workload(trace_paths[i], &workload_config) == 0)
+			traces[i] = create_workload_trace(&workload_config);
+		else
+			traces[i] = NULL;
+
+		if (!traces[i])
+			return 1;
+
+		trace_owned[i] = 1;
+	}
+
+	int wants_optimal = (pager_config.policy == PR_OPTIMAL);
+
+	for (int i = 0; i < sweep_count; ++i)
+		wants_optimal |= (sweep_configs[i].pager.policy == PR_OPTIMAL);
+
+	if (wants_optimal)
+	{
+		for (int i = 0; i < trace_count; ++i)
+		{
+			if (traces[i]->workload)
+			{
+				printf("%s - OPTIMAL Replacement Needs Trace Files, Not Generated Workloads...\n", ERROR_PRINT_TAG);
+				return 1;
+			}
+		}
+	}
+
+	/* A generated or binary stream has one read position, so every extra process gets its own copy [Generated ones reseeded] */
+	source_count = trace_count;
+
+	for (int pid = source_count; source_count > 0 && pid < process_count; ++pid)
+	{
+		traces[pid] = traces[pid % source_count];
+		trace_owned[pid] = (traces[pid]->workload || traces[pid]->binary);
+
+		if (traces[pid]->workload)
+		{
+			workload_config_t workload_config = traces[pid]->workload->config;
+			workload_config.seed += pid;
+
+			traces[pid] = create_workload_trace(&workload_config);
+
+			if (!traces[pid])
+				return 1;
+		}
+		else if (traces[pid]->binary && !(traces[pid] = reopen_trace(traces[pid])))
+		{
+			return 1;
+		}
+
+		trace_count = pid + 1;
+	}
 
 	/* Enable digit padding. i.e. 100000 => 100,000 */
 	setlocale(LC_NUMERIC, "");
 
-	char* PHYSICAL_MEMORY_FILE_PATH = strcat(get_current_working_directory(), "/data/physical_memory.txt");
-	char* DISK_MEMORY_FILE_PATH = strcat(get_current_working_directory(), "/data/disk_memory.txt");
-	char* PAGE_TABLE_FILE_PATH = strcat(get_current_working_directory(), "/data/page_table.txt");
+	/* Events are recorded from the payload on, whatever the mode */
+	if (use_events && (!(events = create_events(&events_config)) || start_events_drain(events) < 0))
+		return 1;
+
+	/*================================= Sweep Mode =================================*/
+	if (sweep_count > 0)
+	{
+		sweep_result_t sweep_results[MAX_SWEEP_CONFIGS];
+		sweep_t sweep;
+
+		memset(&sweep, 0, sizeof(sweep_t));
+		memset(sweep_results, 0, sizeof(sweep_results));
+
+		sweep.configs 			= sweep_configs;
+		sweep.results 			= sweep_results;
+		sweep.count 			= sweep_count;
+		sweep.threads 			= thread_count;
+		sweep.traces 			= traces;
+		sweep.trace_count 		= trace_count;
+		sweep.process_count 	= (process_count > trace_count) ? process_count : trace_count;
+		sweep.page_table_type 	= page_table_type;
+		sweep.checkpoint 		= checkpoint;
+
+		print_geometry(&geometry);
+
+		if (use_metrics && start_metrics_export(metrics = create_metrics(&metrics_config)) < 0)
+			return 1;
+
+		run_sweep(&sweep);
+		print_sweep_report(&sweep);
+
+		if (metrics)
+		{
+			stop_metrics_export(metrics);
+			print_metrics_stats(metrics);
+		}
+
+		if (events)
+		{
+			stop_events_drain(events);
+			print_events_stats(events);
+		}
+
+		unmap_snapshot(checkpoint);
+		free_metrics(metrics);
+		free_events(events);
+
+		for (int i = 0; i < trace_count; ++i)
+		{
+			if (i < source_count || traces[i]->workload || traces[i]->binary)
+				free_trace(traces[i]);
+		}
+
+		return 0;
+	}
+
+	char* SNAPSHOT_FILE_PATH = strcat(get_current_working_directory(), "/data/snapshot.bin");
 
 	/*=============================== Initialization ===============================*/
-	clear_console();												/* Clear console depending on operating system */
-	init_random_seed();												/* Initialize random seed */
-	char *physical_memory 	= malloc(PHYSICAL_MEMORY_SIZE);			/* 16-bit address space */
-	char *disk_memory 		= malloc(DISK_MEMORY_SIZE);				/* Simulation of DISK memory */
+	if (trace_count == 0)
+		clear_console();											/* Clear console depending on operating system */
+	init_random_seed(random_seed);										/* Initialize random seed [-S, 0 => Time of day] */
+	char *physical_memory 	= allocate_simulated_memory(geometry.physical_memory_size);	/* 16-bit address space by default */
+	char *disk_memory 		= swap_config.file_path											/* Simulation of DISK memory [Or a real swap file] */
+		? map_swap_file(swap_config.file_path, geometry.disk_memory_size) : allocate_simulated_memory(geometry.disk_memory_size);
+
+	if (!physical_memory || !disk_memory)
+		return 1;
+
+	if (is_legacy && !checkpoint)
+	{
+		/*=============================== Random Selection =============================*/
+		int random_payload_size = get_random_payload_size();			/* Random size of payload */
+		int random_frame 		= get_random_physical_frame();			/* Retrieve a random frame [Excluding first 2 frames - Page Table] */
+		int physical_address = frame_to_physical_address(random_frame);	/* Convert random frame to physical address */
+		init_page_table_entries(physical_memory);						/* Initialize page table entries */
+		init_disk_entries(disk_memory);									/* Initialize disk memory block */
+
+		/*================================= Debugging ==================================*/
+		print_mem_config(random_payload_size, random_frame);			/* Print initialized values */
+
+		/*=================================== Core =====================================*/
+		write_random_payload(physical_memory, disk_memory, random_payload_size, physical_address);
+
+		print_page_table_entry(physical_memory, 0);
+	}
+	else
+	{
+		print_geometry(&geometry);
+	}
+
+	/*=================================== Paging ===================================*/
+	tlb_t* tlb = NULL;
+	pager_t* pager = NULL;
+	scheduler_t* scheduler = NULL;
+
+	if (checkpoint)
+	{
+		/* Warm start: Memory, tables & every process come from the checkpoint */
+		scheduler = restore_checkpoint(checkpoint, &pager_config, (tlb_config.entry_count > 0) ? &tlb_config : NULL, quantum,
+			traces, trace_count, physical_memory, disk_memory);
+		unmap_snapshot(checkpoint);
+
+		if (!scheduler)
+			return 1;
+
+		tlb 	= scheduler->tlb;
+		pager 	= scheduler->pager;
+	}
+	else
+	{
+		tlb 		= (trace_count > 0 && tlb_config.entry_count > 0) ? create_tlb(&tlb_config) : NULL;
+		pager 		= create_pager(&pager_config, physical_memory, disk_memory, tlb);
+		scheduler 	= create_scheduler(pager, tlb, quantum);
+	}
+
+	if (trace_count > 0 && tlb_config.entry_count > 0 && !tlb)
+		return 1;
+
+	if (pager && use_swap_device)
+		pager->swap = create_swap_device(&swap_config);
+
+	if (pager && zswap_size && !(pager->zswap = create_zswap(zswap_size, disk_memory, pager->swap)))
+		return 1;
+
+	if (pager && ksm_interval)
+		pager->ksm = create_ksm(ksm_interval, ksm_pages);
+
+	if (pager && use_numa && !(pager->numa = create_numa(&numa_config)))
+		return 1;
+
+	if (pager && use_cache)
+		pager->cache = create_cache(&cache_config);
 
-	/*=============================== Random Selection =============================*/
-	int random_payload_size = get_random_payload_size();			/* Random size of payload */
-	int random_frame 		= get_random_physical_frame();			/* Retrieve a random frame [Excluding first 2 frames - Page Table] */
-	int physical_address = frame_to_physical_address(random_frame);	/* Convert random frame to physical address */
-	init_page_table_entries(physical_memory);						/* Initialize page table entries */
-	init_disk_entries(disk_memory);									/* Initialize disk memory block */
+	if (pager && use_reclaim && !(pager->reclaim = create_reclaim(&reclaim_config, pager->config.frame_limit)))
+		return 1;
 
-	/*================================= Debugging ==================================*/
-	print_mem_config(random_payload_size, random_frame);			/* Print initialized values */
+	/* A restored run is past the first interval already, the reclaimer goes on from the checkpoint */
+	if (pager && pager->reclaim)
+		pager->reclaim->next_run = scheduler->replayed + pager->reclaim->config.interval;
 
-	/*=================================== Core =====================================*/
-	write_random_payload(physical_memory, disk_memory, random_payload_size, physical_address);
+	if (process_count < trace_count)
+		process_count = trace_count;
 
-	write_physical_memory_to_file(physical_memory, PHYSICAL_MEMORY_FILE_PATH);
-	write_disk_memory_to_file (disk_memory, DISK_MEMORY_FILE_PATH);
-	write_page_table_to_file(physical_memory, PAGE_TABLE_FILE_PATH);
+	if (process_count == 0)
+		process_count = 1;
 
-	print_page_table_entry(physical_memory, 0);
+	/* Interactive lookups read the linear table in frames 0-1 directly */
+	if (trace_count == 0)
+		page_table_type = PT_LINEAR;
 
-	while(is_running == 1)
+	/* Process 0 adopts the payload & the page table in frames 0-1, the rest start empty */
+	for (int pid = 0; pager && !restore_path && pid < process_count; ++pid)
+	{
+		process_t* process = create_process(pid, trace_count > 0 ? traces[pid % trace_count] : NULL);
+
+		if (pid == 0 && is_legacy)
+			pager_adopt_linear_table(pager, process, page_table_type, 0);
+		else
+			process->page_table = create_page_table(page_table_type, pager, pid);
+
+		if (!process->page_table)
+		{
+			free_process(process);
+			return 1;
+		}
+
+		pager_prepare_optimal(pager, process);
+		scheduler_add_process(scheduler, process);
+	}
+
+	/* Payload & adopted page table before anything runs [Render with dist/render_snapshot] */
+	if (is_legacy && pager && !restore_path)
+		write_snapshot(SNAPSHOT_FILE_PATH, pager, scheduler->processes, scheduler->process_count, NULL, 0);
+
+	/*================================= Batch Mode =================================*/
+	if (trace_count > 0)
+	{
+		scheduler->checkpoint_at 	= checkpoint_at;
+		scheduler->checkpoint_path 	= checkpoint_path;
+		scheduler->stack_distance 	= curve_path ? create_stack_distance(!tlb_config.use_asid) : NULL;
+		scheduler->fork_at 			= fork_at;
+		scheduler->fork_children 	= fork_children;
+		scheduler->working_set 		= sample_interval ? create_working_set(sample_interval, heatmap_path) : NULL;
+
+		if (sample_interval && !scheduler->working_set)
+			return 1;
+
+		if (use_metrics && start_metrics_export(metrics = create_metrics(&metrics_config)) < 0)
+			return 1;
+
+		run_scheduler(scheduler);
+
+		if (metrics)
+			stop_metrics_export(metrics);
+
+		if (scheduler->checkpoint_path)
+			printf("%s - Traces Ended Before The Checkpoint At %'lu Accesses...\n", ERROR_PRINT_TAG, checkpoint_at);
+
+		print_scheduler_stats(scheduler);
+
+		if (tlb)
+			print_tlb_stats(tlb);
+
+		if (pager)
+			print_pager_stats(pager);
+
+		if (pager && pager->reclaim)
+			print_reclaim_stats(pager->reclaim);
+
+		if (pager && pager->zswap)
+			print_zswap_stats(pager->zswap);
+
+		if (pager && pager->ksm)
+			print_ksm_stats(pager->ksm);
+
+		if (pager && pager->numa)
+			print_numa_stats(pager->numa, pager->frames);
+
+		if (pager && pager->cache)
+			print_cache_stats(pager->cache);
+
+		if (pager && pager->swap)
+		{
+			swap_device_drain(pager->swap);
+			print_swap_device_stats(pager->swap);
+		}
+
+		if (scheduler->stack_distance)
+		{
+			print_miss_ratio_curve(scheduler->stack_distance);
+			write_miss_ratio_curve(curve_path, scheduler->stack_distance);
+			free_stack_distance(scheduler->stack_distance);
+		}
+
+		if (scheduler->working_set)
+		{
+			print_working_set_stats(scheduler->working_set);
+			free_working_set(scheduler->working_set);
+			printf("%s - Working Set Heatmap Written To: %s\n", FILEIO_PRINT_TAG, heatmap_path);
+		}
+
+		if (metrics)
+			print_metrics_stats(metrics);
+
+		is_running = 0;
+	}
+
+	while(is_running == 1 && scheduler->process_count > 0)
 	{
 		unsigned short input_address;
 
 		printf("Enter a Virtual Page Number [Enter any Hex between 0x0000 -> 0xFFFF]:\n");
-		scanf("%hX", &input_address);
+		if (scanf("%hX", &input_address) != 1)
+			break;
+
 		printf("\n");
-		
+
+		/* Interactive lookups fault pages in the same way as a replay */
+		pager_handle_fault(pager, scheduler->processes[0], input_address >> BIT_SHIFT_BY, 0);
+
 		print_physical_frame_contents (physical_memory, input_address);
 	}
-	
+
+	if (events)
+	{
+		stop_events_drain(events);
+		print_events_stats(events);
+	}
+
+	if (snapshot_path)
+		write_snapshot(snapshot_path, pager, scheduler->processes, scheduler->process_count, NULL, 0);
+
 	/*============================== Garbage Collect ===============================*/
 	// Free memory from heap
-	free(PAGE_TABLE_FILE_PATH);
-	free(DISK_MEMORY_FILE_PATH);
-	free(PHYSICAL_MEMORY_FILE_PATH);
-	free(disk_memory);
-	free(physical_memory);
+	free_scheduler(scheduler);
+
+	if (pager)
+	{
+		free_zswap(pager->zswap);
+		free_ksm(pager->ksm);
+		free_numa(pager->numa);
+		free_cache(pager->cache);
+		free_reclaim(pager->reclaim);
+		free_swap_device(pager->swap);
+	}
+
+	free_pager(pager);
+	free_tlb(tlb);
+	free_metrics(metrics);
+	free_events(events);
+
+	/* Past the given sources only the reseeded streams & reopened binary traces are owned, the rest share a trace file */
+	for (int i = 0; i < trace_count; ++i)
+	{
+		if (trace_owned[i])
+			free_trace(traces[i]);
+	}
+
+	free(SNAPSHOT_FILE_PATH);
+	free_simulated_memory(disk_memory, geometry.disk_memory_size);
+	free_simulated_memory(physical_memory, geometry.physical_memory_size);
 
 	return 0;
 }
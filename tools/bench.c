@@ -0,0 +1,497 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <time.h>
+#include "../lib/utils.h"
+#include "../lib/geometry.h"
+#include "../lib/trace.h"
+#include "../lib/workload.h"
+#include "../lib/tlb.h"
+#include "../lib/page_table.h"
+#include "../lib/process.h"
+#include "../lib/paging.h"
+#include "../lib/scheduler.h"
+#include "../lib/snapshot.h"
+#include "../lib/constants.h"
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <getopt.h>
+#endif
+
+/*
+	Micro-benchmarks for the translation & paging hot paths:
+
+		./bench [-n accesses] [-s seed] [-j] [-o file]
+
+	Every address-space geometry below is run with every access pattern
+	[sequential, strided, uniform & zipf] through:
+
+		translate	Page table walk only, every page resident
+		replay		run_process() with a 64 entry TLB, every page resident
+		fault		pager_handle_fault() with half the footprint in frames
+		alloc		pager_allocate_table_frames() one frame at a time
+		snapshot	write_snapshot() of the resident machine
+
+	Batched benchmarks time BENCH_BATCH accesses at once, fault & alloc
+	time each call. Median & p99 are taken over those samples in ns per
+	operation and written as CSV [or JSON with -j], one row per case, so
+	two builds can be diffed. Without -o the rows go to stdout and the
+	simulator's own messages to stderr.
+*/
+
+#define BENCH_BATCH			1024
+#define BENCH_FOOTPRINT		4096		/* Most distinct pages a pattern touches */
+#define BENCH_TLB_ENTRIES	64
+#define BENCH_SNAPSHOTS		7
+
+typedef struct bench_geometry
+{
+	const char* 	name;
+	int				va_bits;
+	int				pa_bits;
+	ullong_t		page_size;
+	ullong_t		memory_size;
+	int				table_type;
+} bench_geometry_t;
+
+typedef struct bench_result
+{
+	const char* 	benchmark;
+	const char* 	geometry;
+	const char* 	table;
+	const char* 	pattern;
+	unsigned long	samples;
+	double			median_ns;
+	double			p99_ns;
+	double			ops_per_sec;
+	double			mib_per_sec;
+} bench_result_t;
+
+static bench_geometry_t BENCH_GEOMETRIES[] =
+{
+	{ "16/256", 16, 16, 256, 0, PT_LINEAR },
+	{ "32/4K", 32, 32, 4096, 268435456, PT_LINEAR },
+	{ "48/4K", 48, 40, 4096, 268435456, PT_RADIX_4 },
+	{ "48/4K", 48, 40, 4096, 268435456, PT_INVERTED },
+};
+
+static const char* PATTERN_NAMES[] = { "sequential", "strided", "uniform", "zipf" };
+static const int PATTERN_WORKLOADS[] = { WL_SEQUENTIAL, WL_STRIDED, WL_UNIFORM, WL_ZIPF };
+
+static FILE* output;
+static int as_json;
+static int result_count;
+static ullong_t seed;
+
+/*================================== PATTERNS ==================================*/
+/* Generated up front so the timed loops only pay for the simulator */
+static trace_t* build_pattern (int pattern, ullong_t footprint, unsigned long length)
+{
+	workload_config_t config;
+
+	init_workload_config(&config);
+	config.pattern 	= PATTERN_WORKLOADS[pattern];
+	config.seed 	= seed;
+	config.length 	= length;
+	config.pages 	= footprint;
+	config.stride 	= 7 * geometry.page_size;	/* Odd page stride visits every page of the footprint before repeating */
+
+	workload_t* workload = create_workload(&config);
+
+	trace_t* trace = calloc(1, sizeof(trace_t));
+	trace->entries = malloc(length * sizeof(trace_entry_t));
+	trace->length = length;
+	trace->capacity = length;
+
+	workload_next(workload, trace->entries, length);
+	free_workload(workload);
+
+	return trace;
+}
+
+/*================================== RESULTS ===================================*/
+static int compare_samples (const void* a, const void* b)
+{
+	double left = *(const double*) a;
+	double right = *(const double*) b;
+
+	return (left > right) - (left < right);
+}
+
+static void report (bench_result_t* result, double* samples, unsigned long count, double total_ops, double total_seconds)
+{
+	result->samples = count;
+
+	if (count > 0)
+	{
+		qsort(samples, count, sizeof(double), compare_samples);
+		result->median_ns = samples[count / 2];
+		result->p99_ns = samples[(count * 99) / 100 < count ? (count * 99) / 100 : count - 1];
+	}
+
+	result->ops_per_sec = (total_seconds > 0) ? total_ops / total_seconds : 0;
+
+	if (as_json)
+	{
+		fprintf(output, "%s\n\t{ \"benchmark\": \"%s\", \"geometry\": \"%s\", \"table\": \"%s\", \"pattern\": \"%s\", \"samples\": %lu,"
+			" \"median_ns\": %.2f, \"p99_ns\": %.2f, \"ops_per_sec\": %.0f, \"mib_per_sec\": %.2f }",
+			(result_count > 0) ? "," : "", result->benchmark, result->geometry, result->table, result->pattern, result->samples,
+			result->median_ns, result->p99_ns, result->ops_per_sec, result->mib_per_sec);
+	}
+	else
+	{
+		fprintf(output, "%s,%s,%s,%s,%lu,%.2f,%.2f,%.0f,%.2f\n", result->benchmark, result->geometry, result->table, result->pattern,
+			result->samples, result->median_ns, result->p99_ns, result->ops_per_sec, result->mib_per_sec);
+	}
+
+	fflush(output);
+	result_count++;
+}
+
+static inline double elapsed_ns (struct timespec* start, struct timespec* end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+/*================================== MACHINE ===================================*/
+/* One pager, TLB & process per case, so no case inherits another's warm state */
+typedef struct bench_machine
+{
+	char* 			physical_memory;
+	char* 			disk_memory;
+	tlb_t* 			tlb;
+	pager_t* 		pager;
+	scheduler_t* 	scheduler;
+	process_t* 		process;
+} bench_machine_t;
+
+static int create_machine (bench_machine_t* machine, bench_geometry_t* config, int frame_limit, int with_tlb, trace_t* trace)
+{
+	pager_config_t pager_config;
+	tlb_config_t tlb_config;
+
+	init_pager_config(&pager_config);
+	init_tlb_config(&tlb_config);
+	pager_config.frame_limit = frame_limit;
+	tlb_config.entry_count = BENCH_TLB_ENTRIES;
+
+	memset(machine, 0x00, sizeof(bench_machine_t));
+	machine->physical_memory 	= allocate_simulated_memory(geometry.physical_memory_size);
+	machine->disk_memory 		= allocate_simulated_memory(geometry.disk_memory_size);
+
+	if (!machine->physical_memory || !machine->disk_memory)
+		return -1;
+
+	machine->tlb 		= with_tlb ? create_tlb(&tlb_config) : NULL;
+	machine->pager 		= create_pager(&pager_config, machine->physical_memory, machine->disk_memory, machine->tlb);
+
+	if (!machine->pager)
+		return -1;
+
+	machine->scheduler 	= create_scheduler(machine->pager, machine->tlb, SCHEDULER_QUANTUM);
+	machine->process 	= create_process(0, trace);
+	scheduler_add_process(machine->scheduler, machine->process);
+
+	machine->process->page_table = create_page_table(config->table_type, machine->pager, 0);
+
+	return machine->process->page_table ? 0 : -1;
+}
+
+static void free_machine (bench_machine_t* machine)
+{
+	free_scheduler(machine->scheduler);
+	free_pager(machine->pager);
+	free_tlb(machine->tlb);
+	free_simulated_memory(machine->disk_memory, geometry.disk_memory_size);
+	free_simulated_memory(machine->physical_memory, geometry.physical_memory_size);
+}
+
+/* Fault in every page of the footprint so lookups never leave the table */
+static void make_resident (bench_machine_t* machine, ullong_t footprint)
+{
+	for (ullong_t page = 0; page < footprint; ++page)
+		pager_handle_fault(machine->pager, machine->process, page, 0);
+}
+
+/*================================= BENCHMARKS =================================*/
+static void bench_translate (bench_result_t* result, bench_machine_t* machine, trace_t* trace)
+{
+	page_table_t* page_table = machine->process->page_table;
+	unsigned long batches = trace->length / BENCH_BATCH;
+	double* samples = malloc(batches * sizeof(double));
+	double total = 0;
+	ullong_t checksum = 0;
+	translation_t translation;
+	struct timespec start, end;
+
+	for (unsigned long batch = 0; batch < batches; ++batch)
+	{
+		trace_entry_t* entries = &trace->entries[batch * BENCH_BATCH];
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for (int i = 0; i < BENCH_BATCH; ++i)
+		{
+			page_table_translate(page_table, entries[i].address, entries[i].is_write, &translation);
+			checksum += translation.physical_address;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		samples[batch] = elapsed_ns(&start, &end) / BENCH_BATCH;
+		total += elapsed_ns(&start, &end);
+	}
+
+	/* Keeps the walk from being optimised away */
+	if (checksum == 1)
+		fprintf(stderr, "%llu\n", checksum);
+
+	report(result, samples, batches, (double) batches * BENCH_BATCH, total / 1e9);
+	free(samples);
+}
+
+static void bench_replay (bench_result_t* result, bench_machine_t* machine, trace_t* trace)
+{
+	unsigned long batches = trace->length / BENCH_BATCH;
+	double* samples = malloc(batches * sizeof(double));
+	double total = 0;
+	struct timespec start, end;
+
+	machine->process->position = 0;
+	tlb_context_switch(machine->tlb, machine->process->pid);
+
+	for (unsigned long batch = 0; batch < batches; ++batch)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		run_process(machine->scheduler, machine->process, BENCH_BATCH);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		samples[batch] = elapsed_ns(&start, &end) / BENCH_BATCH;
+		total += elapsed_ns(&start, &end);
+	}
+
+	report(result, samples, batches, (double) batches * BENCH_BATCH, total / 1e9);
+	free(samples);
+}
+
+/* Every fault is timed on its own [Includes ~20ns of clock overhead] */
+static void bench_fault (bench_result_t* result, bench_machine_t* machine, trace_t* trace)
+{
+	page_table_t* page_table = machine->process->page_table;
+	double* samples = malloc(trace->length * sizeof(double));
+	unsigned long count = 0;
+	double total = 0;
+	translation_t translation;
+	struct timespec start, end;
+
+	for (unsigned long i = 0; i < trace->length; ++i)
+	{
+		machine->process->position = i;
+
+		if (page_table_translate(page_table, trace->entries[i].address, trace->entries[i].is_write, &translation) == T_MAPPED)
+			continue;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		pager_handle_fault(machine->pager, machine->process, translation.virtual_page_number, trace->entries[i].is_write);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		/* The access that faulted still sets C_ACCESSED & C_DIRTY for replacement */
+		page_table_translate(page_table, trace->entries[i].address, trace->entries[i].is_write, &translation);
+
+		samples[count++] = elapsed_ns(&start, &end);
+		total += elapsed_ns(&start, &end);
+	}
+
+	report(result, samples, count, count, total / 1e9);
+	free(samples);
+}
+
+/* Carve the free frames one at a time, then hand them all back */
+static void bench_alloc (bench_result_t* result, bench_machine_t* machine, ullong_t count)
+{
+	long long* frames = malloc(count * sizeof(long long));
+	double* samples = malloc(count * sizeof(double));
+	double total = 0;
+	struct timespec start, end;
+
+	for (ullong_t i = 0; i < count; ++i)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		frames[i] = pager_allocate_table_frames(machine->pager, 1);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		samples[i] = elapsed_ns(&start, &end);
+		total += elapsed_ns(&start, &end);
+	}
+
+	for (ullong_t i = 0; i < count; ++i)
+	{
+		if (frames[i] >= 0)
+			pager_release_frames(machine->pager, frames[i] >> geometry.page_shift, 1);
+	}
+
+	report(result, samples, count, count, total / 1e9);
+	free(samples);
+	free(frames);
+}
+
+static void bench_snapshot (bench_result_t* result, bench_machine_t* machine, const char* file_path)
+{
+	double samples[BENCH_SNAPSHOTS];
+	double total = 0;
+	ullong_t bytes = geometry.physical_memory_size + geometry.disk_memory_size;
+	struct timespec start, end;
+
+	for (int i = 0; i < BENCH_SNAPSHOTS; ++i)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		write_snapshot(file_path, machine->pager, &machine->process, 1, NULL, 0);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		samples[i] = elapsed_ns(&start, &end);
+		total += elapsed_ns(&start, &end);
+	}
+
+	remove(file_path);
+
+	result->mib_per_sec = (total > 0) ? (bytes * (double) BENCH_SNAPSHOTS / 1048576.0) / (total / 1e9) : 0;
+	report(result, samples, BENCH_SNAPSHOTS, BENCH_SNAPSHOTS, total / 1e9);
+}
+
+/*==================================== MAIN ====================================*/
+static void run_geometry (bench_geometry_t* config, unsigned long accesses, const char* snapshot_path)
+{
+	if (configure_geometry(&geometry, config->va_bits, config->pa_bits, config->page_size, config->memory_size, 0) < 0)
+	{
+		fprintf(stderr, "%s - Skipping Geometry %s...\n", ERROR_PRINT_TAG, config->name);
+		return;
+	}
+
+	ullong_t footprint = BENCH_FOOTPRINT;
+
+	if (footprint > geometry.virtual_page_count)
+		footprint = geometry.virtual_page_count;
+
+	if (footprint > geometry.frame_count / 2)
+		footprint = geometry.frame_count / 2;
+
+	const char* table = get_page_table_name(config->table_type);
+	bench_machine_t machine;
+
+	for (int pattern = 0; pattern < (int) (sizeof(PATTERN_NAMES) / sizeof(PATTERN_NAMES[0])); ++pattern)
+	{
+		trace_t* trace = build_pattern(pattern, footprint, accesses);
+		bench_result_t result = { NULL, config->name, table, PATTERN_NAMES[pattern], 0, 0, 0, 0, 0 };
+
+		if (create_machine(&machine, config, 0, 1, trace) == 0)
+		{
+			make_resident(&machine, footprint);
+
+			result.benchmark = "translate";
+			bench_translate(&result, &machine, trace);
+
+			result.benchmark = "replay";
+			bench_replay(&result, &machine, trace);
+		}
+
+		free_machine(&machine);
+
+		if (create_machine(&machine, config, footprint / 2, 0, trace) == 0)
+		{
+			result.benchmark = "fault";
+			bench_fault(&result, &machine, trace);
+		}
+
+		free_machine(&machine);
+		free_trace(trace);
+	}
+
+	/* Neither depends on the access pattern */
+	bench_result_t result = { NULL, config->name, table, "-", 0, 0, 0, 0, 0 };
+
+	if (create_machine(&machine, config, 0, 0, NULL) == 0)
+	{
+		result.benchmark = "alloc";
+		bench_alloc(&result, &machine, footprint);
+
+		make_resident(&machine, footprint);
+
+		result.benchmark = "snapshot";
+		bench_snapshot(&result, &machine, snapshot_path);
+	}
+
+	free_machine(&machine);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned long accesses = 1 << 20;
+	const char* output_path = NULL;
+	int option;
+
+	seed = 1;
+
+	while ((option = getopt(argc, argv, "n:s:jo:")) != -1)
+	{
+		switch (option)
+		{
+			case 'n':
+				accesses = strtoul(optarg, NULL, 0);
+				break;
+			case 's':
+				seed = strtoull(optarg, NULL, 0);
+				break;
+			case 'j':
+				as_json = 1;
+				break;
+			case 'o':
+				output_path = optarg;
+				break;
+			default:
+				printf("Usage: %s [-n accesses] [-s seed] [-j] [-o file]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (accesses < BENCH_BATCH)
+		accesses = BENCH_BATCH;
+
+	if (output_path)
+	{
+		output = fopen(output_path, "w");
+
+		if (!output)
+		{
+			printf("%s - Failed To Open %s...\n", ERROR_PRINT_TAG, output_path);
+			return 1;
+		}
+	}
+	else
+	{
+		/* Results keep stdout, everything the simulator prints moves to stderr */
+		output = fdopen(dup(STDOUT_FILENO), "w");
+		dup2(STDERR_FILENO, STDOUT_FILENO);
+	}
+
+	setlocale(LC_NUMERIC, "");
+
+	if (as_json)
+		fprintf(output, "[");
+	else
+		fprintf(output, "benchmark,geometry,table,pattern,samples,median_ns,p99_ns,ops_per_sec,mib_per_sec\n");
+
+	char snapshot_path[64];
+	snprintf(snapshot_path, sizeof(snapshot_path), "bench_snapshot_%d.bin", (int) getpid());
+
+	for (int i = 0; i < (int) (sizeof(BENCH_GEOMETRIES) / sizeof(BENCH_GEOMETRIES[0])); ++i)
+		run_geometry(&BENCH_GEOMETRIES[i], accesses, snapshot_path);
+
+	if (as_json)
+		fprintf(output, "\n]\n");
+
+	fclose(output);
+
+	return 0;
+}
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <locale.h>
+#include "../lib/utils.h"
+#include "../lib/trace.h"
+#include "../lib/binary_trace.h"
+#include "../lib/constants.h"
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <getopt.h>
+#endif
+
+/*
+	Converts text traces into the simulator's binary trace format & back:
+
+		./convert_trace [-f text|lackey|perf] [-b block_entries] [-V va_bits] <input> <output>
+
+	text	The simulator's own "<hex address> [R|W]" lines
+	lackey	valgrind --tool=lackey --trace-mem=yes output, I & L are reads,
+			S & M [modify] are writes, the access size is kept
+	perf	perf mem report -D output, the ADDR column is the access & the
+			DSRC column's memory op tells loads from stores
+
+	-V drops the accesses that don't fit va_bits [i.e. kernel addresses
+	in a perf dump] instead of leaving the simulator to reject the trace.
+	A binary input is decoded back to text lines, "-" writes them to stdout.
+*/
+
+#define LINE_LENGTH			512
+#define PERF_MEM_OP_STORE	0x04		/* PERF_MEM_OP_STORE in the data source's low bits */
+
+enum trace_input { INPUT_TEXT, INPUT_LACKEY, INPUT_PERF };
+
+typedef struct access
+{
+	vaddr_t		address;
+	uchar_t		is_write;
+	uint_t		size;					/* Bytes, 0 => Unknown */
+} access_t;
+
+/* <hex address> [R|W] */
+static int parse_text_line (char* line, access_t* access)
+{
+	char* end;
+
+	if (*line == '\0' || *line == '#')
+		return 0;
+
+	access->address = strtoull(line, &end, 16);
+	access->size = 0;
+
+	if (end == line)
+		return -1;
+
+	while (isspace((unsigned char) *end))
+		end++;
+
+	access->is_write = (*end == 'W' || *end == 'w') ? 1 : 0;
+
+	return 1;
+}
+
+/* "I  0023C790,2", " S BE80199C,4" ... & valgrind's own "==pid==" messages */
+static int parse_lackey_line (char* line, access_t* access)
+{
+	char operation = *line;
+	char* end;
+
+	if (operation != 'I' && operation != 'L' && operation != 'S' && operation != 'M')
+		return (*line == '\0' || *line == '=') ? 0 : -1;
+
+	line++;
+
+	while (isspace((unsigned char) *line))
+		line++;
+
+	access->address = strtoull(line, &end, 16);
+
+	if (end == line || *end != ',')
+		return -1;
+
+	access->size = strtoul(end + 1, NULL, 10);
+	access->is_write = (operation == 'S' || operation == 'M') ? 1 : 0;
+
+	return 1;
+}
+
+/*
+	PID TID IP ADDR [PHYS ADDR] LOCAL WEIGHT DSRC SYMBOL, separated by
+	spaces or commas depending on the perf version. The weight is the
+	first plain number after ADDR & the data source follows it.
+*/
+static int parse_perf_line (char* line, access_t* access)
+{
+	char* fields[8];
+	int count = 0;
+
+	if (*line == '\0' || *line == '#')
+		return 0;
+
+	for (char* field = strtok(line, " \t,"); field && count < 8; field = strtok(NULL, " \t,"))
+		fields[count++] = field;
+
+	if (count < 6 || strncmp(fields[3], "0x", 2) != 0)
+		return -1;
+
+	access->address = strtoull(fields[3], NULL, 16);
+	access->size = 0;
+
+	for (int i = 4; i + 1 < count; ++i)
+	{
+		if (strncmp(fields[i], "0x", 2) == 0)
+			continue;
+
+		access->is_write = (strtoull(fields[i + 1], NULL, 16) & PERF_MEM_OP_STORE) ? 1 : 0;
+
+		return 1;
+	}
+
+	return -1;
+}
+
+static int encode_trace (FILE* input, int format, const char* output_path, uint_t block_entries, int va_bits)
+{
+	binary_trace_writer_t* writer = create_binary_trace_writer(output_path, block_entries);
+
+	if (!writer)
+		return 1;
+
+	char line[LINE_LENGTH];
+	unsigned long line_number = 0;
+	unsigned long skipped = 0;
+	unsigned long dropped = 0;
+	access_t access;
+
+	while (fgets(line, sizeof(line), input) != NULL)
+	{
+		char* cursor = line;
+		int result;
+
+		line_number++;
+
+		/* Lackey's data accesses are indented by one space, instruction fetches aren't */
+		while (isspace((unsigned char) *cursor))
+			cursor++;
+
+		cursor[strcspn(cursor, "\r\n")] = '\0';
+
+		switch (format)
+		{
+			case INPUT_LACKEY: 	result = parse_lackey_line(cursor, &access); break;
+			case INPUT_PERF: 	result = parse_perf_line(cursor, &access); break;
+			default: 			result = parse_text_line(cursor, &access); break;
+		}
+
+		if (result < 0)
+		{
+			if (skipped++ < 10)
+				printf("%s - Skipped Line %lu: %s\n", ERROR_PRINT_TAG, line_number, line);
+
+			continue;
+		}
+
+		if (result == 0)
+			continue;
+
+		if (va_bits > 0 && va_bits < 64 && (access.address >> va_bits) != 0)
+		{
+			dropped++;
+			continue;
+		}
+
+		if (binary_trace_append(writer, access.address, access.is_write, access.size) < 0)
+		{
+			printf("%s - Failed Writing %s...\n", ERROR_PRINT_TAG, output_path);
+			close_binary_trace_writer(writer);
+			return 1;
+		}
+	}
+
+	if (close_binary_trace_writer(writer) < 0)
+	{
+		printf("%s - Failed Writing %s...\n", ERROR_PRINT_TAG, output_path);
+		return 1;
+	}
+
+	/* Read back, which also checks the index */
+	binary_trace_t* trace = open_binary_trace(output_path);
+
+	if (!trace)
+		return 1;
+
+	printf("%s - Wrote %s: %'lu Lines, %'lu Skipped, %'lu Outside %d Address Bits\n", FILEIO_PRINT_TAG, output_path, line_number, skipped, dropped, va_bits);
+	print_binary_trace_header(&trace->header);
+	free_binary_trace(trace);
+
+	return 0;
+}
+
+static int decode_trace (const char* input_path, const char* output_path)
+{
+	binary_trace_t* trace = open_binary_trace(input_path);
+
+	if (!trace)
+		return 1;
+
+	FILE* output = (strcmp(output_path, "-") == 0) ? stdout : fopen(output_path, "w");
+
+	if (!output)
+	{
+		printf("%s - Failed To Create %s...\n", ERROR_PRINT_TAG, output_path);
+		free_binary_trace(trace);
+		return 1;
+	}
+
+	trace_entry_t* entries = malloc(trace->header.block_entries * sizeof(trace_entry_t));
+	int result = 0;
+
+	for (ullong_t block = 0; block < trace->header.block_count; ++block)
+	{
+		unsigned long count = binary_trace_read_block(trace, block, entries);
+
+		if (count == 0)
+		{
+			result = 1;
+			break;
+		}
+
+		for (unsigned long i = 0; i < count; ++i)
+			fprintf(output, "%llX %c\n", (ullong_t) entries[i].address, entries[i].is_write ? 'W' : 'R');
+	}
+
+	if (output != stdout)
+		fclose(output);
+
+	free(entries);
+	free_binary_trace(trace);
+
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	int format = INPUT_TEXT;
+	uint_t block_entries = TRACE_BLOCK_ENTRIES;
+	int va_bits = 0;
+	int option;
+
+	while ((option = getopt(argc, argv, "f:b:V:")) != -1)
+	{
+		switch (option)
+		{
+			case 'f':
+				if (strcmp(optarg, "text") == 0)
+					format = INPUT_TEXT;
+				else if (strcmp(optarg, "lackey") == 0)
+					format = INPUT_LACKEY;
+				else if (strcmp(optarg, "perf") == 0)
+					format = INPUT_PERF;
+				else
+				{
+					printf("%s - Unknown Trace Format: %s [text, lackey, perf]\n", ERROR_PRINT_TAG, optarg);
+					return 1;
+				}
+
+				break;
+			case 'b':
+				block_entries = strtoul(optarg, NULL, 0);
+				break;
+			case 'V':
+				va_bits = atoi(optarg);
+				break;
+			default:
+				optind = argc + 1;
+				break;
+		}
+	}
+
+	if (argc - optind != 2 || block_entries == 0 || block_entries > (uint_t) TRACE_MAX_BLOCK_ENTRIES)
+	{
+		printf("Usage: %s [-f text|lackey|perf] [-b block_entries] [-V va_bits] <input> <output>\n", argv[0]);
+		return 1;
+	}
+
+	setlocale(LC_NUMERIC, "");
+
+	const char* input_path = argv[optind];
+	const char* output_path = argv[optind + 1];
+
+	if (is_binary_trace_file(input_path))
+		return decode_trace(input_path, output_path);
+
+	FILE* input = (strcmp(input_path, "-") == 0) ? stdin : fopen(input_path, "r");
+
+	if (!input)
+	{
+		printf("%s - Failed To Open Trace File...\n", ERROR_PRINT_TAG);
+		return 1;
+	}
+
+	int result = encode_trace(input, format, output_path, block_entries, va_bits);
+
+	if (input != stdin)
+		fclose(input);
+
+	return result;
+}
@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../lib/utils.h"
+#include "../lib/events.h"
+#include "../lib/constants.h"
+
+/*
+	Converts an event file written by the simulator [-E file=<path>] into
+	Chrome trace event JSON:
+
+		./export_events <events> <json>
+
+	Open the JSON in ui.perfetto.dev or chrome://tracing. Every simulated
+	process is a process of the trace & every recording thread a thread,
+	faults & evictions are spans of the host time they took, the other
+	events instants.
+*/
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: %s <events> <json>\n", argv[0]);
+		return 1;
+	}
+
+	if (export_chrome_trace(argv[1], argv[2]) < 0)
+		return 1;
+
+	printf("%s - Chrome Trace Written To: %s\n", FILEIO_PRINT_TAG, argv[2]);
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <string.h>
+#include "../lib/utils.h"
+#include "../lib/geometry.h"
+#include "../lib/page_table.h"
+#include "../lib/snapshot.h"
+#include "../lib/constants.h"
+
+/*
+	Renders a snapshot written by the simulator [-o or data/snapshot.bin]
+	as the readable tables the simulator used to write itself:
+
+		./render_snapshot <snapshot> [header|memory|tables|disk]
+
+	memory lists the bytes of every frame in use, tables every non-empty
+	page table entry per process & disk every swap page holding data.
+	Without a section everything is printed.
+*/
+
+static void render_memory (snapshot_t* snapshot)
+{
+	printf(TABLE_PHYSICAL_HEADER, "Address", "Frame", "Content");
+	printf("%s|%s|%s\r\n", "----------------", "---------------", "----------------");
+
+	for (ullong_t frame = 0; frame < geometry.frame_count; ++frame)
+	{
+		if (!snapshot_frame_used(snapshot, frame))
+			continue;
+
+		ullong_t address = frame << geometry.page_shift;
+
+		for (ullong_t i = 0; i < geometry.page_size; ++i)
+			printf(TABLE_SNAPSHOT_MEMORY, address + i, frame, snapshot->physical_memory[address + i]);
+	}
+}
+
+static void render_entry (void* context, ullong_t virtual_page_number, ullong_t frame_number, uchar_t control_bits)
+{
+	uint_t present_flag 	= ((control_bits & C_PRESENT) != 0) ? 1 : 0;
+	uint_t rw_flag 			= ((control_bits & C_READWRITE) != 0) ? 1 : 0;
+	uint_t dirty_flag 		= ((control_bits & C_DIRTY) != 0) ? 1 : 0;
+	uint_t disk_flag 		= ((control_bits & C_DISK) != 0) ? 1 : 0;
+	(void) context;
+
+	printf(TABLE_SNAPSHOT_PAGE, virtual_page_number, frame_number, present_flag, rw_flag, dirty_flag, disk_flag);
+}
+
+static void render_tables (snapshot_t* snapshot)
+{
+	for (uint_t i = 0; i < snapshot->header->table_count; ++i)
+	{
+		page_table_t* page_table = attach_snapshot_table(snapshot, i);
+
+		printf("PID %d [%s]\r\n", page_table->pid, get_page_table_name(page_table->type));
+		printf(TABLE_PAGE_HEADER, "Page", "Physical Frame", "Is Present?", "Can RW?", "Is Dirty?", "On Disk?");
+		printf("%s|%s|%s|%s|%s|%s\r\n", "--------", "-----------------------", "---------------", "---------------", "---------------", "---------");
+
+		page_table_for_each(page_table, render_entry, NULL);
+		free_page_table(page_table);
+	}
+}
+
+static void render_disk (snapshot_t* snapshot)
+{
+	printf("%-3s\t\t| %-3s\r\n", "Page", "Content");
+	printf("%s|%s\r\n", "----------------", "----------------");
+
+	for (ullong_t slot = 0; slot < geometry.disk_frame_count; ++slot)
+	{
+		char* page = snapshot->disk_memory + (slot << geometry.page_shift);
+
+		/* Unused swap slots are all zero */
+		if (page[0] == 0 && memcmp(page, page + 1, geometry.page_size - 1) == 0)
+			continue;
+
+		for (ullong_t i = 0; i < geometry.page_size; ++i)
+			printf(TABLE_SNAPSHOT_DISK, slot, page[i]);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* section = (argc > 2) ? argv[2] : "all";
+
+	if (argc < 2 || argc > 3)
+	{
+		printf("Usage: %s <snapshot> [header|memory|tables|disk]\n", argv[0]);
+		return 1;
+	}
+
+	setlocale(LC_NUMERIC, "");
+
+	snapshot_t* snapshot = map_snapshot(argv[1]);
+
+	if (!snapshot)
+		return 1;
+
+	if (configure_snapshot_geometry(snapshot, &geometry) < 0)
+	{
+		unmap_snapshot(snapshot);
+		return 1;
+	}
+
+	int all = strcmp(section, "all") == 0;
+
+	if (!all && strcmp(section, "header") != 0 && strcmp(section, "memory") != 0 && strcmp(section, "tables") != 0 && strcmp(section, "disk") != 0)
+	{
+		printf("%s - Unknown Section: %s\n", ERROR_PRINT_TAG, section);
+		unmap_snapshot(snapshot);
+		return 1;
+	}
+
+	if (all || strcmp(section, "header") == 0)
+		print_snapshot_header(snapshot);
+	if (all || strcmp(section, "memory") == 0)
+		render_memory(snapshot);
+	if (all || strcmp(section, "tables") == 0)
+		render_tables(snapshot);
+	if (all || strcmp(section, "disk") == 0)
+		render_disk(snapshot);
+
+	unmap_snapshot(snapshot);
+
+	return 0;
+}